@@ -37,6 +37,11 @@ public:
             t.GetData()->SetGenerationFlags(options);
         }
     }
+
+    TypeTree<R, V> &GetTypeTree() const
+    {
+        return m_TypeTree;
+    }
 };
 
 //
@@ -69,4 +74,16 @@ public:
             t.GetData()->SetGenerationFlags(options);
         }
     }
+
+    TypeTree<R, V> &GetTypeTree() const
+    {
+        return m_TypeTree;
+    }
+
+    // The managed instance whose fields are appended to the tree of a MonoBehaviour or ScriptableObject
+    void SetScriptingObject(void *scriptingObjectPtr, int32_t scriptingObjectSize)
+    {
+        m_ScriptingObjectPtr = static_cast<char *>(scriptingObjectPtr);
+        m_ScriptingObjectSize = scriptingObjectSize;
+    }
 };
@@ -11,6 +11,17 @@ enum ObjectCreationMode : int
     kCreateObjectDefaultNoLock
 };
 
+struct MonoObject;
+
+// Handle to a managed object, passed by value to the engine since 2017.1
+class ScriptingObjectPtr
+{
+public:
+    explicit ScriptingObjectPtr(void *target) : m_Target(target) {}
+private:
+    void *m_Target;
+};
+
 template<Revision R, Variant V>
 class Object;
 
@@ -105,10 +105,30 @@ public:
         return m_Nodes;
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return m_Nodes;
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return m_StringBuffer;
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return m_StringBuffer;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return m_ByteOffsets;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return m_ByteOffsets;
+    }
 };
 
 template<Revision R, Variant V>
@@ -156,10 +176,30 @@ public:
         return m_Nodes;
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return m_Nodes;
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return m_StringBuffer;
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return m_StringBuffer;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return m_ByteOffsets;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return m_ByteOffsets;
+    }
 };
 
 DEFINE_REVISION(class, TypeTree, Revision::V2019_1_0)
@@ -183,10 +223,30 @@ public:
         return GetData()->Nodes();
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return GetData()->Nodes();
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return GetData()->StringsBuffer();
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return GetData()->StringsBuffer();
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return GetData()->ByteOffsets();
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return GetData()->ByteOffsets();
+    }
 };
 
 DEFINE_REVISION(struct, TypeTreeNode, Revision::V2019_1_0)
@@ -258,10 +318,30 @@ public:
         return m_Nodes;
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return m_Nodes;
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return m_StringBuffer;
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return m_StringBuffer;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return m_ByteOffsets;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return m_ByteOffsets;
+    }
 };
 
 //
@@ -290,10 +370,30 @@ public:
         return GetData()->Nodes();
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return GetData()->Nodes();
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return GetData()->StringsBuffer();
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return GetData()->StringsBuffer();
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return GetData()->ByteOffsets();
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return GetData()->ByteOffsets();
+    }
 };
 
 //
@@ -334,8 +434,48 @@ public:
         return m_Nodes;
     }
 
+    dynamic_array<R, V>::template type<TypeTreeNode<R, V>> &Nodes()
+    {
+        return m_Nodes;
+    }
+
     dynamic_array<R, V>::template type<char> const &StringsBuffer() const
     {
         return m_StringBuffer;
     }
+
+    dynamic_array<R, V>::template type<char> &StringsBuffer()
+    {
+        return m_StringBuffer;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> const &ByteOffsets() const
+    {
+        return m_ByteOffsets;
+    }
+
+    dynamic_array<R, V>::template type<uint32_t> &ByteOffsets()
+    {
+        return m_ByteOffsets;
+    }
+
+    dynamic_array<R, V>::template type<uint8_t> const &Levels() const
+    {
+        return m_Levels;
+    }
+
+    dynamic_array<R, V>::template type<uint8_t> &Levels()
+    {
+        return m_Levels;
+    }
+
+    dynamic_array<R, V>::template type<int32_t> const &NextIndex() const
+    {
+        return m_NextIndex;
+    }
+
+    dynamic_array<R, V>::template type<int32_t> &NextIndex()
+    {
+        return m_NextIndex;
+    }
 };
@@ -14,12 +14,14 @@
 #include <link.h>
 #include <linux/elf.h>
 #include <dlfcn.h>
+#include <unistd.h>
 
 #include "dobby.h"
 
 #include "common.hpp"
 #include "executable.hpp"
 #include "dumper.hpp"
+#include "resident_set_size.hpp"
 
 template<Revision R, Variant V>
 class AndroidDumper
@@ -72,7 +74,7 @@ public:
         return CachedSections;
     }
 
-    static std::ofstream CreateOutputFile(char const *filename)
+    static OutputFile CreateOutputFile(char const *filename)
     {
         // On Android, we have to output our files into /data/data/<app package name>/files so that they are retrievable later.
         const auto packageName = []
@@ -85,13 +87,18 @@ public:
 
         const auto outputDirectory = std::filesystem::path("/data/data") / packageName / "files";
         const auto outputPath = outputDirectory / filename;
-        return std::ofstream(outputPath, std::ios::out | std::ios::binary);
+        return OutputFile(outputPath);
     }
 
     static void DebugLog(char const *message)
     {
         __android_log_print(ANDROID_LOG_DEBUG, "TypeTreeRipper", "%s", message);
     }
+
+    static uint64_t GetResidentSetSize()
+    {
+        return ReadResidentSetSize();
+    }
 private:
     std::vector<ExecutableSection> CachedSections;
 };
@@ -0,0 +1,3336 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <spanstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#undef max
+
+#include "block_compression.hpp"
+#include "checksum.hpp"
+#include "columnar_format.hpp"
+#include "hash_algorithms.hpp"
+#include "output_buffer.hpp"
+
+//
+// .ttbin binary layout:
+// TypeTreeHeader
+// TypeTreeStringTable (only with kHeaderFlagStringTable)
+// CommonStringBuffer (only with kHeaderFlagCommonStrings)
+// TypeTreeSubtree[SubtreeCount] (only with kHeaderFlagSubtreeReferences)
+// TypeTreeRTTI[RTTITableCount] (only with kHeaderFlagTreeSets)
+// TypeTreeRTTI[RTTICount] (or an index into the RTTI table, with the trees grouped into sets, see kHeaderFlagTreeSets)
+// TypeTreeNode[NodesCount] (or a referenced tree index, see kHeaderFlagTreeReferences, or a TypeTreeSubtree
+// with kHeaderFlagSubtreeReferences)
+// TypeTreeSection[] (optional, until end of file)
+// TypeTreeSection holding the checksums (only with kHeaderFlagChecksums, always last)
+//
+// Version 3 files use the columnar layout described in columnar_format.hpp instead, and version 4 files hold
+// a file of another version in compressed blocks as described in block_compression.hpp.
+//
+
+struct DumpedTypeTreeHeader
+{
+    // 'TYPETREE' in little-endian
+    static constexpr auto kDefaultMagic = 0x4545525445505954;
+
+    // Version 2 adds the header flags. Writers only emit version 2 when a flag is set,
+    // so that files without any optional encoding remain readable by version 1 readers.
+    static constexpr uint32_t kVersion1 = 1;
+    static constexpr uint32_t kVersion2 = 2;
+
+    // Version 3 replaces everything after the version with the columnar layout, see columnar_format.hpp.
+    // It is only written when asked for.
+    static constexpr uint32_t kVersion3 = 3;
+
+    // Version 4 holds a file of another version in independently compressed blocks, see block_compression.hpp.
+    // It is only written when asked for.
+    static constexpr uint32_t kVersion4 = 4;
+
+    uint64_t Magic;
+    uint32_t Version;
+
+    // Revision
+    uint16_t MajorRevision;
+    uint8_t MinorRevision;
+    uint8_t PatchRevision;
+
+    std::string Variant;
+
+    enum Flags : uint32_t
+    {
+        // Every type tree is followed by a referenced tree index, replacing its nodes when set
+        kHeaderFlagTreeReferences = 1 << 0,
+
+        // Node type and name strings are stored once in a string table following the header,
+        // and nodes refer to them by their index in the table
+        kHeaderFlagStringTable = 1 << 1,
+
+        // The engine's common string buffer follows the string table, and nodes carry the offsets of
+        // the type and name strings the engine took from it
+        kHeaderFlagCommonStrings = 1 << 2,
+
+        // Nodes carry the offset of their data from the start of the object's data, see DumpedTypeTreeNode::ByteOffset
+        kHeaderFlagByteOffsets = 1 << 3,
+
+        // Nodes carry the index of their parent and next sibling and the size of their subtree
+        kHeaderFlagNavigation = 1 << 4,
+
+        // Nodes carry a structural hash of their subtree, see ComputeSubtreeHashes
+        kHeaderFlagSubtreeHashes = 1 << 5,
+
+        // Every type tree carries Unity's legacy type hash and a 64-bit hash of its nodes, see ComputeTypeHashes
+        kHeaderFlagTypeHashes = 1 << 6,
+
+        // Subtrees occurring more than once are stored once in a pool following the common string buffer, and
+        // node arrays refer to them, see DumpedTypeTreeSubtreeDeduplicator
+        kHeaderFlagSubtreeReferences = 1 << 7,
+
+        // The RTTI of the trees and scripts is stored once in a table following the subtree pool, and they are
+        // grouped into sets of consecutive trees with the same transfer flags, see DumpedTypeTreeSet
+        kHeaderFlagTreeSets = 1 << 8,
+
+        // The file ends with a section holding the CRC32C of the trees and of every other section, see
+        // DumpedTypeTreeRegionChecksum. Version 3 files keep the CRC32C of every section in the section table instead.
+        kHeaderFlagChecksums = 1 << 9,
+    };
+    std::underlying_type_t<Flags> Flags = 0;
+};
+
+struct DumpedTypeTreeRTTI
+{
+    static constexpr auto kInvalid = std::numeric_limits<uint32_t>::max();
+
+    std::string ClassName;
+    std::string ClassNamespace;
+    std::string Module;
+    int32_t PersistentTypeID;
+    int32_t Size;
+
+    enum Flags : uint32_t
+    {
+        kRTTIFlagIsAbstract = 1 << 0,
+        kRTTIFlagIsSealed = 1 << 1,
+        kRTTIFlagIsEditorOnly = 1 << 2,
+        kRTTIFlagIsStripped = 1 << 3,
+        kRTTIFlagIsDeprecated  = 1 << 4,
+    };
+    std::underlying_type_t<Flags> Flags;
+
+    uint32_t BasePersistentTypeID = kInvalid;
+    uint32_t DerivedFromTypeIndex = kInvalid;
+    uint32_t DerivedFromDescendantCount = kInvalid;
+
+    bool operator==(const DumpedTypeTreeRTTI &) const = default;
+};
+
+// FNV-1a over the bytes of a node string, the string hash ComputeSubtreeHashes builds on
+inline uint64_t HashTypeTreeString(const std::string_view value)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const auto c : value)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+//
+// Pool of the distinct node type and name strings, which nodes refer to by index. Every string is copied
+// into the pool once, no matter how many nodes use it.
+//
+
+class DumpedTypeTreeStringTable
+{
+public:
+    uint32_t Intern(const std::string_view value)
+    {
+        if (const auto it = IDs.find(value); it != IDs.end())
+            return it->second;
+
+        const auto stored = Store(value);
+        const auto id = static_cast<uint32_t>(Strings.size());
+
+        Strings.push_back(stored);
+        Hashes.push_back(HashTypeTreeString(stored));
+        IDs.emplace(stored, id);
+        return id;
+    }
+
+    std::string_view Get(const uint32_t id) const
+    {
+        return Strings[id];
+    }
+
+    // HashTypeTreeString of the string, computed once when it is interned
+    uint64_t GetHash(const uint32_t id) const
+    {
+        return Hashes[id];
+    }
+
+    size_t Size() const
+    {
+        return Strings.size();
+    }
+
+    const std::vector<std::string_view> &GetStrings() const
+    {
+        return Strings;
+    }
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    // Strings are copied into large blocks that never move, so that views of them stay valid
+    std::string_view Store(const std::string_view value)
+    {
+        if (Blocks.empty() || BlockUsed + value.size() > kBlockSize)
+        {
+            Blocks.push_back(std::make_unique<char[]>(std::max(kBlockSize, value.size())));
+            BlockUsed = 0;
+        }
+
+        const auto data = Blocks.back().get() + BlockUsed;
+        std::ranges::copy(value, data);
+        BlockUsed += value.size();
+
+        return { data, value.size() };
+    }
+
+    std::vector<std::unique_ptr<char[]>> Blocks;
+    size_t BlockUsed = 0;
+
+    std::vector<std::string_view> Strings;
+    std::vector<uint64_t> Hashes;
+    std::unordered_map<std::string_view, uint32_t> IDs;
+};
+
+struct DumpedTypeTreeNode
+{
+    // Indices into the string table of the binary the node belongs to
+    uint32_t TypeStringID;
+    uint32_t NameStringID;
+
+    enum Flags : uint32_t
+    {
+        kNodeFlagIsArray = 1 << 0,
+        kNodeFlagIsManagedReference = 1 << 1,
+        kNodeFlagIsManagedReferenceRegistry = 1 << 2,
+        kNodeFlagIsArrayOfRefs = 1 << 3,
+    };
+    std::underlying_type_t<Flags> Flags;
+    int32_t ByteSize;
+    int32_t Index;
+
+    int16_t Version;
+    uint8_t Level;
+
+    enum MetaFlags : uint32_t
+    {
+        kNodeMetaFlagHideInEditor = 1 << 0,
+        // ?
+        // ?
+        // ?
+        kNodeMetaFlagNotEditable = 1 << 4,
+        kNodeMetaFlagReorderable = 1 << 5,
+        kNodeMetaFlagStrongPPtr = 1 << 6,
+        // ?
+        kNodeMetaFlagTreatIntegerValueAsBoolean = 1 << 8,
+        // ?
+        // ?
+        kNodeMetaFlagSimpleEditor = 1 << 11,
+        kNodeMetaFlagDebugProperty = 1 << 12,
+        // ?
+        kNodeMetaFlagAlignBytes = 1 << 14,
+        kNodeMetaFlagAnyChildUsesAlignBytes = 1 << 15,
+        kNodeMetaFlagIgnoreWithInspectorUndo = 1 << 16,
+        // ?
+        kNodeMetaFlagEditorDisplaysCharacterMap = 1 << 18,
+        kNodeMetaFlagIgnoreInMetaFiles = 1 << 19,
+        kNodeMetaFlagTransferAsArrayEntryNameInMetaFiles = 1 << 20,
+        kNodeMetaFlagTransferUsingFlowMappingStyle = 1 << 21,
+        kNodeMetaFlagGenerateBitwiseDifferences = 1 << 22,
+        kNodeMetaFlagDontAnimate = 1 << 23,
+        kNodeMetaFlagTransferHex64 = 1 << 24,
+        kNodeMetaFlagCharProperty = 1 << 25,
+        kNodeMetaFlagDontValidateUTF8 = 1 << 26,
+        kNodeMetaFlagFixedBuffer = 1 << 27,
+        kNodeMetaFlagDisallowSerializedPropertyModification = 1 << 28
+    };
+    std::underlying_type_t<MetaFlags> MetaFlags;
+    uint64_t RefTypeHash;
+
+    // Offsets into the common string buffer, for strings the engine referred to there rather than in the tree's
+    // own string buffer. Only stored with kHeaderFlagCommonStrings.
+    static constexpr auto kNotCommonString = std::numeric_limits<uint32_t>::max();
+    uint32_t TypeCommonOffset = kNotCommonString;
+    uint32_t NameCommonOffset = kNotCommonString;
+
+    // Only stored with kHeaderFlagByteOffsets. Known without reading the data for nodes only preceded by fixed size
+    // data, kNoByteOffset for the others, see HasStaticByteOffset.
+    static constexpr auto kNoByteOffset = std::numeric_limits<uint32_t>::max();
+    uint32_t ByteOffset = kNoByteOffset;
+
+    // Only stored with kHeaderFlagNavigation, readers compute them for files without it. The root has no parent,
+    // and the last child of a node no next sibling.
+    static constexpr auto kNoNode = std::numeric_limits<uint32_t>::max();
+    uint32_t ParentIndex = kNoNode;
+    uint32_t NextSiblingIndex = kNoNode;
+
+    // Number of nodes in the subtree including the node itself, so the subtree ends at the node's index plus this count
+    uint32_t SubtreeNodeCount = 1;
+
+    // Only stored with kHeaderFlagSubtreeHashes, readers compute it for files without it
+    uint64_t SubtreeHash = 0;
+
+    bool HasStaticByteOffset() const
+    {
+        return ByteOffset != kNoByteOffset;
+    }
+
+    bool operator==(const DumpedTypeTreeNode &) const = default;
+};
+
+enum DumpedTransferInstructionFlags : uint64_t
+{
+    kTransferFlagReadWriteFromSerializedFile = 1 << 0,
+    kTransferFlagAssetMetaDataOnly = 1 << 1,
+    kTransferFlagHandleDrivenProperties = 1 << 2,
+    kTransferFlagLoadAndUnloadAssetsDuringBuild = 1 << 3,
+    kTransferFlagSerializeDebugProperties = 1 << 4,
+    kTransferFlagIgnoreDebugPropertiesForIndex = 1 << 5,
+    kTransferFlagBuildPlayerOnlySerializeBuildProperties = 1 << 6,
+    kTransferFlagIsCloningObject = 1 << 7,
+    kTransferFlagSerializeGameRelease = 1 << 8,
+    kTransferFlagSwapEndianness = 1 << 9,
+    kTransferFlagResolveStreamedResourceSources = 1 << 10,
+    kTransferFlagDontReadObjectsFromDiskBeforeWriting = 1 << 11,
+    kTransferFlagSerializeMonoReload = 1 << 12,
+    kTransferFlagDontRequireAllMetaFlags = 1 << 13,
+    kTransferFlagSerializeForPrefabSystem = 1 << 14,
+    kTransferFlagSerializeForSlimPlayer = 1 << 15,
+    kTransferFlagLoadPrefabAsScene = 1 << 16,
+    kTransferFlagSerializeCopyPasteTransfer = 1 << 17,
+    kTransferFlagSkipSerializeToTempFile = 1 << 18,
+    kTransferFlagBuildResourceImage = 1 << 19,
+    kTransferFlagDontWriteUnityVersion = 1 << 20,
+    kTransferFlagSerializeEditorMinimalScene = 1 << 21,
+    kTransferFlagGenerateBakedPhysixMeshes = 1 << 22,
+    kTransferFlagThreadedSerialization = 1 << 23,
+    kTransferFlagIsBuiltinResourcesFile = 1 << 24,
+    kTransferFlagPerformUnloadDependencyTracking = 1 << 25,
+    kTransferFlagDisableWriteTypeTree = 1 << 26,
+    kTransferFlagAutoreplaceEditorWindow = 1 << 27,
+    kTransferFlagDontCreateMonoBehaviorScriptWrapper = 1 << 28,
+    kTransferFlagSerializeForInspector = 1 << 29,
+    kTransferFlagSerializedAssetBundleVersion = 1 << 30,
+    kTransferFlagAllowTextSerialization = 1LL << 31,
+    kTransferFlagIgnoreSerializeReferenceMissingType = 1LL << 32,
+    kTransferFlagDontUpdateTransformRootOrderOnTypes = 1LL << 33,
+    kTransferFlagSerializingForDevelopmentBuild = 1LL << 34,
+    kTransferFlagSerializingFQN = 1LL << 35
+};
+
+// A shared subtree used at one position of a node array. The root's positional fields depend on where the subtree
+// is used and are stored here, the other nodes' are stored relative to the root.
+struct DumpedTypeTreeSubtreeReference
+{
+    // Index of the subtree in the subtree pool
+    uint32_t Subtree;
+
+    // Index of the subtree's root in the expanded node array
+    uint32_t Position;
+
+    uint8_t Level;
+    int32_t Index;
+    uint32_t ByteOffset = DumpedTypeTreeNode::kNoByteOffset;
+    uint32_t ParentIndex = DumpedTypeTreeNode::kNoNode;
+    uint32_t NextSiblingIndex = DumpedTypeTreeNode::kNoNode;
+};
+
+// A node array with some of its subtrees replaced by references to shared subtrees, see kHeaderFlagSubtreeReferences.
+// Shared subtrees are stored the same way, rebased so that their root is at level 0 and index 0.
+struct DumpedTypeTreeSubtree
+{
+    // Number of nodes once the references are expanded
+    uint32_t NodeCount = 0;
+
+    // The nodes stored in place, in order, and the references in position order
+    std::vector<DumpedTypeTreeNode> Nodes;
+    std::vector<DumpedTypeTreeSubtreeReference> References;
+};
+
+struct DumpedTypeTree
+{
+    static constexpr auto kNoReferencedTree = std::numeric_limits<uint32_t>::max();
+
+    DumpedTypeTreeRTTI RTTI;
+    std::underlying_type_t<DumpedTransferInstructionFlags> TransferFlags;
+
+    // Index of an earlier, identical tree of the same type dumped with other transfer flags.
+    // The nodes are only stored with the referenced tree, readers resolve the reference when loading.
+    uint32_t ReferencedTree = kNoReferencedTree;
+
+    // Only stored with kHeaderFlagTypeHashes, readers compute them for files without it
+    std::array<uint8_t, 16> OldTypeHash{};
+    uint64_t TypeHash = 0;
+
+    std::vector<DumpedTypeTreeNode> Nodes;
+
+    // Only set by readers leaving subtree references in place, in which case Nodes stays empty,
+    // see ExpandSubtreeReferences
+    DumpedTypeTreeSubtree CompactNodes;
+};
+
+//
+// Computes the byte offsets of the nodes preceded only by fixed size data, for trees the engine did not
+// compute them for. Offsets stop being known at the first array or variable sized leaf, and advance over
+// the padding after every node aligning its end to 4 bytes.
+//
+
+inline void ComputeStaticByteOffsets(const std::span<DumpedTypeTreeNode> nodes)
+{
+    // Levels of the composite nodes enclosing the current node, and whether they align their end
+    std::vector<std::pair<uint8_t, bool>> enclosing;
+    uint32_t offset = 0;
+    bool offsetKnown = true;
+
+    const auto align = [&offset]
+    {
+        offset = (offset + 3) & ~3u;
+    };
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        auto &node = nodes[i];
+
+        while (!enclosing.empty() && enclosing.back().first >= node.Level)
+        {
+            if (enclosing.back().second)
+                align();
+
+            enclosing.pop_back();
+        }
+
+        node.ByteOffset = offsetKnown ? offset : DumpedTypeTreeNode::kNoByteOffset;
+
+        const auto alignsEnd = (node.MetaFlags & DumpedTypeTreeNode::kNodeMetaFlagAlignBytes) != 0;
+        const auto hasChildren = i + 1 < nodes.size() && nodes[i + 1].Level > node.Level;
+
+        if (node.Flags & DumpedTypeTreeNode::kNodeFlagIsArray)
+        {
+            offsetKnown = false;
+        }
+        else if (hasChildren)
+        {
+            enclosing.emplace_back(node.Level, alignsEnd);
+        }
+        else
+        {
+            if (node.ByteSize < 0)
+                offsetKnown = false;
+            else
+                offset += static_cast<uint32_t>(node.ByteSize);
+
+            if (alignsEnd)
+                align();
+        }
+    }
+}
+
+namespace node_navigation_details
+{
+    // Links every node to its parent and next sibling by following the chains of siblings. Returns false when
+    // a subtree extends past the end of its parent.
+    inline bool LinkNodes(const std::span<DumpedTypeTreeNode> nodes)
+    {
+        const auto data = nodes.data();
+        const auto count = static_cast<uint32_t>(nodes.size());
+
+        // The last round links the top level nodes, as the children of a parent spanning the whole tree
+        for (uint32_t i = 0; i <= count; i++)
+        {
+            const auto parent = i < count ? i : DumpedTypeTreeNode::kNoNode;
+            const auto end = i < count ? i + data[i].SubtreeNodeCount : count;
+
+            for (auto child = i < count ? i + 1 : 0; child < end;)
+            {
+                const auto next = child + data[child].SubtreeNodeCount;
+                if (next > end)
+                    return false;
+
+                data[child].ParentIndex = parent;
+                data[child].NextSiblingIndex = next < end ? next : DumpedTypeTreeNode::kNoNode;
+                child = next;
+            }
+        }
+
+        return true;
+    }
+
+    inline bool SetSubtreeNodeCounts(const std::span<DumpedTypeTreeNode> nodes, const std::span<const int32_t> nextIndex)
+    {
+        if (nextIndex.size() != nodes.size())
+            return false;
+
+        const auto data = nodes.data();
+        const auto next = nextIndex.data();
+        const auto count = static_cast<int64_t>(nodes.size());
+
+        for (int64_t i = 0; i < count; i++)
+        {
+            const auto end = next[i] >= 0 ? int64_t{ next[i] } : count;
+            if (end <= i || end > count)
+                return false;
+
+            data[i].SubtreeNodeCount = static_cast<uint32_t>(end - i);
+        }
+
+        return true;
+    }
+
+    inline void ComputeSubtreeNodeCounts(const std::span<DumpedTypeTreeNode> nodes)
+    {
+        const auto data = nodes.data();
+        const auto count = nodes.size();
+
+        // Indices of the nodes whose subtree is still open, at most one per node
+        const auto openStorage = std::make_unique_for_overwrite<size_t[]>(count + 1);
+        const auto open = openStorage.get();
+        size_t openCount = 0;
+
+        for (size_t i = 0; i <= count; i++)
+        {
+            while (openCount != 0 && (i == count || data[open[openCount - 1]].Level >= data[i].Level))
+            {
+                openCount--;
+                data[open[openCount]].SubtreeNodeCount = static_cast<uint32_t>(i - open[openCount]);
+            }
+
+            open[openCount++] = i;
+        }
+    }
+}
+
+//
+// Fills in the parent, next sibling and subtree size of every node. The engine's m_NextIndex, which holds the
+// index of the first node after each node's subtree or -1 at the end of the tree, is used when it is consistent,
+// and the subtrees are derived from the node levels otherwise.
+//
+
+inline void ComputeNodeNavigation(const std::span<DumpedTypeTreeNode> nodes, const std::span<const int32_t> nextIndex = {})
+{
+    using namespace node_navigation_details;
+
+    if (SetSubtreeNodeCounts(nodes, nextIndex) && LinkNodes(nodes))
+        return;
+
+    ComputeSubtreeNodeCounts(nodes);
+    LinkNodes(nodes);
+}
+
+//
+// Structural 64-bit hash of every node's subtree, equal for subtrees with equal strings, fields and children
+// regardless of where they appear, so that tools can compare subtrees across files without walking them.
+// All values are combined as unsigned 64-bit integers, starting from 0:
+//
+// Combine(hash, value) = hash' = (hash ^ value) * 0x9E3779B97F4A7C15, then hash' ^ (hash' >> 32)
+//
+// The values are, in order:
+// FNV-1a 64 (offset basis 0xcbf29ce484222325, prime 0x100000001b3) over the bytes of the type string
+// FNV-1a 64 over the bytes of the name string
+// Flags | (uint32 ByteSize << 32)
+// uint16 Version | (MetaFlags << 32)
+// RefTypeHash
+// the number of children
+// the subtree hash of every child, in order
+//
+// Index, Level and the other positional values are left out. The hashes are computed bottom-up in one pass
+// and need the subtree sizes, see ComputeNodeNavigation.
+//
+
+namespace subtree_hash_details
+{
+    constexpr uint64_t Combine(uint64_t hash, const uint64_t value)
+    {
+        hash = (hash ^ value) * 0x9E3779B97F4A7C15;
+        return hash ^ (hash >> 32);
+    }
+}
+
+// Hashes a single node from its fields and the hashes of its children
+inline uint64_t HashSubtree(const std::span<const DumpedTypeTreeNode> nodes, const size_t index, const DumpedTypeTreeStringTable &strings)
+{
+    using subtree_hash_details::Combine;
+
+    const auto &node = nodes[index];
+
+    auto hash = Combine(0, strings.GetHash(node.TypeStringID));
+    hash = Combine(hash, strings.GetHash(node.NameStringID));
+    hash = Combine(hash, node.Flags | uint64_t{ static_cast<uint32_t>(node.ByteSize) } << 32);
+    hash = Combine(hash, static_cast<uint16_t>(node.Version) | uint64_t{ node.MetaFlags } << 32);
+    hash = Combine(hash, node.RefTypeHash);
+
+    const auto end = index + node.SubtreeNodeCount;
+
+    uint64_t childCount = 0;
+    for (auto child = index + 1; child < end; child += nodes[child].SubtreeNodeCount)
+    {
+        childCount++;
+    }
+
+    hash = Combine(hash, childCount);
+    for (auto child = index + 1; child < end; child += nodes[child].SubtreeNodeCount)
+    {
+        hash = Combine(hash, nodes[child].SubtreeHash);
+    }
+
+    return hash;
+}
+
+inline void ComputeSubtreeHashes(const std::span<DumpedTypeTreeNode> nodes, const DumpedTypeTreeStringTable &strings)
+{
+    // Children follow their parent, so walking backwards hashes every child before its parent
+    for (auto i = nodes.size(); i-- > 0;)
+    {
+        nodes[i].SubtreeHash = HashSubtree(nodes, i, strings);
+    }
+}
+
+//
+// Computes the two hashes identifying a whole tree:
+//
+// OldTypeHash is Unity's legacy type hash (CalculateOldTypeHash), the MD4 of the type and name bytes of every
+// node without terminators, each followed by its ByteSize, Flags,
+// Version (sign extended) and MetaFlags & kNodeMetaFlagDebugProperty as little-endian uint32.
+//
+// TypeHash is the 64-bit XXH3 (seed 0) of every node's type and name bytes, each with a terminating 0, followed
+// by its Flags, ByteSize, Index, Version, Level, MetaFlags and
+// RefTypeHash in their stored little-endian sizes. Unlike OldTypeHash it covers every field of the nodes.
+//
+
+namespace type_hash_details
+{
+    template<typename T>
+    void Append(std::vector<uint8_t> &buffer, const T value)
+    {
+        const auto offset = buffer.size();
+        buffer.resize(offset + sizeof(value));
+        std::memcpy(buffer.data() + offset, &value, sizeof(value));
+    }
+
+    inline void Append(std::vector<uint8_t> &buffer, const std::string_view value)
+    {
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+}
+
+inline void ComputeTypeHashes(DumpedTypeTree &tree, const DumpedTypeTreeStringTable &strings)
+{
+    using type_hash_details::Append;
+
+    std::vector<uint8_t> oldHashInput;
+    std::vector<uint8_t> hashInput;
+
+    for (const auto &node : tree.Nodes)
+    {
+        const auto type = strings.Get(node.TypeStringID);
+        const auto name = strings.Get(node.NameStringID);
+
+        Append(oldHashInput, type);
+        Append(oldHashInput, name);
+        Append(oldHashInput, static_cast<uint32_t>(node.ByteSize));
+        Append(oldHashInput, node.Flags);
+        Append(oldHashInput, static_cast<uint32_t>(node.Version));
+        Append(oldHashInput, node.MetaFlags & DumpedTypeTreeNode::kNodeMetaFlagDebugProperty);
+
+        Append(hashInput, type);
+        Append(hashInput, uint8_t{});
+        Append(hashInput, name);
+        Append(hashInput, uint8_t{});
+        Append(hashInput, node.Flags);
+        Append(hashInput, node.ByteSize);
+        Append(hashInput, node.Index);
+        Append(hashInput, node.Version);
+        Append(hashInput, node.Level);
+        Append(hashInput, node.MetaFlags);
+        Append(hashInput, node.RefTypeHash);
+    }
+
+    tree.OldTypeHash = CalculateMd4(oldHashInput);
+    tree.TypeHash = CalculateXxh3_64(hashInput);
+}
+
+//
+// Replaces trees with a reference to an earlier identical tree of the same persistent type ID under
+// different transfer flags. Release and editor trees are identical for most types, so editor dumps
+// only store those nodes once.
+//
+
+class DumpedTypeTreeDeduplicator
+{
+public:
+    // Deduplicates the last tree against the trees before it
+    void AddLast(std::vector<DumpedTypeTree> &trees)
+    {
+        auto &tree = trees.back();
+        if (tree.Nodes.empty())
+            return;
+
+        // The root's subtree hash covers the whole tree, positional fields are compared with the nodes
+        const auto hash = tree.Nodes[0].SubtreeHash;
+        auto &candidates = CandidatesByTypeID[tree.RTTI.PersistentTypeID];
+
+        for (const auto &[candidateHash, candidateIndex] : candidates)
+        {
+            const auto &candidate = trees[candidateIndex];
+
+            if (candidateHash == hash && candidate.TransferFlags != tree.TransferFlags && candidate.Nodes == tree.Nodes)
+            {
+                tree.ReferencedTree = candidateIndex;
+                tree.Nodes = {};
+                HasReferences = true;
+                return;
+            }
+        }
+
+        candidates.emplace_back(hash, static_cast<uint32_t>(trees.size() - 1));
+    }
+
+    uint32_t GetHeaderFlags() const
+    {
+        return HasReferences ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagTreeReferences) : 0;
+    }
+private:
+    std::unordered_map<int32_t, std::vector<std::pair<uint64_t, uint32_t>>> CandidatesByTypeID;
+    bool HasReferences = false;
+};
+
+// Deduplicates trees whose references were resolved when reading them, finding the references the writer found.
+// Returns the header flags to store them with.
+inline uint32_t DeduplicateTypeTrees(std::vector<DumpedTypeTree> &trees)
+{
+    DumpedTypeTreeDeduplicator deduplicator;
+    std::vector<DumpedTypeTree> deduplicated;
+    deduplicated.reserve(trees.size());
+
+    for (auto &tree : trees)
+    {
+        deduplicated.push_back(std::move(tree));
+        deduplicator.AddLast(deduplicated);
+    }
+
+    trees = std::move(deduplicated);
+    return deduplicator.GetHeaderFlags();
+}
+
+//
+// Optional sections are appended after the type trees. Readers skip any section they do not recognize,
+// so adding a new section kind does not require bumping the version.
+//
+
+struct DumpedTypeTreeSectionHeader
+{
+    enum Tag : uint32_t
+    {
+        // 'SHRD' in little-endian
+        kSectionShard = 0x44524853,
+
+        // 'SCRP' in little-endian
+        kSectionScripts = 0x50524353,
+
+        // 'SBLB' in little-endian
+        kSectionSerializedBlobs = 0x424C4253,
+
+        // 'HIER' in little-endian
+        kSectionHierarchy = 0x52454948,
+
+        // 'CRCS' in little-endian
+        kSectionChecksums = 0x53435243,
+    };
+    std::underlying_type_t<Tag> Tag;
+
+    // Size of the section payload in bytes, excluding this header
+    uint32_t Size;
+};
+
+// The checksum section holds DumpedTypeTreeRegionChecksum[Count] followed by uint32_t Count, so that readers find it
+// from the end of the file and check everything before parsing it. The regions cover the file up to the checksum
+// section: first the header and the type trees, then every section with its header.
+struct DumpedTypeTreeRegionChecksum
+{
+    // The tag of the section, or 0 for the header and the type trees
+    uint32_t Tag;
+    uint32_t Checksum;
+    uint64_t Size;
+};
+static_assert(sizeof(DumpedTypeTreeRegionChecksum) == 16);
+
+struct DumpedTypeTreeShard
+{
+    // The range of RuntimeTypeArray indices [TypeIndexBegin, TypeIndexEnd) dumped into this file
+    uint32_t TypeIndexBegin;
+    uint32_t TypeIndexEnd;
+
+    // RuntimeTypeArray::Count of the process the shard was dumped from
+    uint32_t TypeCount;
+};
+
+// The tree of a managed MonoBehaviour or ScriptableObject class. These are kept out of the main tree list,
+// which holds at most one tree per persistent type ID and transfer flags.
+struct DumpedTypeTreeScript
+{
+    std::string AssemblyName;
+    std::string Namespace;
+    std::string ClassName;
+
+    // m_RefTypeHash of the root node as set by the engine, or zero on revisions without it
+    uint64_t RefTypeHash;
+
+    // The native MonoBehaviour or ScriptableObject RTTI and the combined native and managed nodes
+    DumpedTypeTree Tree;
+};
+
+//
+// The type tree blobs Unity embeds in SerializedFile metadata, prebuilt for every tree so that tools writing
+// SerializedFiles can copy them verbatim. Each set holds the blobs laid out for one range of SerializedFile
+// format versions, see serialized_blob.hpp.
+//
+
+struct DumpedTypeTreeSerializedBlobs
+{
+    static constexpr auto kNoBlob = std::numeric_limits<uint32_t>::max();
+
+    // The first SerializedFile format version using this blob layout
+    uint32_t FormatVersion;
+
+    // Distinct blobs, which trees refer to by index. Trees without nodes refer to kNoBlob.
+    std::vector<std::vector<char>> Blobs;
+    std::vector<uint32_t> TypeTreeBlobs;
+    std::vector<uint32_t> ScriptBlobs;
+
+    bool operator==(const DumpedTypeTreeSerializedBlobs &) const = default;
+};
+
+//
+// The class hierarchy of the types in the file, laid out in preorder so that every type is followed by all of
+// its descendants. "Is A derived from B" and "all descendants of B" become range checks on the table indices.
+//
+
+struct DumpedTypeTreeHierarchy
+{
+    static constexpr auto kNoBase = std::numeric_limits<uint32_t>::max();
+
+    struct Type
+    {
+        int32_t PersistentTypeID;
+
+        // Table index of the base type, or kNoBase for roots and types whose base is not in the file
+        uint32_t BaseIndex;
+
+        // Number of entries following this type that derive from it
+        uint32_t DescendantCount;
+
+        // Number of bases above this type in the table
+        uint32_t Depth;
+
+        bool operator==(const Type &) const = default;
+    };
+
+    std::vector<Type> Types;
+
+    // Table index by persistent type ID, rebuilt with IndexTypes
+    std::unordered_map<int32_t, uint32_t> Indices;
+
+    void IndexTypes()
+    {
+        Indices.clear();
+        for (uint32_t i = 0; i < Types.size(); i++)
+        {
+            Indices.emplace(Types[i].PersistentTypeID, i);
+        }
+    }
+
+    std::optional<uint32_t> GetIndex(const int32_t persistentTypeID) const
+    {
+        if (const auto it = Indices.find(persistentTypeID); it != Indices.end())
+            return it->second;
+
+        return std::nullopt;
+    }
+
+    // Like the engine's IsDerivedFrom, a type counts as derived from itself
+    bool IsDerivedFrom(const uint32_t index, const uint32_t baseIndex) const
+    {
+        return index >= baseIndex && index - baseIndex <= Types[baseIndex].DescendantCount;
+    }
+
+    std::span<const Type> GetDescendants(const uint32_t index) const
+    {
+        return std::span(Types).subspan(index + 1, Types[index].DescendantCount);
+    }
+
+    // Checks that every type is followed by exactly its descendants, and that the bases and depths agree
+    static bool IsPreorder(const std::span<const Type> types)
+    {
+        // Indices of the bases whose intervals contain the current type
+        std::vector<uint32_t> bases;
+
+        for (uint32_t index = 0; index < types.size(); index++)
+        {
+            while (!bases.empty() && index - bases.back() > types[bases.back()].DescendantCount)
+                bases.pop_back();
+
+            const auto baseIndex = bases.empty() ? kNoBase : bases.back();
+            const auto end = bases.empty() ? types.size() : baseIndex + types[baseIndex].DescendantCount + 1;
+            const auto &type = types[index];
+
+            if (type.BaseIndex != baseIndex || type.DescendantCount >= end - index || type.Depth != bases.size())
+                return false;
+
+            bases.push_back(index);
+        }
+
+        return true;
+    }
+};
+
+namespace type_hierarchy_details
+{
+    // On revisions with RTTI::derivedFromInfo, the engine already numbers its types in preorder. Its numbering is
+    // used as is when the file holds every type of the RuntimeTypeArray, which is not the case for shards.
+    inline bool UseEngineOrder(const std::span<const DumpedTypeTreeRTTI *const> types, const std::span<const uint32_t> baseIndices,
+        std::vector<DumpedTypeTreeHierarchy::Type> &result)
+    {
+        std::vector<uint32_t> localIndices(types.size(), DumpedTypeTreeHierarchy::kNoBase);
+        for (uint32_t i = 0; i < types.size(); i++)
+        {
+            const auto typeIndex = types[i]->DerivedFromTypeIndex;
+            if (typeIndex >= types.size() || localIndices[typeIndex] != DumpedTypeTreeHierarchy::kNoBase)
+                return false;
+
+            localIndices[typeIndex] = i;
+        }
+
+        result.resize(types.size());
+        for (uint32_t index = 0; index < types.size(); index++)
+        {
+            const auto local = localIndices[index];
+            const auto baseLocal = baseIndices[local];
+
+            auto &type = result[index];
+            type = {
+                .PersistentTypeID = types[local]->PersistentTypeID,
+                .BaseIndex = baseLocal != DumpedTypeTreeHierarchy::kNoBase ? types[baseLocal]->DerivedFromTypeIndex : DumpedTypeTreeHierarchy::kNoBase,
+                .DescendantCount = types[local]->DerivedFromDescendantCount,
+                .Depth = 0,
+            };
+
+            if (type.BaseIndex == DumpedTypeTreeHierarchy::kNoBase)
+                continue;
+
+            if (type.BaseIndex >= index)
+                return false;
+
+            type.Depth = result[type.BaseIndex].Depth + 1;
+        }
+
+        // The engine's intervals have to nest exactly like the base types do
+        return DumpedTypeTreeHierarchy::IsPreorder(result);
+    }
+
+    // Builds the preorder from the base types, visiting siblings in engine order where known and file order otherwise
+    inline void ComputeOrder(const std::span<const DumpedTypeTreeRTTI *const> types, const std::span<const uint32_t> baseIndices,
+        std::vector<DumpedTypeTreeHierarchy::Type> &result)
+    {
+        std::vector<std::vector<uint32_t>> children(types.size());
+        std::vector<uint32_t> roots;
+
+        for (uint32_t i = 0; i < types.size(); i++)
+        {
+            (baseIndices[i] != DumpedTypeTreeHierarchy::kNoBase ? children[baseIndices[i]] : roots).push_back(i);
+        }
+
+        const auto byEngineOrder = [&](const uint32_t lhs, const uint32_t rhs)
+        {
+            return std::pair(types[lhs]->DerivedFromTypeIndex, lhs) < std::pair(types[rhs]->DerivedFromTypeIndex, rhs);
+        };
+
+        std::ranges::sort(roots, byEngineOrder);
+        for (auto &siblings : children)
+        {
+            std::ranges::sort(siblings, byEngineOrder);
+        }
+
+        result.clear();
+        result.reserve(types.size());
+
+        // Pairs of a type's table index and its next child to visit
+        std::vector<std::pair<uint32_t, size_t>> stack;
+
+        const auto visit = [&](const uint32_t local, const uint32_t baseIndex)
+        {
+            stack.emplace_back(static_cast<uint32_t>(result.size()), 0);
+            result.push_back({
+                .PersistentTypeID = types[local]->PersistentTypeID,
+                .BaseIndex = baseIndex,
+                .DescendantCount = 0,
+                .Depth = static_cast<uint32_t>(stack.size() - 1),
+            });
+        };
+
+        std::vector<uint32_t> localByIndex;
+        localByIndex.reserve(types.size());
+
+        for (const auto root : roots)
+        {
+            localByIndex.push_back(root);
+            visit(root, DumpedTypeTreeHierarchy::kNoBase);
+
+            while (!stack.empty())
+            {
+                auto &[index, nextChild] = stack.back();
+                const auto &siblings = children[localByIndex[index]];
+
+                if (nextChild == siblings.size())
+                {
+                    result[index].DescendantCount = static_cast<uint32_t>(result.size() - index - 1);
+                    stack.pop_back();
+                    continue;
+                }
+
+                const auto child = siblings[nextChild++];
+                const auto baseIndex = index;
+
+                localByIndex.push_back(child);
+                visit(child, baseIndex);
+            }
+        }
+
+        // Types only reachable through a cycle of base types are never visited
+        if (result.size() != types.size())
+            throw std::runtime_error("The base types form a cycle");
+    }
+}
+
+// Builds the hierarchy of the distinct types of the trees, in the order they first appear
+inline DumpedTypeTreeHierarchy BuildTypeHierarchy(const std::span<const DumpedTypeTree> trees)
+{
+    std::vector<const DumpedTypeTreeRTTI *> types;
+    std::unordered_map<int32_t, uint32_t> localIndices;
+
+    for (const auto &tree : trees)
+    {
+        if (localIndices.try_emplace(tree.RTTI.PersistentTypeID, static_cast<uint32_t>(types.size())).second)
+            types.push_back(&tree.RTTI);
+    }
+
+    std::vector<uint32_t> baseIndices(types.size(), DumpedTypeTreeHierarchy::kNoBase);
+    for (uint32_t i = 0; i < types.size(); i++)
+    {
+        const auto base = localIndices.find(static_cast<int32_t>(types[i]->BasePersistentTypeID));
+        if (types[i]->BasePersistentTypeID != DumpedTypeTreeRTTI::kInvalid && base != localIndices.end() && base->second != i)
+            baseIndices[i] = base->second;
+    }
+
+    DumpedTypeTreeHierarchy hierarchy;
+    if (!type_hierarchy_details::UseEngineOrder(types, baseIndices, hierarchy.Types))
+        type_hierarchy_details::ComputeOrder(types, baseIndices, hierarchy.Types);
+
+    hierarchy.IndexTypes();
+    return hierarchy;
+}
+
+//
+// Stores subtrees occurring more than once across the trees of a file once, in a pool the node arrays refer to.
+// The positional fields of a shared subtree are stored relative to its root, so that the same structure is shared
+// wherever it is nested, e.g. the PPtr, Vector3f or string subtrees found in hundreds of types. Shared subtrees
+// can refer to earlier shared subtrees in turn, making the trees a DAG.
+//
+
+namespace subtree_reference_details
+{
+    inline int32_t AddWrapping(const int32_t value, const int32_t offset)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(value) + static_cast<uint32_t>(offset));
+    }
+
+    // The node at index within a subtree as stored in the shared subtree, position being the root's index in its tree
+    inline DumpedTypeTreeNode Rebase(const std::span<const DumpedTypeTreeNode> subtree, const size_t position, const size_t index)
+    {
+        const auto &root = subtree.front();
+        auto node = subtree[index];
+
+        node.Level -= root.Level;
+        node.Index = AddWrapping(node.Index, -root.Index);
+
+        if (root.ByteOffset != DumpedTypeTreeNode::kNoByteOffset && node.ByteOffset != DumpedTypeTreeNode::kNoByteOffset)
+            node.ByteOffset -= root.ByteOffset;
+
+        if (index == 0)
+        {
+            node.ParentIndex = DumpedTypeTreeNode::kNoNode;
+            node.NextSiblingIndex = DumpedTypeTreeNode::kNoNode;
+            return node;
+        }
+
+        node.ParentIndex -= static_cast<uint32_t>(position);
+        if (node.NextSiblingIndex != DumpedTypeTreeNode::kNoNode)
+            node.NextSiblingIndex -= static_cast<uint32_t>(position);
+
+        return node;
+    }
+
+    // The inverse of Rebase, for the node of a shared subtree placed by the reference
+    inline DumpedTypeTreeNode Place(DumpedTypeTreeNode node, const DumpedTypeTreeSubtreeReference &reference, const bool isRoot)
+    {
+        node.Level += reference.Level;
+        node.Index = AddWrapping(node.Index, reference.Index);
+
+        if (reference.ByteOffset != DumpedTypeTreeNode::kNoByteOffset && node.ByteOffset != DumpedTypeTreeNode::kNoByteOffset)
+            node.ByteOffset += reference.ByteOffset;
+
+        if (isRoot)
+        {
+            node.ParentIndex = reference.ParentIndex;
+            node.NextSiblingIndex = reference.NextSiblingIndex;
+            return node;
+        }
+
+        node.ParentIndex += reference.Position;
+        if (node.NextSiblingIndex != DumpedTypeTreeNode::kNoNode)
+            node.NextSiblingIndex += reference.Position;
+
+        return node;
+    }
+
+    // Rebasing cannot turn a known byte offset into kNoByteOffset, so that Place restores every node
+    inline bool IsRebasable(const std::span<const DumpedTypeTreeNode> nodes)
+    {
+        const auto rootOffset = nodes.front().ByteOffset;
+        if (rootOffset == DumpedTypeTreeNode::kNoByteOffset)
+            return true;
+
+        return std::ranges::none_of(nodes, [&](const DumpedTypeTreeNode &node)
+        {
+            return node.ByteOffset != DumpedTypeTreeNode::kNoByteOffset && node.ByteOffset - rootOffset == DumpedTypeTreeNode::kNoByteOffset;
+        });
+    }
+
+    inline bool IsSameSubtree(const std::span<const DumpedTypeTreeNode> a, const size_t aPosition, const std::span<const DumpedTypeTreeNode> b,
+        const size_t bPosition)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (Rebase(a, aPosition, i) != Rebase(b, bPosition, i))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Expands a node array into values, getting the expanded nodes of every referenced shared subtree from getSubtreeNodes
+    template<typename TGetSubtreeNodes>
+    inline void Expand(const DumpedTypeTreeSubtree &subtree, TGetSubtreeNodes &&getSubtreeNodes, std::vector<DumpedTypeTreeNode> &values)
+    {
+        values.clear();
+        values.reserve(subtree.NodeCount);
+
+        auto node = subtree.Nodes.begin();
+        for (const auto &reference : subtree.References)
+        {
+            const auto inlineCount = static_cast<ptrdiff_t>(reference.Position - values.size());
+            values.insert(values.end(), node, node + inlineCount);
+            node += inlineCount;
+
+            const std::span<const DumpedTypeTreeNode> nodes = getSubtreeNodes(reference.Subtree);
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+                values.push_back(Place(nodes[i], reference, i == 0));
+            }
+        }
+
+        values.insert(values.end(), node, subtree.Nodes.end());
+    }
+
+    // Expands a node array without expanding the whole pool, only the shared subtrees it uses
+    inline std::vector<DumpedTypeTreeNode> ExpandUsed(const std::span<const DumpedTypeTreeSubtree> subtrees, const DumpedTypeTreeSubtree &subtree)
+    {
+        std::map<uint32_t, std::vector<DumpedTypeTreeNode>> expanded;
+        std::vector<uint32_t> pending;
+
+        for (const auto &reference : subtree.References)
+        {
+            pending.push_back(reference.Subtree);
+        }
+
+        while (!pending.empty())
+        {
+            const auto index = pending.back();
+            pending.pop_back();
+
+            if (!expanded.try_emplace(index).second)
+                continue;
+
+            for (const auto &reference : subtrees[index].References)
+            {
+                pending.push_back(reference.Subtree);
+            }
+        }
+
+        const auto getSubtreeNodes = [&](const uint32_t index) -> std::span<const DumpedTypeTreeNode>
+        {
+            return expanded.at(index);
+        };
+
+        // Subtrees only refer to the ones before them, so expanding in pool order expands every dependency first
+        for (auto &[index, values] : expanded)
+        {
+            Expand(subtrees[index], getSubtreeNodes, values);
+        }
+
+        std::vector<DumpedTypeTreeNode> values;
+        Expand(subtree, getSubtreeNodes, values);
+        return values;
+    }
+}
+
+class DumpedTypeTreeSubtreeDeduplicator
+{
+public:
+    static constexpr auto kNoSubtree = std::numeric_limits<uint32_t>::max();
+
+    // Smaller subtrees take more space as a reference than they save
+    static constexpr uint32_t kMinimumNodeCount = 2;
+
+    // Counts the uses of the subtrees of a node array. Every node array is counted before any is encoded, and
+    // the arrays must outlive the deduplicator. Subtrees within a repeated subtree are not counted again, so they
+    // are only shared on their own when they also occur elsewhere.
+    void Count(const std::span<const DumpedTypeTreeNode> nodes)
+    {
+        for (size_t i = 0; i < nodes.size();)
+        {
+            const auto candidate = Find(nodes, i, true);
+            if (candidate != nullptr && candidate->Count++ > 0)
+                i += nodes[i].SubtreeNodeCount;
+            else
+                i++;
+        }
+    }
+
+    // Replaces the subtrees used more than once by references, adding them to the pool on first use
+    DumpedTypeTreeSubtree Encode(const std::span<const DumpedTypeTreeNode> nodes)
+    {
+        return Encode(nodes, 0);
+    }
+
+    // Shared subtrees only refer to subtrees before them
+    const std::vector<DumpedTypeTreeSubtree> &GetSubtrees() const
+    {
+        return Subtrees;
+    }
+private:
+    struct Candidate
+    {
+        // The first use, and the index of its root in its tree
+        std::span<const DumpedTypeTreeNode> Nodes;
+        size_t Position = 0;
+        uint32_t Count = 0;
+        uint32_t Subtree = kNoSubtree;
+    };
+
+    Candidate *Find(const std::span<const DumpedTypeTreeNode> nodes, const size_t index, const bool add)
+    {
+        const auto subtree = nodes.subspan(index, nodes[index].SubtreeNodeCount);
+        if (subtree.size() < kMinimumNodeCount || !subtree_reference_details::IsRebasable(subtree))
+            return nullptr;
+
+        // The subtree hash covers everything but the positional fields, which are compared with the nodes
+        const auto it = CandidatesByHash.find(subtree.front().SubtreeHash);
+        if (it != CandidatesByHash.end())
+        {
+            for (auto &candidate : it->second)
+            {
+                if (subtree_reference_details::IsSameSubtree(candidate.Nodes, candidate.Position, subtree, index))
+                    return &candidate;
+            }
+        }
+
+        if (!add)
+            return nullptr;
+
+        return &CandidatesByHash[subtree.front().SubtreeHash].emplace_back(Candidate{ .Nodes = subtree, .Position = index });
+    }
+
+    DumpedTypeTreeSubtree Encode(const std::span<const DumpedTypeTreeNode> nodes, const size_t firstReferenced)
+    {
+        DumpedTypeTreeSubtree subtree{ .NodeCount = static_cast<uint32_t>(nodes.size()), .Nodes = {}, .References = {} };
+
+        for (size_t i = 0; i < nodes.size();)
+        {
+            const auto &node = nodes[i];
+            const auto candidate = i >= firstReferenced ? Find(nodes, i, false) : nullptr;
+
+            if (candidate == nullptr || candidate->Count < 2)
+            {
+                subtree.Nodes.push_back(node);
+                i++;
+                continue;
+            }
+
+            if (candidate->Subtree == kNoSubtree)
+                candidate->Subtree = AddSubtree(*candidate);
+
+            subtree.References.push_back({
+                .Subtree = candidate->Subtree,
+                .Position = static_cast<uint32_t>(i),
+                .Level = node.Level,
+                .Index = node.Index,
+                .ByteOffset = node.ByteOffset,
+                .ParentIndex = node.ParentIndex,
+                .NextSiblingIndex = node.NextSiblingIndex,
+            });
+
+            i += node.SubtreeNodeCount;
+        }
+
+        return subtree;
+    }
+
+    uint32_t AddSubtree(const Candidate &candidate)
+    {
+        std::vector<DumpedTypeTreeNode> rebased(candidate.Nodes.size());
+        for (size_t i = 0; i < rebased.size(); i++)
+        {
+            rebased[i] = subtree_reference_details::Rebase(candidate.Nodes, candidate.Position, i);
+        }
+
+        // The root stays in place, so that the subtree does not refer to itself. Nested shared subtrees are
+        // added first, keeping the pool in dependency order.
+        auto subtree = Encode(rebased, 1);
+
+        Subtrees.push_back(std::move(subtree));
+        return static_cast<uint32_t>(Subtrees.size() - 1);
+    }
+
+    std::unordered_map<uint64_t, std::vector<Candidate>> CandidatesByHash;
+    std::vector<DumpedTypeTreeSubtree> Subtrees;
+};
+
+// The node arrays of the trees and scripts of a file with their shared subtrees replaced by references. Trees
+// referring to another tree have no node array.
+struct DumpedTypeTreeSubtreeEncoding
+{
+    std::vector<DumpedTypeTreeSubtree> Subtrees;
+    std::vector<DumpedTypeTreeSubtree> TypeTrees;
+    std::vector<DumpedTypeTreeSubtree> Scripts;
+};
+
+inline DumpedTypeTreeSubtreeEncoding EncodeSubtreeReferences(const std::span<const DumpedTypeTree> trees, const std::span<const DumpedTypeTreeScript> scripts)
+{
+    DumpedTypeTreeSubtreeDeduplicator deduplicator;
+
+    for (const auto &tree : trees)
+    {
+        deduplicator.Count(tree.Nodes);
+    }
+
+    for (const auto &script : scripts)
+    {
+        deduplicator.Count(script.Tree.Nodes);
+    }
+
+    DumpedTypeTreeSubtreeEncoding encoding;
+
+    for (const auto &tree : trees)
+    {
+        encoding.TypeTrees.push_back(deduplicator.Encode(tree.Nodes));
+    }
+
+    for (const auto &script : scripts)
+    {
+        encoding.Scripts.push_back(deduplicator.Encode(script.Tree.Nodes));
+    }
+
+    encoding.Subtrees = deduplicator.GetSubtrees();
+    return encoding;
+}
+
+// A run of consecutive trees or scripts dumped with the same transfer flags, such as the trees of one pass of an
+// editor run, which are stored together with kHeaderFlagTreeSets
+struct DumpedTypeTreeSet
+{
+    std::underlying_type_t<DumpedTransferInstructionFlags> TransferFlags;
+    uint32_t First;
+    uint32_t Count;
+};
+
+template<typename T, typename TGetTree>
+inline std::vector<DumpedTypeTreeSet> GetTreeSets(const std::span<const T> values, TGetTree &&getTree)
+{
+    std::vector<DumpedTypeTreeSet> sets;
+
+    for (uint32_t i = 0; i < values.size(); i++)
+    {
+        const auto transferFlags = getTree(values[i]).TransferFlags;
+        if (sets.empty() || sets.back().TransferFlags != transferFlags)
+            sets.push_back({ transferFlags, i, 0 });
+
+        sets.back().Count++;
+    }
+
+    return sets;
+}
+
+inline std::vector<DumpedTypeTreeSet> GetTreeSets(const std::span<const DumpedTypeTree> trees)
+{
+    return GetTreeSets(trees, [](const DumpedTypeTree &tree) -> const DumpedTypeTree & { return tree; });
+}
+
+inline std::vector<DumpedTypeTreeSet> GetTreeSets(const std::span<const DumpedTypeTreeScript> scripts)
+{
+    return GetTreeSets(scripts, [](const DumpedTypeTreeScript &script) -> const DumpedTypeTree & { return script.Tree; });
+}
+
+// The distinct RTTI of the trees and scripts of a file in order of first use, and the index of every tree's and
+// script's RTTI in it, see kHeaderFlagTreeSets
+struct DumpedTypeTreeRTTITable
+{
+    std::vector<DumpedTypeTreeRTTI> Records;
+    std::vector<uint32_t> TypeTrees;
+    std::vector<uint32_t> Scripts;
+};
+
+inline DumpedTypeTreeRTTITable BuildRTTITable(const std::span<const DumpedTypeTree> trees, const std::span<const DumpedTypeTreeScript> scripts)
+{
+    DumpedTypeTreeRTTITable table;
+    std::unordered_map<int32_t, std::vector<uint32_t>> recordsByTypeID;
+
+    const auto add = [&](const DumpedTypeTreeRTTI &rtti)
+    {
+        auto &candidates = recordsByTypeID[rtti.PersistentTypeID];
+        for (const auto candidate : candidates)
+        {
+            if (table.Records[candidate] == rtti)
+                return candidate;
+        }
+
+        candidates.push_back(static_cast<uint32_t>(table.Records.size()));
+        table.Records.push_back(rtti);
+        return candidates.back();
+    };
+
+    for (const auto &tree : trees)
+    {
+        table.TypeTrees.push_back(add(tree.RTTI));
+    }
+
+    for (const auto &script : scripts)
+    {
+        table.Scripts.push_back(add(script.Tree.RTTI));
+    }
+
+    return table;
+}
+
+struct DumpedTypeTreeBinary
+{
+    DumpedTypeTreeHeader Header;
+    DumpedTypeTreeStringTable Strings;
+    std::vector<char> CommonStringBuffer;
+    std::vector<DumpedTypeTree> TypeTrees;
+
+    // The shared subtrees, only kept by readers leaving subtree references in place
+    std::vector<DumpedTypeTreeSubtree> Subtrees;
+
+    std::optional<DumpedTypeTreeShard> Shard;
+    std::optional<DumpedTypeTreeHierarchy> Hierarchy;
+    std::vector<DumpedTypeTreeScript> Scripts;
+    std::vector<DumpedTypeTreeSerializedBlobs> SerializedBlobs;
+
+    // Block size of the version 4 file the binary is stored in, or 0 if it is stored as it is
+    uint32_t CompressionBlockSize = 0;
+};
+
+namespace internal
+{
+    template<typename T>
+    inline void Write(OutputBuffer &output, const T &value)
+    {
+        // needed to workaround clang bug(?)
+        // ReSharper disable once CppStaticAssertFailure
+        static_assert(sizeof(T) == 0, "No default specialization available for Write()");
+    }
+
+    template<typename T>
+    inline void Write(OutputBuffer &output, const std::vector<T> &values)
+    {
+        Write(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            Write(output, value);
+        }
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const int32_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const int16_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const uint64_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const uint32_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const uint16_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const uint8_t &value)
+    {
+        output.WriteScalar(value);
+    }
+
+    inline void WriteString(OutputBuffer &output, const std::string_view value)
+    {
+        const auto size = static_cast<uint32_t>(value.size());
+        Write(output, size);
+        output.Write(value.data(), size);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const std::string &value)
+    {
+        WriteString(output, value);
+    }
+
+    inline void WriteBlob(OutputBuffer &output, const std::span<const char> value)
+    {
+        Write(output, static_cast<uint32_t>(value.size()));
+        output.Write(value.data(), value.size());
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeHeader &value)
+    {
+        Write(output, value.Magic);
+        Write(output, value.Version);
+        Write(output, value.MajorRevision);
+        Write(output, value.MinorRevision);
+        Write(output, value.PatchRevision);
+        Write(output, value.Variant);
+
+        if (value.Version >= DumpedTypeTreeHeader::kVersion2)
+            Write(output, value.Flags);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeRTTI &value)
+    {
+        Write(output, value.ClassName);
+        Write(output, value.ClassNamespace);
+        Write(output, value.Module);
+        Write(output, value.PersistentTypeID);
+        Write(output, value.Size);
+        Write(output, value.Flags);
+        Write(output, value.BasePersistentTypeID);
+        Write(output, value.DerivedFromTypeIndex);
+        Write(output, value.DerivedFromDescendantCount);
+    }
+
+    inline void WriteStringTable(OutputBuffer &output, const DumpedTypeTreeStringTable &strings)
+    {
+        Write(output, static_cast<uint32_t>(strings.Size()));
+        for (const auto value : strings.GetStrings())
+        {
+            WriteString(output, value);
+        }
+    }
+
+    // Nodes are written with string IDs when the string table is in use, and with the strings themselves otherwise
+    inline void WriteNode(OutputBuffer &output, const DumpedTypeTreeNode &value, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        const auto useByteOffsets = (headerFlags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets) != 0;
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagStringTable)
+        {
+            Write(output, value.TypeStringID);
+            Write(output, value.NameStringID);
+        }
+        else
+        {
+            WriteString(output, strings.Get(value.TypeStringID));
+            WriteString(output, strings.Get(value.NameStringID));
+        }
+
+        Write(output, value.Flags);
+        Write(output, value.ByteSize);
+        Write(output, value.Index);
+        Write(output, value.Version);
+        Write(output, value.Level);
+        Write(output, value.MetaFlags);
+        Write(output, value.RefTypeHash);
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+        {
+            Write(output, value.TypeCommonOffset);
+            Write(output, value.NameCommonOffset);
+        }
+
+        if (useByteOffsets)
+            Write(output, value.ByteOffset);
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+        {
+            Write(output, value.ParentIndex);
+            Write(output, value.NextSiblingIndex);
+            Write(output, value.SubtreeNodeCount);
+        }
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes)
+            Write(output, value.SubtreeHash);
+    }
+
+    inline void WriteNodes(OutputBuffer &output, const std::span<const DumpedTypeTreeNode> values, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        Write(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            WriteNode(output, value, strings, headerFlags);
+        }
+    }
+
+    inline void WriteTypeHashes(OutputBuffer &output, const DumpedTypeTree &value)
+    {
+        output.Write(value.OldTypeHash.data(), value.OldTypeHash.size());
+        Write(output, value.TypeHash);
+    }
+
+    // The runs of nodes stored in place are written around the references, whose positions follow from the sizes
+    // of the runs and of the referenced subtrees
+    inline void WriteSubtree(OutputBuffer &output, const DumpedTypeTreeSubtree &value, const std::span<const DumpedTypeTreeSubtree> subtrees,
+        const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        Write(output, static_cast<uint32_t>(value.References.size()));
+
+        std::span<const DumpedTypeTreeNode> nodes = value.Nodes;
+        uint32_t position = 0;
+
+        for (const auto &reference : value.References)
+        {
+            const auto inlineCount = reference.Position - position;
+            WriteNodes(output, nodes.first(inlineCount), strings, headerFlags);
+            nodes = nodes.subspan(inlineCount);
+
+            Write(output, reference.Subtree);
+            Write(output, reference.Level);
+            Write(output, reference.Index);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets)
+                Write(output, reference.ByteOffset);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+            {
+                Write(output, reference.ParentIndex);
+                Write(output, reference.NextSiblingIndex);
+            }
+
+            position = reference.Position + subtrees[reference.Subtree].NodeCount;
+        }
+
+        WriteNodes(output, nodes, strings, headerFlags);
+    }
+
+    inline void WriteSubtrees(OutputBuffer &output, const std::vector<DumpedTypeTreeSubtree> &values, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        Write(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            WriteSubtree(output, value, values, strings, headerFlags);
+        }
+    }
+
+    inline void WriteRTTITable(OutputBuffer &output, const std::vector<DumpedTypeTreeRTTI> &values)
+    {
+        Write(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            Write(output, value);
+        }
+    }
+
+    // With kHeaderFlagTreeSets the trees of every set follow the set's transfer flags and tree count, and carry
+    // the index of their RTTI in the table instead of the RTTI and transfer flags
+    inline void WriteTypeTrees(OutputBuffer &output, const std::vector<DumpedTypeTree> &values, const DumpedTypeTreeSubtreeEncoding &subtrees,
+        const DumpedTypeTreeRTTITable &rtti, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        const auto writeTree = [&](const size_t i)
+        {
+            const auto &value = values[i];
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes)
+                WriteTypeHashes(output, value);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeReferences)
+            {
+                Write(output, value.ReferencedTree);
+
+                if (value.ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+                    return;
+            }
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences)
+                WriteSubtree(output, subtrees.TypeTrees[i], subtrees.Subtrees, strings, headerFlags);
+            else
+                WriteNodes(output, value.Nodes, strings, headerFlags);
+        };
+
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeSets))
+        {
+            Write(output, static_cast<uint32_t>(values.size()));
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                Write(output, values[i].RTTI);
+                Write(output, values[i].TransferFlags);
+                writeTree(i);
+            }
+
+            return;
+        }
+
+        const auto sets = GetTreeSets(values);
+
+        Write(output, static_cast<uint32_t>(sets.size()));
+        for (const auto &set : sets)
+        {
+            Write(output, set.TransferFlags);
+            Write(output, set.Count);
+
+            for (size_t i = set.First; i < set.First + set.Count; i++)
+            {
+                Write(output, rtti.TypeTrees[i]);
+                writeTree(i);
+            }
+        }
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeShard &value)
+    {
+        Write(output, value.TypeIndexBegin);
+        Write(output, value.TypeIndexEnd);
+        Write(output, value.TypeCount);
+    }
+
+    // Scripts are grouped into sets like the trees, see WriteTypeTrees
+    inline void WriteScripts(OutputBuffer &output, const std::vector<DumpedTypeTreeScript> &values, const DumpedTypeTreeSubtreeEncoding &subtrees,
+        const DumpedTypeTreeRTTITable &rtti, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        const auto writeScript = [&](const size_t i)
+        {
+            const auto &value = values[i];
+            Write(output, value.AssemblyName);
+            Write(output, value.Namespace);
+            Write(output, value.ClassName);
+            Write(output, value.RefTypeHash);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeSets)
+            {
+                Write(output, rtti.Scripts[i]);
+            }
+            else
+            {
+                Write(output, value.Tree.RTTI);
+                Write(output, value.Tree.TransferFlags);
+            }
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes)
+                WriteTypeHashes(output, value.Tree);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences)
+                WriteSubtree(output, subtrees.Scripts[i], subtrees.Subtrees, strings, headerFlags);
+            else
+                WriteNodes(output, value.Tree.Nodes, strings, headerFlags);
+        };
+
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeSets))
+        {
+            Write(output, static_cast<uint32_t>(values.size()));
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                writeScript(i);
+            }
+
+            return;
+        }
+
+        const auto sets = GetTreeSets(values);
+
+        Write(output, static_cast<uint32_t>(sets.size()));
+        for (const auto &set : sets)
+        {
+            Write(output, set.TransferFlags);
+            Write(output, set.Count);
+
+            for (size_t i = set.First; i < set.First + set.Count; i++)
+            {
+                writeScript(i);
+            }
+        }
+    }
+
+    inline void WriteSerializedBlobs(OutputBuffer &output, const std::vector<DumpedTypeTreeSerializedBlobs> &values)
+    {
+        Write(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            Write(output, value.FormatVersion);
+
+            Write(output, static_cast<uint32_t>(value.Blobs.size()));
+            for (const auto &blob : value.Blobs)
+            {
+                WriteBlob(output, blob);
+            }
+
+            Write(output, value.TypeTreeBlobs);
+            Write(output, value.ScriptBlobs);
+        }
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeHierarchy &value)
+    {
+        Write(output, static_cast<uint32_t>(value.Types.size()));
+        for (const auto &type : value.Types)
+        {
+            Write(output, type.PersistentTypeID);
+            Write(output, type.BaseIndex);
+            Write(output, type.DescendantCount);
+            Write(output, type.Depth);
+        }
+    }
+
+    template<typename TWritePayload>
+    inline void WriteSectionPayload(OutputBuffer &output, const uint32_t tag, TWritePayload &&writePayload)
+    {
+        Write(output, tag);
+
+        // The payload size is patched in once the payload has been written
+        const auto sizePosition = output.GetSize();
+        Write(output, uint32_t{});
+        writePayload();
+
+        output.PatchScalar(sizePosition, static_cast<uint32_t>(output.GetSize() - sizePosition - sizeof(uint32_t)));
+    }
+
+    template<typename T>
+    inline void WriteSection(OutputBuffer &output, const uint32_t tag, const T &value)
+    {
+        WriteSectionPayload(output, tag, [&]
+        {
+            Write(output, value);
+        });
+    }
+
+    // Appends the checksum section to a file in the stream layout, whose sections start at sectionsPosition. The
+    // output holds nothing but the file.
+    inline void WriteStreamChecksums(OutputBuffer &output, const size_t sectionsPosition)
+    {
+        using block_compression_details::LoadScalar;
+
+        const auto data = output.GetData();
+        std::vector<DumpedTypeTreeRegionChecksum> regions{
+            { .Tag = 0, .Checksum = ComputeCrc32c(data.first(sectionsPosition)), .Size = sectionsPosition },
+        };
+
+        for (auto position = sectionsPosition; position < data.size();)
+        {
+            const auto size = sizeof(DumpedTypeTreeSectionHeader) + LoadScalar<uint32_t>(data.data() + position + sizeof(uint32_t));
+            regions.push_back({
+                .Tag = LoadScalar<uint32_t>(data.data() + position),
+                .Checksum = ComputeCrc32c(data.subspan(position, size)),
+                .Size = size,
+            });
+
+            position += size;
+        }
+
+        WriteSectionPayload(output, DumpedTypeTreeSectionHeader::kSectionChecksums, [&]
+        {
+            for (const auto &region : regions)
+            {
+                Write(output, region.Tag);
+                Write(output, region.Checksum);
+                Write(output, region.Size);
+            }
+
+            Write(output, static_cast<uint32_t>(regions.size()));
+        });
+    }
+
+    inline std::string GetSectionName(const uint32_t tag)
+    {
+        if (tag == 0)
+            return "type trees";
+
+        std::string name;
+        for (auto shift = 0; shift < 32; shift += 8)
+            name += static_cast<char>((tag >> shift) & 0xFF);
+
+        return "section " + name;
+    }
+
+    // Checks a file in the stream layout against its checksum section. A truncated file has lost the section.
+    inline void VerifyStreamChecksums(const std::span<const char> data)
+    {
+        using block_compression_details::LoadScalar;
+
+        constexpr auto kSectionHeaderSize = sizeof(DumpedTypeTreeSectionHeader);
+
+        if (data.size() < kSectionHeaderSize + sizeof(uint32_t))
+            throw std::runtime_error("Missing checksums, the file may be truncated");
+
+        const uint64_t count = LoadScalar<uint32_t>(data.data() + data.size() - sizeof(uint32_t));
+        const auto payloadSize = count * sizeof(DumpedTypeTreeRegionChecksum) + sizeof(uint32_t);
+
+        if (payloadSize > data.size() - kSectionHeaderSize)
+            throw std::runtime_error("Missing checksums, the file may be truncated");
+
+        const auto section = data.size() - payloadSize - kSectionHeaderSize;
+        if (LoadScalar<uint32_t>(data.data() + section) != DumpedTypeTreeSectionHeader::kSectionChecksums
+            || LoadScalar<uint32_t>(data.data() + section + sizeof(uint32_t)) != payloadSize)
+        {
+            throw std::runtime_error("Missing checksums, the file may be truncated");
+        }
+
+        uint64_t position = 0;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            const auto entry = data.data() + section + kSectionHeaderSize + i * sizeof(DumpedTypeTreeRegionChecksum);
+            const auto tag = LoadScalar<uint32_t>(entry + offsetof(DumpedTypeTreeRegionChecksum, Tag));
+            const auto size = LoadScalar<uint64_t>(entry + offsetof(DumpedTypeTreeRegionChecksum, Size));
+
+            if (size > section - position)
+                throw std::runtime_error("Invalid checksums");
+
+            if (ComputeCrc32c(data.subspan(position, size)) != LoadScalar<uint32_t>(entry + offsetof(DumpedTypeTreeRegionChecksum, Checksum)))
+                throw std::runtime_error("Checksum mismatch in the " + GetSectionName(tag));
+
+            position += size;
+        }
+
+        if (position != section)
+            throw std::runtime_error("Invalid checksums");
+    }
+
+    // The stream layout header flags the columnar layout keeps. Strings are always pooled and node ranges shared.
+    constexpr uint32_t kColumnarHeaderFlags = DumpedTypeTreeHeader::kHeaderFlagCommonStrings | DumpedTypeTreeHeader::kHeaderFlagByteOffsets
+        | DumpedTypeTreeHeader::kHeaderFlagNavigation | DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes | DumpedTypeTreeHeader::kHeaderFlagTypeHashes
+        | DumpedTypeTreeHeader::kHeaderFlagChecksums;
+    static_assert(DumpedTypeTreeHeader::kHeaderFlagChecksums == DumpedTypeTreeColumnarHeader::kFlagChecksums);
+
+    // The version 3 string pool starts out as the node string table, so that node string IDs are pool IDs
+    class ColumnarStringPool
+    {
+    public:
+        explicit ColumnarStringPool(const DumpedTypeTreeStringTable &strings)
+        {
+            for (uint32_t id = 0; id < strings.Size(); id++)
+                Intern(strings.Get(id));
+        }
+
+        uint32_t Intern(const std::string_view value)
+        {
+            const auto [it, inserted] = IDs.try_emplace(value, static_cast<uint32_t>(Strings.size()));
+            if (inserted)
+                Strings.push_back(value);
+
+            return it->second;
+        }
+
+        const std::vector<std::string_view> &GetStrings() const
+        {
+            return Strings;
+        }
+    private:
+        std::vector<std::string_view> Strings;
+        std::unordered_map<std::string_view, uint32_t> IDs;
+    };
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeColumnarTree &value)
+    {
+        Write(output, value.ClassNameStringID);
+        Write(output, value.ClassNamespaceStringID);
+        Write(output, value.ModuleStringID);
+        Write(output, value.PersistentTypeID);
+        Write(output, value.Size);
+        Write(output, value.RTTIFlags);
+        Write(output, value.BasePersistentTypeID);
+        Write(output, value.DerivedFromTypeIndex);
+        Write(output, value.DerivedFromDescendantCount);
+        Write(output, value.FirstNode);
+        Write(output, value.NodeCount);
+        Write(output, value.Reserved);
+        Write(output, value.TransferFlags);
+        Write(output, value.TypeHash);
+        output.Write(value.OldTypeHash, sizeof(value.OldTypeHash));
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeColumnarScript &value)
+    {
+        Write(output, value.AssemblyNameStringID);
+        Write(output, value.NamespaceStringID);
+        Write(output, value.ClassNameStringID);
+        Write(output, value.Reserved);
+        Write(output, value.RefTypeHash);
+        Write(output, value.Tree);
+    }
+
+    // Writes the version 3 columnar layout, see columnar_format.hpp. Trees referring to another tree share its node range.
+    inline void WriteColumnar(OutputBuffer &output, const DumpedTypeTreeHeader &header, const DumpedTypeTreeStringTable &strings,
+        const std::span<const char> commonStringBuffer, const std::span<const DumpedTypeTree> typeTrees, const std::optional<DumpedTypeTreeShard> &shard,
+        const std::optional<DumpedTypeTreeHierarchy> &hierarchy, const std::span<const DumpedTypeTreeScript> scripts,
+        const std::span<const DumpedTypeTreeSerializedBlobs> serializedBlobs)
+    {
+        using Section = DumpedTypeTreeColumnarSection;
+
+        const auto flags = header.Flags & kColumnarHeaderFlags;
+        const auto useTypeHashes = (flags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes) != 0;
+
+        ColumnarStringPool pool(strings);
+        const auto variantStringID = pool.Intern(header.Variant);
+
+        // The node arrays in column order, and the tree records referring to them
+        std::vector<std::span<const DumpedTypeTreeNode>> nodeArrays;
+        uint32_t nodeCount = 0;
+
+        const auto makeRecord = [&](const DumpedTypeTree &tree)
+        {
+            DumpedTypeTreeColumnarTree record{
+                .ClassNameStringID = pool.Intern(tree.RTTI.ClassName),
+                .ClassNamespaceStringID = pool.Intern(tree.RTTI.ClassNamespace),
+                .ModuleStringID = pool.Intern(tree.RTTI.Module),
+                .PersistentTypeID = tree.RTTI.PersistentTypeID,
+                .Size = tree.RTTI.Size,
+                .RTTIFlags = tree.RTTI.Flags,
+                .BasePersistentTypeID = tree.RTTI.BasePersistentTypeID,
+                .DerivedFromTypeIndex = tree.RTTI.DerivedFromTypeIndex,
+                .DerivedFromDescendantCount = tree.RTTI.DerivedFromDescendantCount,
+                .FirstNode = 0,
+                .NodeCount = 0,
+                .Reserved = 0,
+                .TransferFlags = tree.TransferFlags,
+                .TypeHash = useTypeHashes ? tree.TypeHash : 0,
+                .OldTypeHash = {},
+            };
+
+            if (useTypeHashes)
+                std::ranges::copy(tree.OldTypeHash, record.OldTypeHash);
+
+            return record;
+        };
+
+        const auto appendNodes = [&](DumpedTypeTreeColumnarTree &record, const std::span<const DumpedTypeTreeNode> nodes)
+        {
+            record.FirstNode = nodeCount;
+            record.NodeCount = static_cast<uint32_t>(nodes.size());
+
+            nodeArrays.push_back(nodes);
+            nodeCount += record.NodeCount;
+        };
+
+        std::vector<DumpedTypeTreeColumnarTree> treeRecords;
+        std::vector<DumpedTypeTreeColumnarTypeIndexEntry> typeIndex;
+        treeRecords.reserve(typeTrees.size());
+        typeIndex.reserve(typeTrees.size());
+
+        for (uint32_t i = 0; i < typeTrees.size(); i++)
+        {
+            const auto &tree = typeTrees[i];
+            auto &record = treeRecords.emplace_back(makeRecord(tree));
+
+            if (tree.ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+            {
+                record.FirstNode = treeRecords[tree.ReferencedTree].FirstNode;
+                record.NodeCount = treeRecords[tree.ReferencedTree].NodeCount;
+            }
+            else
+            {
+                appendNodes(record, tree.Nodes);
+            }
+
+            typeIndex.push_back({ .PersistentTypeID = tree.RTTI.PersistentTypeID, .TypeTreeIndex = i });
+        }
+
+        std::ranges::sort(typeIndex);
+
+        std::vector<DumpedTypeTreeColumnarScript> scriptRecords;
+        scriptRecords.reserve(scripts.size());
+
+        for (const auto &script : scripts)
+        {
+            auto &record = scriptRecords.emplace_back(DumpedTypeTreeColumnarScript{
+                .AssemblyNameStringID = pool.Intern(script.AssemblyName),
+                .NamespaceStringID = pool.Intern(script.Namespace),
+                .ClassNameStringID = pool.Intern(script.ClassName),
+                .Reserved = 0,
+                .RefTypeHash = script.RefTypeHash,
+                .Tree = makeRecord(script.Tree),
+            });
+
+            appendNodes(record.Tree, script.Tree.Nodes);
+        }
+
+        Write(output, header.Magic);
+        Write(output, DumpedTypeTreeHeader::kVersion3);
+        Write(output, header.MajorRevision);
+        Write(output, header.MinorRevision);
+        Write(output, header.PatchRevision);
+        Write(output, variantStringID);
+        Write(output, flags);
+
+        // The section table follows the sections, its position and size are patched in once they are written
+        const auto sectionTablePosition = output.GetSize();
+        Write(output, uint64_t{});
+        Write(output, uint32_t{});
+        Write(output, uint32_t{});
+
+        std::vector<DumpedTypeTreeColumnarSection> sections;
+
+        const auto align = [&]
+        {
+            static constexpr char kPadding[kColumnarSectionAlignment]{};
+            output.Write(kPadding, (kColumnarSectionAlignment - output.GetSize() % kColumnarSectionAlignment) % kColumnarSectionAlignment);
+        };
+
+        const auto useChecksums = (flags & DumpedTypeTreeHeader::kHeaderFlagChecksums) != 0;
+
+        const auto addSection = [&](const uint32_t tag, auto &&writePayload)
+        {
+            align();
+
+            const auto offset = output.GetSize();
+            writePayload();
+
+            const auto size = output.GetSize() - offset;
+            const auto checksum = useChecksums ? ComputeCrc32c(output.GetData().subspan(offset, size)) : 0;
+            sections.push_back({ .Tag = tag, .Checksum = checksum, .Offset = offset, .Size = size });
+        };
+
+        const auto addColumn = [&](const uint32_t tag, auto &&getField)
+        {
+            addSection(tag, [&]
+            {
+                for (const auto nodes : nodeArrays)
+                {
+                    for (const auto &node : nodes)
+                        Write(output, getField(node));
+                }
+            });
+        };
+
+        addSection(Section::kSectionStringOffsets, [&]
+        {
+            uint32_t offset = 0;
+            for (const auto value : pool.GetStrings())
+            {
+                Write(output, offset);
+                offset += static_cast<uint32_t>(value.size() + 1);
+            }
+
+            Write(output, offset);
+        });
+
+        addSection(Section::kSectionStringData, [&]
+        {
+            for (const auto value : pool.GetStrings())
+            {
+                output.Write(value);
+                Write(output, uint8_t{});
+            }
+        });
+
+        addSection(Section::kSectionTypeTrees, [&]
+        {
+            for (const auto &record : treeRecords)
+                Write(output, record);
+        });
+
+        addSection(Section::kSectionTypeIndex, [&]
+        {
+            for (const auto &entry : typeIndex)
+            {
+                Write(output, entry.PersistentTypeID);
+                Write(output, entry.TypeTreeIndex);
+            }
+        });
+
+        if (!scriptRecords.empty())
+        {
+            addSection(Section::kSectionScripts, [&]
+            {
+                for (const auto &record : scriptRecords)
+                    Write(output, record);
+            });
+        }
+
+        if (flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+        {
+            addSection(Section::kSectionCommonStrings, [&]
+            {
+                output.Write(commonStringBuffer.data(), commonStringBuffer.size());
+            });
+        }
+
+        addColumn(Section::kSectionNodeTypeStringIDs, [](const DumpedTypeTreeNode &node) { return node.TypeStringID; });
+        addColumn(Section::kSectionNodeNameStringIDs, [](const DumpedTypeTreeNode &node) { return node.NameStringID; });
+        addColumn(Section::kSectionNodeFlags, [](const DumpedTypeTreeNode &node) { return node.Flags; });
+        addColumn(Section::kSectionNodeByteSizes, [](const DumpedTypeTreeNode &node) { return node.ByteSize; });
+        addColumn(Section::kSectionNodeIndices, [](const DumpedTypeTreeNode &node) { return node.Index; });
+        addColumn(Section::kSectionNodeVersions, [](const DumpedTypeTreeNode &node) { return node.Version; });
+        addColumn(Section::kSectionNodeLevels, [](const DumpedTypeTreeNode &node) { return node.Level; });
+        addColumn(Section::kSectionNodeMetaFlags, [](const DumpedTypeTreeNode &node) { return node.MetaFlags; });
+        addColumn(Section::kSectionNodeRefTypeHashes, [](const DumpedTypeTreeNode &node) { return node.RefTypeHash; });
+
+        if (flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+        {
+            addColumn(Section::kSectionNodeTypeCommonOffsets, [](const DumpedTypeTreeNode &node) { return node.TypeCommonOffset; });
+            addColumn(Section::kSectionNodeNameCommonOffsets, [](const DumpedTypeTreeNode &node) { return node.NameCommonOffset; });
+        }
+
+        if (flags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets)
+            addColumn(Section::kSectionNodeByteOffsets, [](const DumpedTypeTreeNode &node) { return node.ByteOffset; });
+
+        if (flags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+        {
+            addColumn(Section::kSectionNodeParentIndices, [](const DumpedTypeTreeNode &node) { return node.ParentIndex; });
+            addColumn(Section::kSectionNodeNextSiblingIndices, [](const DumpedTypeTreeNode &node) { return node.NextSiblingIndex; });
+            addColumn(Section::kSectionNodeSubtreeNodeCounts, [](const DumpedTypeTreeNode &node) { return node.SubtreeNodeCount; });
+        }
+
+        if (flags & DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes)
+            addColumn(Section::kSectionNodeSubtreeHashes, [](const DumpedTypeTreeNode &node) { return node.SubtreeHash; });
+
+        if (shard.has_value())
+            addSection(Section::kSectionShard, [&] { Write(output, shard.value()); });
+
+        if (hierarchy.has_value())
+            addSection(Section::kSectionHierarchy, [&] { Write(output, hierarchy.value()); });
+
+        if (!serializedBlobs.empty())
+        {
+            addSection(Section::kSectionSerializedBlobs, [&]
+            {
+                WriteSerializedBlobs(output, { serializedBlobs.begin(), serializedBlobs.end() });
+            });
+        }
+
+        align();
+        const auto sectionTableOffset = output.GetSize();
+        output.PatchScalar(sectionTablePosition, static_cast<uint64_t>(sectionTableOffset));
+        output.PatchScalar(sectionTablePosition + sizeof(uint64_t), static_cast<uint32_t>(sections.size()));
+
+        for (const auto &section : sections)
+        {
+            Write(output, section.Tag);
+            Write(output, section.Checksum);
+            Write(output, section.Offset);
+            Write(output, section.Size);
+        }
+
+        if (useChecksums)
+        {
+            output.PatchScalar(sectionTablePosition + sizeof(uint64_t) + sizeof(uint32_t),
+                ComputeCrc32c(output.GetData().subspan(sectionTableOffset)));
+        }
+    }
+
+    inline void WriteBinary(OutputBuffer &output, const DumpedTypeTreeBinary &value)
+    {
+        if (value.Header.Version == DumpedTypeTreeHeader::kVersion3)
+        {
+            WriteColumnar(output, value.Header, value.Strings, value.CommonStringBuffer, value.TypeTrees, value.Shard, value.Hierarchy,
+                value.Scripts, value.SerializedBlobs);
+            return;
+        }
+
+        Write(output, value.Header);
+
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagStringTable)
+            WriteStringTable(output, value.Strings);
+
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+            WriteBlob(output, value.CommonStringBuffer);
+
+        DumpedTypeTreeSubtreeEncoding subtrees;
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences)
+        {
+            subtrees = EncodeSubtreeReferences(value.TypeTrees, value.Scripts);
+            WriteSubtrees(output, subtrees.Subtrees, value.Strings, value.Header.Flags);
+        }
+
+        DumpedTypeTreeRTTITable rtti;
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagTreeSets)
+        {
+            rtti = BuildRTTITable(value.TypeTrees, value.Scripts);
+            WriteRTTITable(output, rtti.Records);
+        }
+
+        WriteTypeTrees(output, value.TypeTrees, subtrees, rtti, value.Strings, value.Header.Flags);
+
+        const auto sectionsPosition = output.GetSize();
+
+        if (value.Shard.has_value())
+            WriteSection(output, DumpedTypeTreeSectionHeader::kSectionShard, value.Shard.value());
+
+        if (value.Hierarchy.has_value())
+            WriteSection(output, DumpedTypeTreeSectionHeader::kSectionHierarchy, value.Hierarchy.value());
+
+        if (!value.Scripts.empty())
+        {
+            WriteSectionPayload(output, DumpedTypeTreeSectionHeader::kSectionScripts, [&]
+            {
+                WriteScripts(output, value.Scripts, subtrees, rtti, value.Strings, value.Header.Flags);
+            });
+        }
+
+        if (!value.SerializedBlobs.empty())
+        {
+            WriteSectionPayload(output, DumpedTypeTreeSectionHeader::kSectionSerializedBlobs, [&]
+            {
+                WriteSerializedBlobs(output, value.SerializedBlobs);
+            });
+        }
+
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagChecksums)
+            WriteStreamChecksums(output, sectionsPosition);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeBinary &value)
+    {
+        if (value.CompressionBlockSize == 0)
+        {
+            WriteBinary(output, value);
+            return;
+        }
+
+        OutputBuffer uncompressed;
+        WriteBinary(uncompressed, value);
+        WriteBlockCompressed(output, uncompressed.GetData(), value.CompressionBlockSize,
+            (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagChecksums) != 0);
+    }
+
+    template<typename T>
+    inline void Read(std::istream &input, T &value)
+    {
+        // ReSharper disable once CppStaticAssertFailure
+        static_assert(sizeof(T) == 0, "No default specialization available for Read()");
+    }
+
+    template<typename T>
+    inline void ReadScalar(std::istream &input, T &value)
+    {
+        if (!input.read(reinterpret_cast<char *>(&value), sizeof(value)))
+            throw std::runtime_error("Unexpected end of file");
+    }
+
+    template<typename T>
+    inline void Read(std::istream &input, std::vector<T> &values)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        values.resize(size);
+        for (auto &value : values)
+        {
+            Read(input, value);
+        }
+    }
+
+    template<>
+    inline void Read(std::istream &input, int32_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, int16_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, uint64_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, uint32_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, uint16_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, uint8_t &value)
+    {
+        ReadScalar(input, value);
+    }
+
+    template<>
+    inline void Read(std::istream &input, std::string &value)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        value.resize(size);
+        if (!input.read(value.data(), size))
+            throw std::runtime_error("Unexpected end of file");
+    }
+
+    inline void ReadBlob(std::istream &input, std::vector<char> &value)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        value.resize(size);
+        if (!input.read(value.data(), size))
+            throw std::runtime_error("Unexpected end of file");
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeHeader &value)
+    {
+        Read(input, value.Magic);
+        Read(input, value.Version);
+        Read(input, value.MajorRevision);
+        Read(input, value.MinorRevision);
+        Read(input, value.PatchRevision);
+        Read(input, value.Variant);
+
+        if (value.Version >= DumpedTypeTreeHeader::kVersion2)
+            Read(input, value.Flags);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeRTTI &value)
+    {
+        Read(input, value.ClassName);
+        Read(input, value.ClassNamespace);
+        Read(input, value.Module);
+        Read(input, value.PersistentTypeID);
+        Read(input, value.Size);
+        Read(input, value.Flags);
+        Read(input, value.BasePersistentTypeID);
+        Read(input, value.DerivedFromTypeIndex);
+        Read(input, value.DerivedFromDescendantCount);
+    }
+
+    inline void ReadStringTable(std::istream &input, DumpedTypeTreeStringTable &strings)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        std::string value;
+        for (uint32_t i = 0; i < size; i++)
+        {
+            Read(input, value);
+
+            if (strings.Intern(value) != i)
+                throw std::runtime_error("Duplicate string in string table");
+        }
+    }
+
+    // Checks the stored navigation and subtree hashes of a tree's nodes, and computes the ones the file does not have
+    inline void FinishNodes(std::vector<DumpedTypeTreeNode> &values, const DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation))
+        {
+            ComputeNodeNavigation(values);
+        }
+        else
+        {
+            // Stored navigation must describe the same hierarchy as the levels, which also keeps it in bounds
+            auto expected = values;
+            ComputeNodeNavigation(expected);
+
+            if (values != expected)
+                throw std::runtime_error("Invalid node navigation");
+        }
+
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes))
+        {
+            ComputeSubtreeHashes(values, strings);
+            return;
+        }
+
+        for (size_t i = values.size(); i-- > 0;)
+        {
+            if (values[i].SubtreeHash != HashSubtree(values, i, strings))
+                throw std::runtime_error("Invalid subtree hash");
+        }
+    }
+
+    // Strings stored inline are interned into the string table as they are read
+    inline void ReadNode(std::istream &input, DumpedTypeTreeNode &value, DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagStringTable)
+        {
+            Read(input, value.TypeStringID);
+            Read(input, value.NameStringID);
+
+            if (value.TypeStringID >= strings.Size() || value.NameStringID >= strings.Size())
+                throw std::runtime_error("Invalid string ID");
+        }
+        else
+        {
+            std::string string;
+            Read(input, string);
+            value.TypeStringID = strings.Intern(string);
+            Read(input, string);
+            value.NameStringID = strings.Intern(string);
+        }
+
+        Read(input, value.Flags);
+        Read(input, value.ByteSize);
+        Read(input, value.Index);
+        Read(input, value.Version);
+        Read(input, value.Level);
+        Read(input, value.MetaFlags);
+        Read(input, value.RefTypeHash);
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+        {
+            Read(input, value.TypeCommonOffset);
+            Read(input, value.NameCommonOffset);
+        }
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets)
+            Read(input, value.ByteOffset);
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+        {
+            Read(input, value.ParentIndex);
+            Read(input, value.NextSiblingIndex);
+            Read(input, value.SubtreeNodeCount);
+        }
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes)
+            Read(input, value.SubtreeHash);
+    }
+
+    inline void ReadNodes(std::istream &input, std::vector<DumpedTypeTreeNode> &values, DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        values.resize(size);
+        for (auto &value : values)
+        {
+            ReadNode(input, value, strings, headerFlags);
+        }
+
+        FinishNodes(values, strings, headerFlags);
+    }
+
+    inline void ReadSubtree(std::istream &input, DumpedTypeTreeSubtree &value, const std::span<const DumpedTypeTreeSubtree> subtrees,
+        DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        const auto addNodeCount = [&](const uint32_t count)
+        {
+            if (count > std::numeric_limits<uint32_t>::max() - value.NodeCount)
+                throw std::runtime_error("Too many nodes");
+
+            value.NodeCount += count;
+        };
+
+        const auto readNodes = [&]
+        {
+            uint32_t size;
+            ReadScalar(input, size);
+            addNodeCount(size);
+
+            // The counts are only trusted as far as the data read so far, so the arrays grow as it is read
+            for (uint32_t i = 0; i < size; i++)
+            {
+                ReadNode(input, value.Nodes.emplace_back(), strings, headerFlags);
+            }
+        };
+
+        uint32_t referenceCount;
+        ReadScalar(input, referenceCount);
+
+        for (uint32_t i = 0; i < referenceCount; i++)
+        {
+            readNodes();
+
+            auto &reference = value.References.emplace_back();
+
+            Read(input, reference.Subtree);
+            if (reference.Subtree >= subtrees.size() || subtrees[reference.Subtree].NodeCount == 0)
+                throw std::runtime_error("Invalid subtree reference");
+
+            reference.Position = value.NodeCount;
+            Read(input, reference.Level);
+            Read(input, reference.Index);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets)
+                Read(input, reference.ByteOffset);
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+            {
+                Read(input, reference.ParentIndex);
+                Read(input, reference.NextSiblingIndex);
+            }
+
+            addNodeCount(subtrees[reference.Subtree].NodeCount);
+        }
+
+        readNodes();
+    }
+
+    // Shared subtrees may only refer to the subtrees before them
+    inline void ReadSubtrees(std::istream &input, std::vector<DumpedTypeTreeSubtree> &values, DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        for (uint32_t i = 0; i < size; i++)
+        {
+            DumpedTypeTreeSubtree value;
+            ReadSubtree(input, value, values, strings, headerFlags);
+            values.push_back(std::move(value));
+        }
+    }
+
+    // The shared subtrees of a file being read. They are expanded up front, unless the trees are read with their
+    // subtree references left in place.
+    struct SubtreePool
+    {
+        std::vector<DumpedTypeTreeSubtree> Subtrees;
+        std::vector<std::vector<DumpedTypeTreeNode>> ExpandedSubtrees;
+        bool ExpandReferences = true;
+
+        void ExpandSubtrees()
+        {
+            // Every subtree only refers to the ones before it, which are expanded by then
+            ExpandedSubtrees.resize(Subtrees.size());
+            for (size_t i = 0; i < Subtrees.size(); i++)
+            {
+                subtree_reference_details::Expand(Subtrees[i], [&](const uint32_t index) -> std::span<const DumpedTypeTreeNode>
+                {
+                    return ExpandedSubtrees[index];
+                }, ExpandedSubtrees[i]);
+            }
+        }
+    };
+
+    // Reads the nodes of a tree or script, which are left compact if the subtree references are left in place
+    inline void ReadTreeNodes(std::istream &input, DumpedTypeTree &value, const SubtreePool &subtrees, DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences))
+        {
+            ReadNodes(input, value.Nodes, strings, headerFlags);
+            return;
+        }
+
+        ReadSubtree(input, value.CompactNodes, subtrees.Subtrees, strings, headerFlags);
+
+        if (!subtrees.ExpandReferences)
+            return;
+
+        subtree_reference_details::Expand(value.CompactNodes, [&](const uint32_t index) -> std::span<const DumpedTypeTreeNode>
+        {
+            return subtrees.ExpandedSubtrees[index];
+        }, value.Nodes);
+
+        value.CompactNodes = {};
+        FinishNodes(value.Nodes, strings, headerFlags);
+    }
+
+    inline void ReadTypeHashes(std::istream &input, DumpedTypeTree &value)
+    {
+        ReadScalar(input, value.OldTypeHash);
+        Read(input, value.TypeHash);
+    }
+
+    // Trees left compact are expanded for hashing
+    inline void ComputeTypeHashes(DumpedTypeTree &value, const SubtreePool &subtrees, const DumpedTypeTreeStringTable &strings)
+    {
+        if (subtrees.ExpandReferences || value.CompactNodes.NodeCount == 0)
+        {
+            ::ComputeTypeHashes(value, strings);
+            return;
+        }
+
+        DumpedTypeTree expanded{};
+        expanded.Nodes = subtree_reference_details::ExpandUsed(subtrees.Subtrees, value.CompactNodes);
+        ::ComputeTypeHashes(expanded, strings);
+
+        value.OldTypeHash = expanded.OldTypeHash;
+        value.TypeHash = expanded.TypeHash;
+    }
+
+    inline void ReadRTTITable(std::istream &input, std::vector<DumpedTypeTreeRTTI> &values)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        values.resize(size);
+        for (auto &value : values)
+        {
+            Read(input, value);
+        }
+    }
+
+    inline const DumpedTypeTreeRTTI &ReadRTTIIndex(std::istream &input, const std::span<const DumpedTypeTreeRTTI> rtti)
+    {
+        uint32_t index;
+        ReadScalar(input, index);
+
+        if (index >= rtti.size())
+            throw std::runtime_error("Invalid RTTI index");
+
+        return rtti[index];
+    }
+
+    // Reads the trees and scripts of every set, or all of them as one set if the file has no tree sets
+    template<typename TReadSet>
+    inline void ReadTreeSets(std::istream &input, const uint32_t headerFlags, TReadSet &&readSet)
+    {
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeSets))
+        {
+            uint32_t size;
+            ReadScalar(input, size);
+            readSet(size, std::nullopt);
+            return;
+        }
+
+        uint32_t setCount;
+        ReadScalar(input, setCount);
+
+        for (uint32_t i = 0; i < setCount; i++)
+        {
+            uint64_t transferFlags;
+            uint32_t size;
+            ReadScalar(input, transferFlags);
+            ReadScalar(input, size);
+            readSet(size, transferFlags);
+        }
+    }
+
+    inline void ReadTypeTrees(std::istream &input, std::vector<DumpedTypeTree> &values, const SubtreePool &subtrees, const std::span<const DumpedTypeTreeRTTI> rtti,
+        DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        values.clear();
+        ReadTreeSets(input, headerFlags, [&](const uint32_t size, const std::optional<uint64_t> transferFlags)
+        {
+            const auto first = static_cast<uint32_t>(values.size());
+            values.resize(first + size);
+
+            for (uint32_t i = first; i < values.size(); i++)
+            {
+                auto &value = values[i];
+                if (transferFlags.has_value())
+                {
+                    value.RTTI = ReadRTTIIndex(input, rtti);
+                    value.TransferFlags = transferFlags.value();
+                }
+                else
+                {
+                    Read(input, value.RTTI);
+                    Read(input, value.TransferFlags);
+                }
+
+                if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes)
+                    ReadTypeHashes(input, value);
+
+                if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTreeReferences)
+                {
+                    Read(input, value.ReferencedTree);
+
+                    if (value.ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+                    {
+                        if (value.ReferencedTree >= i || values[value.ReferencedTree].ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+                            throw std::runtime_error("Invalid type tree reference");
+
+                        continue;
+                    }
+                }
+
+                ReadTreeNodes(input, value, subtrees, strings, headerFlags);
+            }
+        });
+
+        // Resolve references so that consumers never have to deal with them
+        for (auto &value : values)
+        {
+            if (value.ReferencedTree == DumpedTypeTree::kNoReferencedTree)
+                continue;
+
+            value.Nodes = values[value.ReferencedTree].Nodes;
+            value.CompactNodes = values[value.ReferencedTree].CompactNodes;
+            value.ReferencedTree = DumpedTypeTree::kNoReferencedTree;
+        }
+
+        if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes))
+        {
+            for (auto &value : values)
+            {
+                ComputeTypeHashes(value, subtrees, strings);
+            }
+        }
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeShard &value)
+    {
+        Read(input, value.TypeIndexBegin);
+        Read(input, value.TypeIndexEnd);
+        Read(input, value.TypeCount);
+    }
+
+    // The intervals are validated, so that range checks on the table can be trusted
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeHierarchy &value)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        value.Types.resize(size);
+        for (auto &type : value.Types)
+        {
+            Read(input, type.PersistentTypeID);
+            Read(input, type.BaseIndex);
+            Read(input, type.DescendantCount);
+            Read(input, type.Depth);
+        }
+
+        if (!DumpedTypeTreeHierarchy::IsPreorder(value.Types))
+            throw std::runtime_error("Invalid type hierarchy");
+
+        value.IndexTypes();
+    }
+
+    inline void ReadScripts(std::istream &input, std::vector<DumpedTypeTreeScript> &values, const SubtreePool &subtrees, const std::span<const DumpedTypeTreeRTTI> rtti,
+        DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        values.clear();
+        ReadTreeSets(input, headerFlags, [&](const uint32_t size, const std::optional<uint64_t> transferFlags)
+        {
+            const auto first = values.size();
+            values.resize(first + size);
+
+            for (auto &value : std::span(values).subspan(first))
+            {
+                Read(input, value.AssemblyName);
+                Read(input, value.Namespace);
+                Read(input, value.ClassName);
+                Read(input, value.RefTypeHash);
+
+                if (transferFlags.has_value())
+                {
+                    value.Tree.RTTI = ReadRTTIIndex(input, rtti);
+                    value.Tree.TransferFlags = transferFlags.value();
+                }
+                else
+                {
+                    Read(input, value.Tree.RTTI);
+                    Read(input, value.Tree.TransferFlags);
+                }
+
+                if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes)
+                    ReadTypeHashes(input, value.Tree);
+
+                ReadTreeNodes(input, value.Tree, subtrees, strings, headerFlags);
+
+                if (!(headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes))
+                    ComputeTypeHashes(value.Tree, subtrees, strings);
+            }
+        });
+    }
+
+    // Blob indices are validated against the trees read before the section
+    inline void ReadSerializedBlobs(std::istream &input, std::vector<DumpedTypeTreeSerializedBlobs> &values, const size_t typeTreeCount, const size_t scriptCount)
+    {
+        uint32_t size;
+        ReadScalar(input, size);
+
+        values.resize(size);
+        for (auto &value : values)
+        {
+            Read(input, value.FormatVersion);
+
+            uint32_t blobCount;
+            ReadScalar(input, blobCount);
+
+            value.Blobs.resize(blobCount);
+            for (auto &blob : value.Blobs)
+            {
+                ReadBlob(input, blob);
+            }
+
+            Read(input, value.TypeTreeBlobs);
+            Read(input, value.ScriptBlobs);
+
+            const auto isValidIndex = [&](const uint32_t index)
+            {
+                return index == DumpedTypeTreeSerializedBlobs::kNoBlob || index < value.Blobs.size();
+            };
+
+            if (value.TypeTreeBlobs.size() != typeTreeCount || value.ScriptBlobs.size() != scriptCount
+                || !std::ranges::all_of(value.TypeTreeBlobs, isValidIndex) || !std::ranges::all_of(value.ScriptBlobs, isValidIndex))
+            {
+                throw std::runtime_error("Invalid serialized blob index");
+            }
+        }
+    }
+
+    inline void ReadColumnarTree(const DumpedTypeTreeColumnarView &view, const DumpedTypeTreeColumnarTree &record, DumpedTypeTree &value, const uint32_t headerFlags)
+    {
+        value.RTTI = {
+            .ClassName = std::string(view.GetString(record.ClassNameStringID)),
+            .ClassNamespace = std::string(view.GetString(record.ClassNamespaceStringID)),
+            .Module = std::string(view.GetString(record.ModuleStringID)),
+            .PersistentTypeID = record.PersistentTypeID,
+            .Size = record.Size,
+            .Flags = record.RTTIFlags,
+            .BasePersistentTypeID = record.BasePersistentTypeID,
+            .DerivedFromTypeIndex = record.DerivedFromTypeIndex,
+            .DerivedFromDescendantCount = record.DerivedFromDescendantCount,
+        };
+        value.TransferFlags = record.TransferFlags;
+
+        if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes)
+        {
+            std::ranges::copy(record.OldTypeHash, value.OldTypeHash.begin());
+            value.TypeHash = record.TypeHash;
+        }
+    }
+
+    // Node string IDs are pool IDs, which are interned into the string table on first use
+    inline void ReadColumnarNodes(const DumpedTypeTreeColumnarView &view, const DumpedTypeTreeColumnarTree &record, std::vector<DumpedTypeTreeNode> &values,
+        std::vector<uint32_t> &stringIDs, DumpedTypeTreeStringTable &strings, const uint32_t headerFlags)
+    {
+        const auto internString = [&](const uint32_t id)
+        {
+            if (id >= stringIDs.size())
+                throw std::runtime_error("Invalid string ID");
+
+            if (stringIDs[id] == DumpedTypeTreeNode::kNoNode)
+                stringIDs[id] = strings.Intern(view.GetString(id));
+
+            return stringIDs[id];
+        };
+
+        const auto columns = view.GetNodes(record);
+
+        values.resize(columns.Size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            auto &value = values[i];
+            value.TypeStringID = internString(columns.TypeStringIDs[i]);
+            value.NameStringID = internString(columns.NameStringIDs[i]);
+            value.Flags = columns.Flags[i];
+            value.ByteSize = columns.ByteSizes[i];
+            value.Index = columns.Indices[i];
+            value.Version = columns.Versions[i];
+            value.Level = columns.Levels[i];
+            value.MetaFlags = columns.MetaFlags[i];
+            value.RefTypeHash = columns.RefTypeHashes[i];
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+            {
+                value.TypeCommonOffset = columns.TypeCommonOffsets[i];
+                value.NameCommonOffset = columns.NameCommonOffsets[i];
+            }
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagByteOffsets)
+                value.ByteOffset = columns.ByteOffsets[i];
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagNavigation)
+            {
+                value.ParentIndex = columns.ParentIndices[i];
+                value.NextSiblingIndex = columns.NextSiblingIndices[i];
+                value.SubtreeNodeCount = columns.SubtreeNodeCounts[i];
+            }
+
+            if (headerFlags & DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes)
+                value.SubtreeHash = columns.SubtreeHashes[i];
+        }
+
+        FinishNodes(values, strings, headerFlags);
+    }
+
+    // Reads one of the sections holding a stream layout payload
+    template<typename TReadPayload>
+    inline void ReadColumnarSection(const DumpedTypeTreeColumnarView &view, const uint32_t tag, TReadPayload &&readPayload)
+    {
+        if (!view.HasSection(tag))
+            return;
+
+        std::ispanstream input(view.GetSectionData(tag));
+        readPayload(input);
+    }
+
+    // Reads a version 3 file into the same structures as the stream layout. The data must be aligned to 8 bytes.
+    inline void ReadColumnar(const std::span<const char> data, DumpedTypeTreeBinary &value)
+    {
+        using Section = DumpedTypeTreeColumnarSection;
+
+        const DumpedTypeTreeColumnarView view(data);
+        const auto &header = view.GetHeader();
+
+        if (header.Flags & ~kColumnarHeaderFlags)
+            throw std::runtime_error("Unsupported header flags");
+
+        // Optional columns must be present exactly when their flag is set
+        const auto hasColumns = [&](const uint32_t flag, const std::initializer_list<uint32_t> tags)
+        {
+            return std::ranges::all_of(tags, [&](const uint32_t tag) { return view.HasSection(tag) == ((header.Flags & flag) != 0); });
+        };
+
+        if (!hasColumns(DumpedTypeTreeHeader::kHeaderFlagCommonStrings, { Section::kSectionCommonStrings, Section::kSectionNodeTypeCommonOffsets, Section::kSectionNodeNameCommonOffsets })
+            || !hasColumns(DumpedTypeTreeHeader::kHeaderFlagByteOffsets, { Section::kSectionNodeByteOffsets })
+            || !hasColumns(DumpedTypeTreeHeader::kHeaderFlagNavigation, { Section::kSectionNodeParentIndices, Section::kSectionNodeNextSiblingIndices, Section::kSectionNodeSubtreeNodeCounts })
+            || !hasColumns(DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes, { Section::kSectionNodeSubtreeHashes }))
+        {
+            throw std::runtime_error("Node columns do not match the header flags");
+        }
+
+        value.Header = {
+            .Magic = header.Magic,
+            .Version = header.Version,
+            .MajorRevision = header.MajorRevision,
+            .MinorRevision = header.MinorRevision,
+            .PatchRevision = header.PatchRevision,
+            .Variant = std::string(view.GetString(header.VariantStringID)),
+            .Flags = header.Flags,
+        };
+
+        const auto commonStringBuffer = view.GetCommonStringBuffer();
+        value.CommonStringBuffer.assign(commonStringBuffer.begin(), commonStringBuffer.end());
+
+        std::vector stringIDs(view.GetStringCount(), DumpedTypeTreeNode::kNoNode);
+
+        // Trees sharing a node range share its nodes, which are only read once
+        std::map<std::pair<uint32_t, uint32_t>, const std::vector<DumpedTypeTreeNode> *> nodeRanges;
+
+        const auto readTree = [&](const DumpedTypeTreeColumnarTree &record, DumpedTypeTree &tree)
+        {
+            ReadColumnarTree(view, record, tree, header.Flags);
+
+            const auto [it, inserted] = nodeRanges.try_emplace({ record.FirstNode, record.NodeCount }, &tree.Nodes);
+            if (inserted)
+                ReadColumnarNodes(view, record, tree.Nodes, stringIDs, value.Strings, header.Flags);
+            else
+                tree.Nodes = *it->second;
+
+            if (!(header.Flags & DumpedTypeTreeHeader::kHeaderFlagTypeHashes))
+                ComputeTypeHashes(tree, value.Strings);
+
+            return inserted;
+        };
+
+        const auto typeTrees = view.GetTypeTrees();
+        value.TypeTrees.resize(typeTrees.size());
+        for (size_t i = 0; i < typeTrees.size(); i++)
+        {
+            // Type trees sharing the nodes of an earlier one were deduplicated, which the header records like the
+            // stream layout does so that the trees can be written again the same way
+            if (!readTree(typeTrees[i], value.TypeTrees[i]) && typeTrees[i].NodeCount != 0)
+                value.Header.Flags |= DumpedTypeTreeHeader::kHeaderFlagTreeReferences;
+        }
+
+        const auto scripts = view.GetScripts();
+        value.Scripts.resize(scripts.size());
+        for (size_t i = 0; i < scripts.size(); i++)
+        {
+            auto &script = value.Scripts[i];
+            script.AssemblyName = view.GetString(scripts[i].AssemblyNameStringID);
+            script.Namespace = view.GetString(scripts[i].NamespaceStringID);
+            script.ClassName = view.GetString(scripts[i].ClassNameStringID);
+            script.RefTypeHash = scripts[i].RefTypeHash;
+            readTree(scripts[i].Tree, script.Tree);
+        }
+
+        ReadColumnarSection(view, Section::kSectionShard, [&](std::istream &input)
+        {
+            Read(input, value.Shard.emplace());
+        });
+
+        ReadColumnarSection(view, Section::kSectionHierarchy, [&](std::istream &input)
+        {
+            Read(input, value.Hierarchy.emplace());
+        });
+
+        ReadColumnarSection(view, Section::kSectionSerializedBlobs, [&](std::istream &input)
+        {
+            ReadSerializedBlobs(input, value.SerializedBlobs, value.TypeTrees.size(), value.Scripts.size());
+        });
+    }
+
+    // Shared subtrees are expanded into every tree unless expandSubtreeReferences is false, in which case the trees
+    // are left compact and the pool is kept in the binary for ExpandSubtreeReferences
+    // Reads the rest of a file in the stream layout following its header
+    inline void ReadStream(std::istream &input, DumpedTypeTreeBinary &value, const bool expandSubtreeReferences)
+    {
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagStringTable)
+            ReadStringTable(input, value.Strings);
+
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+            ReadBlob(input, value.CommonStringBuffer);
+
+        SubtreePool subtrees;
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences)
+        {
+            ReadSubtrees(input, subtrees.Subtrees, value.Strings, value.Header.Flags);
+
+            if (expandSubtreeReferences)
+                subtrees.ExpandSubtrees();
+            else
+                subtrees.ExpandReferences = false;
+        }
+
+        std::vector<DumpedTypeTreeRTTI> rtti;
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagTreeSets)
+            ReadRTTITable(input, rtti);
+
+        ReadTypeTrees(input, value.TypeTrees, subtrees, rtti, value.Strings, value.Header.Flags);
+
+        DumpedTypeTreeSectionHeader section;
+        while (input.read(reinterpret_cast<char *>(&section.Tag), sizeof(section.Tag)))
+        {
+            Read(input, section.Size);
+
+            const auto payloadPosition = input.tellg();
+            switch (section.Tag)
+            {
+            case DumpedTypeTreeSectionHeader::kSectionShard:
+                Read(input, value.Shard.emplace());
+                break;
+            case DumpedTypeTreeSectionHeader::kSectionHierarchy:
+                Read(input, value.Hierarchy.emplace());
+                break;
+            case DumpedTypeTreeSectionHeader::kSectionScripts:
+                ReadScripts(input, value.Scripts, subtrees, rtti, value.Strings, value.Header.Flags);
+                break;
+            case DumpedTypeTreeSectionHeader::kSectionSerializedBlobs:
+                ReadSerializedBlobs(input, value.SerializedBlobs, value.TypeTrees.size(), value.Scripts.size());
+                break;
+            default:
+                break;
+            }
+
+            input.seekg(payloadPosition + static_cast<std::streamoff>(section.Size));
+        }
+
+        if (!subtrees.ExpandReferences)
+            value.Subtrees = std::move(subtrees.Subtrees);
+    }
+
+    inline void ReadBinary(std::istream &input, DumpedTypeTreeBinary &value, const bool expandSubtreeReferences)
+    {
+        // The columnar layout is located through its section table and compressed blocks through their block table,
+        // so both are read from memory rather than as a stream
+        const auto start = input.tellg();
+
+        uint64_t magic;
+        uint32_t version;
+        ReadScalar(input, magic);
+        ReadScalar(input, version);
+
+        const auto readAll = [&]
+        {
+            input.seekg(0, std::ios::end);
+            const auto size = static_cast<size_t>(input.tellg() - start);
+            input.seekg(start);
+
+            std::vector<uint64_t> data((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+            if (!input.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size)))
+                throw std::runtime_error("Unexpected end of file");
+
+            return std::make_pair(std::move(data), size);
+        };
+
+        if (magic == DumpedTypeTreeHeader::kDefaultMagic && version == DumpedTypeTreeHeader::kVersion3)
+        {
+            const auto [data, size] = readAll();
+            ReadColumnar({ reinterpret_cast<const char *>(data.data()), size }, value);
+            return;
+        }
+
+        if (magic == DumpedTypeTreeHeader::kDefaultMagic && version == DumpedTypeTreeHeader::kVersion4)
+        {
+            const auto [data, size] = readAll();
+            DumpedTypeTreeBlockView view({ reinterpret_cast<const char *>(data.data()), size });
+            const auto uncompressed = view.ReadAll();
+
+            // Every level of nesting could expand the file again
+            if (uncompressed.size() >= sizeof(magic) + sizeof(version)
+                && block_compression_details::LoadScalar<uint32_t>(uncompressed.data() + sizeof(magic)) == DumpedTypeTreeHeader::kVersion4)
+            {
+                throw std::runtime_error("Nested compressed files are not supported");
+            }
+
+            std::ispanstream stream(uncompressed);
+            ReadBinary(stream, value, expandSubtreeReferences);
+            value.CompressionBlockSize = view.GetHeader().BlockSize;
+            return;
+        }
+
+        input.seekg(start);
+        Read(input, value.Header);
+
+        if (value.Header.Magic != DumpedTypeTreeHeader::kDefaultMagic)
+            throw std::runtime_error("Invalid magic number");
+
+        if (value.Header.Version != DumpedTypeTreeHeader::kVersion1 && value.Header.Version != DumpedTypeTreeHeader::kVersion2)
+            throw std::runtime_error("Unsupported version");
+
+        if (value.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagChecksums)
+        {
+            // The whole file is checked before any of it is parsed, so that a damaged file is rejected rather than misread
+            const auto headerSize = input.tellg() - start;
+            const auto [data, size] = readAll();
+            const std::span file(reinterpret_cast<const char *>(data.data()), size);
+
+            VerifyStreamChecksums(file);
+
+            std::ispanstream stream(file);
+            stream.seekg(headerSize);
+            ReadStream(stream, value, expandSubtreeReferences);
+            return;
+        }
+
+        ReadStream(input, value, expandSubtreeReferences);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeBinary &value)
+    {
+        ReadBinary(input, value, true);
+    }
+}
+
+// Reads a binary leaving the trees of a file written with kHeaderFlagSubtreeReferences compact, which keeps each
+// shared subtree in memory once. Their nodes are materialized on demand with ExpandSubtreeReferences.
+inline void ReadCompact(std::istream &input, DumpedTypeTreeBinary &value)
+{
+    internal::ReadBinary(input, value, false);
+}
+
+// Returns the nodes of a tree read by ReadCompact, expanding only the shared subtrees the tree uses
+inline std::vector<DumpedTypeTreeNode> ExpandSubtreeReferences(const DumpedTypeTreeBinary &binary, const DumpedTypeTree &tree)
+{
+    if (tree.CompactNodes.NodeCount == 0)
+        return tree.Nodes;
+
+    auto nodes = subtree_reference_details::ExpandUsed(binary.Subtrees, tree.CompactNodes);
+    internal::FinishNodes(nodes, binary.Strings, binary.Header.Flags);
+    return nodes;
+}
+
+// Checks a whole file in memory against its checksums, and throws if it is damaged or was written without them.
+// Compressed files are checked block by block without decompressing them. The data must be aligned to 8 bytes.
+inline void VerifyChecksums(const std::span<const char> data)
+{
+    using block_compression_details::LoadScalar;
+
+    if (data.size() < sizeof(uint64_t) + sizeof(uint32_t) || LoadScalar<uint64_t>(data.data()) != DumpedTypeTreeHeader::kDefaultMagic)
+        throw std::runtime_error("Invalid magic number");
+
+    const auto version = LoadScalar<uint32_t>(data.data() + sizeof(uint64_t));
+    if (version == DumpedTypeTreeHeader::kVersion3)
+    {
+        DumpedTypeTreeColumnarView(data).VerifyChecksums();
+        return;
+    }
+
+    if (version == DumpedTypeTreeHeader::kVersion4)
+    {
+        DumpedTypeTreeBlockView(data).VerifyChecksums();
+        return;
+    }
+
+    if (version != DumpedTypeTreeHeader::kVersion1 && version != DumpedTypeTreeHeader::kVersion2)
+        throw std::runtime_error("Unsupported version");
+
+    std::ispanstream input(data);
+    DumpedTypeTreeHeader header;
+    internal::Read(input, header);
+
+    if (!(header.Flags & DumpedTypeTreeHeader::kHeaderFlagChecksums))
+        throw std::runtime_error("The file has no checksums");
+
+    internal::VerifyStreamChecksums(data);
+}
+
+// Returns the trees dumped with the given transfer flags, such as kTransferFlagSerializeGameRelease for the release
+// trees of an editor run, or nothing if no set has them. Works on any file, whether it was written with
+// kHeaderFlagTreeSets or not.
+inline std::span<const DumpedTypeTree> SelectTypeTrees(const DumpedTypeTreeBinary &binary, const std::underlying_type_t<DumpedTransferInstructionFlags> transferFlags)
+{
+    for (const auto &set : GetTreeSets(binary.TypeTrees))
+    {
+        if (set.TransferFlags == transferFlags)
+            return std::span(binary.TypeTrees).subspan(set.First, set.Count);
+    }
+
+    return {};
+}
+
+inline std::span<const DumpedTypeTreeScript> SelectScripts(const DumpedTypeTreeBinary &binary, const std::underlying_type_t<DumpedTransferInstructionFlags> transferFlags)
+{
+    for (const auto &set : GetTreeSets(binary.Scripts))
+    {
+        if (set.TransferFlags == transferFlags)
+            return std::span(binary.Scripts).subspan(set.First, set.Count);
+    }
+
+    return {};
+}
@@ -1,275 +1,20 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
-#include <fstream>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "common.hpp"
 #include "RTTI.hpp"
 #include "TypeTree.hpp"
-#undef max
-
-//
-// .ttbin binary layout:
-// TypeTreeHeader
-// TypeTreeRTTI[RTTICount]
-// TypeTreeNode[NodesCount]
-//
-
-struct DumpedTypeTreeHeader
-{
-    // 'TYPETREE' in little-endian
-    static constexpr auto kDefaultMagic = 0x4545525445505954;
-
-    uint64_t Magic;
-    uint32_t Version;
-
-    // Revision
-    uint16_t MajorRevision;
-    uint8_t MinorRevision;
-    uint8_t PatchRevision;
-
-    std::string Variant;
-};
-
-struct DumpedTypeTreeRTTI
-{
-    static constexpr auto kInvalid = std::numeric_limits<uint32_t>::max();
-
-    std::string ClassName;
-    std::string ClassNamespace;
-    std::string Module;
-    int32_t PersistentTypeID;
-    int32_t Size;
-
-    enum Flags : uint32_t
-    {
-        kRTTIFlagIsAbstract = 1 << 0,
-        kRTTIFlagIsSealed = 1 << 1,
-        kRTTIFlagIsEditorOnly = 1 << 2,
-        kRTTIFlagIsStripped = 1 << 3,
-        kRTTIFlagIsDeprecated  = 1 << 4,
-    };
-    std::underlying_type_t<Flags> Flags;
-
-    uint32_t BasePersistentTypeID = kInvalid;
-    uint32_t DerivedFromTypeIndex = kInvalid;
-    uint32_t DerivedFromDescendantCount = kInvalid;
-};
-
-struct DumpedTypeTreeNode
-{
-    std::string Type;
-    std::string Name;
-
-    enum Flags : uint32_t
-    {
-        kNodeFlagIsArray = 1 << 0,
-        kNodeFlagIsManagedReference = 1 << 1,
-        kNodeFlagIsManagedReferenceRegistry = 1 << 2,
-        kNodeFlagIsArrayOfRefs = 1 << 3,
-    };
-    std::underlying_type_t<Flags> Flags;
-    int32_t ByteSize;
-    int32_t Index;
-
-    int16_t Version;
-    uint8_t Level;
-
-    enum MetaFlags : uint32_t
-    {
-        kNodeMetaFlagHideInEditor = 1 << 0,
-        // ?
-        // ?
-        // ?
-        kNodeMetaFlagNotEditable = 1 << 4,
-        kNodeMetaFlagReorderable = 1 << 5,
-        kNodeMetaFlagStrongPPtr = 1 << 6,
-        // ?
-        kNodeMetaFlagTreatIntegerValueAsBoolean = 1 << 8,
-        // ?
-        // ?
-        kNodeMetaFlagSimpleEditor = 1 << 11,
-        kNodeMetaFlagDebugProperty = 1 << 12,
-        // ?
-        kNodeMetaFlagAlignBytes = 1 << 14,
-        kNodeMetaFlagAnyChildUsesAlignBytes = 1 << 15,
-        kNodeMetaFlagIgnoreWithInspectorUndo = 1 << 16,
-        // ?
-        kNodeMetaFlagEditorDisplaysCharacterMap = 1 << 18,
-        kNodeMetaFlagIgnoreInMetaFiles = 1 << 19,
-        kNodeMetaFlagTransferAsArrayEntryNameInMetaFiles = 1 << 20,
-        kNodeMetaFlagTransferUsingFlowMappingStyle = 1 << 21,
-        kNodeMetaFlagGenerateBitwiseDifferences = 1 << 22,
-        kNodeMetaFlagDontAnimate = 1 << 23,
-        kNodeMetaFlagTransferHex64 = 1 << 24,
-        kNodeMetaFlagCharProperty = 1 << 25,
-        kNodeMetaFlagDontValidateUTF8 = 1 << 26,
-        kNodeMetaFlagFixedBuffer = 1 << 27,
-        kNodeMetaFlagDisallowSerializedPropertyModification = 1 << 28
-    };
-    std::underlying_type_t<MetaFlags> MetaFlags;
-    uint64_t RefTypeHash;
-};
-
-enum DumpedTransferInstructionFlags : uint64_t
-{
-    kTransferFlagReadWriteFromSerializedFile = 1 << 0,
-    kTransferFlagAssetMetaDataOnly = 1 << 1,
-    kTransferFlagHandleDrivenProperties = 1 << 2,
-    kTransferFlagLoadAndUnloadAssetsDuringBuild = 1 << 3,
-    kTransferFlagSerializeDebugProperties = 1 << 4,
-    kTransferFlagIgnoreDebugPropertiesForIndex = 1 << 5,
-    kTransferFlagBuildPlayerOnlySerializeBuildProperties = 1 << 6,
-    kTransferFlagIsCloningObject = 1 << 7,
-    kTransferFlagSerializeGameRelease = 1 << 8,
-    kTransferFlagSwapEndianness = 1 << 9,
-    kTransferFlagResolveStreamedResourceSources = 1 << 10,
-    kTransferFlagDontReadObjectsFromDiskBeforeWriting = 1 << 11,
-    kTransferFlagSerializeMonoReload = 1 << 12,
-    kTransferFlagDontRequireAllMetaFlags = 1 << 13,
-    kTransferFlagSerializeForPrefabSystem = 1 << 14,
-    kTransferFlagSerializeForSlimPlayer = 1 << 15,
-    kTransferFlagLoadPrefabAsScene = 1 << 16,
-    kTransferFlagSerializeCopyPasteTransfer = 1 << 17,
-    kTransferFlagSkipSerializeToTempFile = 1 << 18,
-    kTransferFlagBuildResourceImage = 1 << 19,
-    kTransferFlagDontWriteUnityVersion = 1 << 20,
-    kTransferFlagSerializeEditorMinimalScene = 1 << 21,
-    kTransferFlagGenerateBakedPhysixMeshes = 1 << 22,
-    kTransferFlagThreadedSerialization = 1 << 23,
-    kTransferFlagIsBuiltinResourcesFile = 1 << 24,
-    kTransferFlagPerformUnloadDependencyTracking = 1 << 25,
-    kTransferFlagDisableWriteTypeTree = 1 << 26,
-    kTransferFlagAutoreplaceEditorWindow = 1 << 27,
-    kTransferFlagDontCreateMonoBehaviorScriptWrapper = 1 << 28,
-    kTransferFlagSerializeForInspector = 1 << 29,
-    kTransferFlagSerializedAssetBundleVersion = 1 << 30,
-    kTransferFlagAllowTextSerialization = 1LL << 31,
-    kTransferFlagIgnoreSerializeReferenceMissingType = 1LL << 32,
-    kTransferFlagDontUpdateTransformRootOrderOnTypes = 1LL << 33,
-    kTransferFlagSerializingForDevelopmentBuild = 1LL << 34,
-    kTransferFlagSerializingFQN = 1LL << 35
-};
-
-struct DumpedTypeTree
-{
-    DumpedTypeTreeRTTI RTTI;
-    std::underlying_type_t<DumpedTransferInstructionFlags> TransferFlags;
-
-    std::vector<DumpedTypeTreeNode> Nodes;
-};
-
-namespace internal
-{
-    template<typename T>
-    inline void Write(std::ofstream &output, const T &value)
-    {
-        // needed to workaround clang bug(?)
-        // ReSharper disable once CppStaticAssertFailure
-        static_assert(false, "No default specialization available for Write()");
-    }
-
-    template<typename T>
-    inline void Write(std::ofstream &output, const std::vector<T> &values)
-    {
-        Write(output, static_cast<uint32_t>(values.size()));
-        for (const auto &value : values)
-        {
-            Write(output, value);
-        }
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const int32_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const int16_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const uint64_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const uint32_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const uint16_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const uint8_t &value)
-    {
-        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const std::string &value)
-    {
-        const auto size = static_cast<uint32_t>(value.size());
-        Write(output, size);
-        output.write(value.c_str(), size);
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const DumpedTypeTreeHeader &value)
-    {
-        Write(output, value.Magic);
-        Write(output, value.Version);
-        Write(output, value.MajorRevision);
-        Write(output, value.MinorRevision);
-        Write(output, value.PatchRevision);
-        Write(output, value.Variant);
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const DumpedTypeTreeRTTI &value)
-    {
-        Write(output, value.ClassName);
-        Write(output, value.ClassNamespace);
-        Write(output, value.Module);
-        Write(output, value.PersistentTypeID);
-        Write(output, value.Size);
-        Write(output, value.Flags);
-        Write(output, value.BasePersistentTypeID);
-        Write(output, value.DerivedFromTypeIndex);
-        Write(output, value.DerivedFromDescendantCount);
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const DumpedTypeTreeNode &value)
-    {
-        Write(output, value.Type);
-        Write(output, value.Name);
-        Write(output, value.Flags);
-        Write(output, value.ByteSize);
-        Write(output, value.Index);
-        Write(output, value.Version);
-        Write(output, value.Level);
-        Write(output, value.MetaFlags);
-        Write(output, value.RefTypeHash);
-    }
-
-    template<>
-    inline void Write(std::ofstream &output, const DumpedTypeTree &value)
-    {
-        Write(output, value.RTTI);
-        Write(output, value.TransferFlags);
-        Write(output, value.Nodes);
-    }
-}
+#include "binary_format.hpp"
+#include "flag_translation.hpp"
+#include "output_buffer.hpp"
+#include "scripting.hpp"
+#include "serialized_blob.hpp"
+#include "trace.hpp"
 
 template<Revision R, Variant V>
 class DumpedTypeTreeWriter
@@ -283,8 +28,39 @@ class DumpedTypeTreeWriter
 
 #define IF_HAS_MEMBER(Var, MemberName) if constexpr (requires { (Var).MemberName; })
 #define IF_HAS_MEMBER_PTR(Var, MemberName) if constexpr (requires { (Var)->MemberName; })
-#define IF_HAS_ENUM_FLAG(Var, EnumName, Result, ResultEnumName) if ((Var) & (EnumName)) (Result) |= ResultEnumName
 
+    static constexpr auto kMetaFlagTranslation = MakeFlagTranslation({
+        { TransferMetaFlags::kHideInEditorMask, DumpedTypeTreeNode::kNodeMetaFlagHideInEditor },
+        { TransferMetaFlags::kNotEditableMask, DumpedTypeTreeNode::kNodeMetaFlagNotEditable },
+        { TransferMetaFlags::kReorderable, DumpedTypeTreeNode::kNodeMetaFlagReorderable },
+        { TransferMetaFlags::kStrongPPtrMask, DumpedTypeTreeNode::kNodeMetaFlagStrongPPtr },
+        { TransferMetaFlags::kTreatIntegerValueAsBoolean, DumpedTypeTreeNode::kNodeMetaFlagTreatIntegerValueAsBoolean },
+        { TransferMetaFlags::kSimpleEditorMask, DumpedTypeTreeNode::kNodeMetaFlagSimpleEditor },
+        { TransferMetaFlags::kDebugPropertyMask, DumpedTypeTreeNode::kNodeMetaFlagDebugProperty },
+        { TransferMetaFlags::kAlignBytesFlag, DumpedTypeTreeNode::kNodeMetaFlagAlignBytes },
+        { TransferMetaFlags::kIgnoreWithInspectorUndoMask, DumpedTypeTreeNode::kNodeMetaFlagIgnoreWithInspectorUndo },
+        { TransferMetaFlags::kAnyChildUsesAlignBytesFlag, DumpedTypeTreeNode::kNodeMetaFlagAnyChildUsesAlignBytes },
+        { TransferMetaFlags::kEditorDisplaysCharacterMap, DumpedTypeTreeNode::kNodeMetaFlagEditorDisplaysCharacterMap },
+        { TransferMetaFlags::kIgnoreInMetaFiles, DumpedTypeTreeNode::kNodeMetaFlagIgnoreInMetaFiles },
+        { TransferMetaFlags::kTransferAsArrayEntryNameInMetaFiles, DumpedTypeTreeNode::kNodeMetaFlagTransferAsArrayEntryNameInMetaFiles },
+        { TransferMetaFlags::kTransferUsingFlowMappingStyle, DumpedTypeTreeNode::kNodeMetaFlagTransferUsingFlowMappingStyle },
+        { TransferMetaFlags::kGenerateBitwiseDifferences, DumpedTypeTreeNode::kNodeMetaFlagGenerateBitwiseDifferences },
+        { TransferMetaFlags::kDontAnimate, DumpedTypeTreeNode::kNodeMetaFlagDontAnimate },
+        { TransferMetaFlags::kTransferHex64, DumpedTypeTreeNode::kNodeMetaFlagTransferHex64 },
+        { TransferMetaFlags::kCharPropertyMask, DumpedTypeTreeNode::kNodeMetaFlagCharProperty },
+        { TransferMetaFlags::kDontValidateUTF8, DumpedTypeTreeNode::kNodeMetaFlagDontValidateUTF8 },
+        { TransferMetaFlags::kFixedBufferFlag, DumpedTypeTreeNode::kNodeMetaFlagFixedBuffer },
+        { TransferMetaFlags::kDisallowSerializedPropertyModification, DumpedTypeTreeNode::kNodeMetaFlagDisallowSerializedPropertyModification },
+    });
+    static_assert(kMetaFlagTranslation.IsValid(), "TransferMetaFlags do not translate into the dumped meta flags");
+
+    static constexpr auto kTransferFlagTranslation = MakeFlagTranslation({
+        { TransferInstructionFlags::kSerializeGameRelease, DumpedTransferInstructionFlags::kTransferFlagSerializeGameRelease },
+    });
+    static_assert(kTransferFlagTranslation.IsValid(), "TransferInstructionFlags do not translate into the dumped transfer flags");
+
+public:
+    // Also used by RawCaptureWriter, as RTTI records hold pointers into the engine
     static void ConvertRTTI(const RTTI* rtti, DumpedTypeTreeRTTI &dumpedRtti)
     {
         dumpedRtti = {};
@@ -338,10 +114,11 @@ class DumpedTypeTreeWriter
 
         // NOTE: Do we also want to output attributes?
     }
+private:
 
-    static void ConvertNode(const TypeTreeNode& node, DumpedTypeTreeNode& dumpedNode, char const* stringBuffer, char const* commonStringBuffer)
+    void ConvertNode(const TypeTreeNode& node, DumpedTypeTreeNode& dumpedNode, char const* stringBuffer, char const* commonStringBuffer)
     {
-        const auto getStringBufferString = [stringBuffer, commonStringBuffer](const uint32_t offset) -> std::string
+        const auto getStringBufferString = [stringBuffer, commonStringBuffer](const uint32_t offset) -> std::string_view
         {
             if ((offset & 0x80000000) == 0)
             {
@@ -353,46 +130,41 @@ class DumpedTypeTreeWriter
 
         dumpedNode = {};
 
-        dumpedNode.Name = getStringBufferString(node.m_NameStrOffset);
-        dumpedNode.Type = getStringBufferString(node.m_TypeStrOffset);
+        const auto getCommonOffset = [](const uint32_t offset)
+        {
+            return (offset & 0x80000000) != 0 ? offset & ~0x80000000 : DumpedTypeTreeNode::kNotCommonString;
+        };
+
+        dumpedNode.TypeStringID = Strings.Intern(getStringBufferString(node.m_TypeStrOffset));
+        dumpedNode.NameStringID = Strings.Intern(getStringBufferString(node.m_NameStrOffset));
+        dumpedNode.TypeCommonOffset = getCommonOffset(node.m_TypeStrOffset);
+        dumpedNode.NameCommonOffset = getCommonOffset(node.m_NameStrOffset);
         dumpedNode.ByteSize = node.m_ByteSize;
         dumpedNode.Index = node.m_Index;
         dumpedNode.Level = node.m_Level;
         dumpedNode.Version = node.m_Version;
 
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kHideInEditorMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagHideInEditor);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kNotEditableMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagNotEditable);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kReorderable, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagReorderable);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kStrongPPtrMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagStrongPPtr);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kTreatIntegerValueAsBoolean, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagTreatIntegerValueAsBoolean);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kSimpleEditorMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagSimpleEditor);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kDebugPropertyMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagDebugProperty);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kAlignBytesFlag, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagAlignBytes);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kIgnoreWithInspectorUndoMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagIgnoreWithInspectorUndo);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kAnyChildUsesAlignBytesFlag, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagAnyChildUsesAlignBytes);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kEditorDisplaysCharacterMap, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagEditorDisplaysCharacterMap);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kIgnoreInMetaFiles, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagIgnoreInMetaFiles);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kTransferAsArrayEntryNameInMetaFiles, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagTransferAsArrayEntryNameInMetaFiles);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kTransferUsingFlowMappingStyle, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagTransferUsingFlowMappingStyle);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kGenerateBitwiseDifferences, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagGenerateBitwiseDifferences);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kDontAnimate, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagDontAnimate);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kTransferHex64, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagTransferHex64);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kCharPropertyMask, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagCharProperty);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kDontValidateUTF8, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagDontValidateUTF8);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kFixedBufferFlag, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagFixedBuffer);
-        IF_HAS_ENUM_FLAG(node.m_MetaFlag, TransferMetaFlags::kDisallowSerializedPropertyModification, dumpedNode.MetaFlags, DumpedTypeTreeNode::kNodeMetaFlagDisallowSerializedPropertyModification);
+        dumpedNode.MetaFlags = static_cast<uint32_t>(TranslateFlags<kMetaFlagTranslation>(node.m_MetaFlag));
 
+        // Before 2019.1 nodes store the array flag as a byte of its own, which is zero for all but array nodes
         IF_HAS_MEMBER(node, m_IsArray)
         {
-            dumpedNode.Flags |= DumpedTypeTreeNode::kNodeFlagIsArray;
+            if (node.m_IsArray)
+                dumpedNode.Flags |= DumpedTypeTreeNode::kNodeFlagIsArray;
         }
 
         IF_HAS_MEMBER(node, m_TypeFlags)
         {
-            IF_HAS_ENUM_FLAG(node.m_TypeFlags, TypeTreeNode::kFlagIsArray, dumpedNode.Flags, DumpedTypeTreeNode::kNodeFlagIsArray);
-            IF_HAS_ENUM_FLAG(node.m_TypeFlags, TypeTreeNode::kFlagIsManagedReference, dumpedNode.Flags, DumpedTypeTreeNode::kNodeFlagIsManagedReference);
-            IF_HAS_ENUM_FLAG(node.m_TypeFlags, TypeTreeNode::kFlagIsManagedReferenceRegistry, dumpedNode.Flags, DumpedTypeTreeNode::kNodeFlagIsManagedReferenceRegistry);
-            IF_HAS_ENUM_FLAG(node.m_TypeFlags, TypeTreeNode::kFlagIsArrayOfRefs, dumpedNode.Flags, DumpedTypeTreeNode::kNodeFlagIsArrayOfRefs);
+            // Only nodes with m_TypeFlags declare these, so the translation cannot be a class member
+            static constexpr auto kTypeFlagTranslation = MakeFlagTranslation({
+                { TypeTreeNode::kFlagIsArray, DumpedTypeTreeNode::kNodeFlagIsArray },
+                { TypeTreeNode::kFlagIsManagedReference, DumpedTypeTreeNode::kNodeFlagIsManagedReference },
+                { TypeTreeNode::kFlagIsManagedReferenceRegistry, DumpedTypeTreeNode::kNodeFlagIsManagedReferenceRegistry },
+                { TypeTreeNode::kFlagIsArrayOfRefs, DumpedTypeTreeNode::kNodeFlagIsArrayOfRefs },
+            });
+            static_assert(kTypeFlagTranslation.IsValid(), "TypeTreeNode flags do not translate into the dumped node flags");
+
+            dumpedNode.Flags |= static_cast<uint32_t>(TranslateFlags<kTypeFlagTranslation>(node.m_TypeFlags));
         }
 
         IF_HAS_MEMBER(node, m_RefTypeHash)
@@ -404,17 +176,15 @@ class DumpedTypeTreeWriter
     static void ConvertTransferInstructionFlags(const TransferInstructionFlags& flags, std::underlying_type_t<DumpedTransferInstructionFlags>& dumpedFlags)
     {
         // TODO: Add proper parsing for these
-        IF_HAS_ENUM_FLAG(flags, TransferInstructionFlags::kSerializeGameRelease, dumpedFlags, DumpedTransferInstructionFlags::kTransferFlagSerializeGameRelease);
+        dumpedFlags |= TranslateFlags<kTransferFlagTranslation>(flags);
     }
 
 #undef IF_HAS_MEMBER
 #undef IF_HAS_MEMBER_PTR
-#undef IF_HAS_ENUM_FLAG
 
-public:
-    void Add(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, char const* commonStringBuffer)
+    void ConvertTree(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, char const* commonStringBuffer, DumpedTypeTree& dumpedTree)
     {
-        DumpedTypeTree dumpedTree{};
+        dumpedTree = {};
 
         ConvertRTTI(rtti, dumpedTree.RTTI);
 
@@ -424,32 +194,459 @@ public:
         {
             const auto stringBuffer = tree.StringsBuffer();
             const auto nodes = tree.Nodes();
+            const auto byteOffsets = tree.ByteOffsets();
+
+            std::span<const int32_t> nextIndex;
+            if constexpr (requires { tree.GetData()->NextIndex(); })
+            {
+                nextIndex = { tree.GetData()->NextIndex().data(), tree.GetData()->NextIndex().size() };
+            }
+
+            ConvertNodes({ nodes.data(), nodes.size() }, stringBuffer.data(), commonStringBuffer, { byteOffsets.data(), byteOffsets.size() }, nextIndex, dumpedTree.Nodes);
+        }
+    }
+
+    // The engine's byte offsets are used when it computed one for every node, with UINT32_MAX marking unknown offsets.
+    // Its next indices are only kept by revisions from 2022.3 on, the navigation is computed from the levels otherwise.
+    void ConvertNodes(const std::span<const TypeTreeNode> nodes, char const* stringBuffer, char const* commonStringBuffer, const std::span<const uint32_t> byteOffsets, const std::span<const int32_t> nextIndex, std::vector<DumpedTypeTreeNode>& dumpedNodes)
+    {
+        dumpedNodes = std::vector<DumpedTypeTreeNode>(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            ConvertNode(nodes[i], dumpedNodes[i], stringBuffer, commonStringBuffer);
+        }
 
-            dumpedTree.Nodes = std::vector<DumpedTypeTreeNode>(nodes.size());
+        // Readers leave the offsets unknown when they are not stored. Shared subtrees are compared with their offsets,
+        // so the writer must do the same for the merge command to pool them as an unsharded dump does.
+        if (UseByteOffsets && byteOffsets.size() == nodes.size())
+        {
             for (size_t i = 0; i < nodes.size(); i++)
             {
-                ConvertNode(nodes[i], dumpedTree.Nodes[i], stringBuffer.data(), commonStringBuffer);
+                dumpedNodes[i].ByteOffset = byteOffsets[i];
             }
         }
+        else if (UseByteOffsets)
+        {
+            ComputeStaticByteOffsets(dumpedNodes);
+        }
+
+        if (UseNavigation || NeedsSubtreeHashes())
+            ComputeNodeNavigation(dumpedNodes, nextIndex);
+
+        if (NeedsSubtreeHashes())
+            ComputeSubtreeHashes(dumpedNodes, Strings);
+    }
+
+    // Deduplication and subtree references find equal trees and subtrees by their sizes and hashes
+    bool NeedsSubtreeHashes() const
+    {
+        return UseSubtreeHashes || DeduplicateTrees || UseSubtreeReferences;
+    }
+
+    // Trees captured with RawCaptureWriter keep their RTTI in its dumped form, and no nodes for types without a tree
+    void ConvertCapturedTree(const DumpedTypeTreeRTTI& rtti, const TransferInstructionFlags& flags, const std::span<const TypeTreeNode> nodes, char const* stringBuffer, char const* commonStringBuffer, const std::span<const uint32_t> byteOffsets, const std::span<const int32_t> nextIndex, DumpedTypeTree& dumpedTree)
+    {
+        dumpedTree = {};
+        dumpedTree.RTTI = rtti;
+
+        ConvertTransferInstructionFlags(flags, dumpedTree.TransferFlags);
+        ConvertNodes(nodes, stringBuffer, commonStringBuffer, byteOffsets, nextIndex, dumpedTree.Nodes);
+    }
+
+    void AddTree(DumpedTypeTree&& dumpedTree)
+    {
+        if (UseTypeHashes)
+            ComputeTypeHashes(dumpedTree, Strings);
 
         TypeTrees.push_back(std::move(dumpedTree));
+
+        if (DeduplicateTrees)
+            Deduplicator.AddLast(TypeTrees);
+    }
+
+    void AddScript(DumpedTypeTreeScript&& script)
+    {
+        if (!script.Tree.Nodes.empty())
+            script.RefTypeHash = script.Tree.Nodes[0].RefTypeHash;
+
+        if (UseTypeHashes)
+            ComputeTypeHashes(script.Tree, Strings);
+
+        Scripts.push_back(std::move(script));
+    }
+
+public:
+    void Add(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, char const* commonStringBuffer)
+    {
+        DumpedTypeTree dumpedTree;
+        ConvertTree(rtti, tree, flags, commonStringBuffer, dumpedTree);
+        AddTree(std::move(dumpedTree));
+    }
+
+    // Adds a tree from the verbatim engine node array and string buffer of a raw capture
+    void AddCaptured(const DumpedTypeTreeRTTI& rtti, const TransferInstructionFlags& flags, const std::span<const TypeTreeNode> nodes, char const* stringBuffer, char const* commonStringBuffer, const std::span<const uint32_t> byteOffsets, const std::span<const int32_t> nextIndex)
+    {
+        DumpedTypeTree dumpedTree;
+        ConvertCapturedTree(rtti, flags, nodes, stringBuffer, commonStringBuffer, byteOffsets, nextIndex, dumpedTree);
+        AddTree(std::move(dumpedTree));
+    }
+
+    // Adds a type whose tree is generated by the same transfer implementation as an already added type.
+    // Such trees only differ in the root node's type name, so the source tree is copied and patched.
+    void AddReused(const RTTI* rtti, const TransferInstructionFlags& flags, const size_t sourceIndex)
+    {
+        DumpedTypeTreeRTTI dumpedRtti;
+        ConvertRTTI(rtti, dumpedRtti);
+        AddReused(dumpedRtti, flags, sourceIndex);
+    }
+
+    void AddReused(const DumpedTypeTreeRTTI& rtti, const TransferInstructionFlags& flags, const size_t sourceIndex)
+    {
+        DumpedTypeTree dumpedTree{};
+        dumpedTree.RTTI = rtti;
+
+        ConvertTransferInstructionFlags(flags, dumpedTree.TransferFlags);
+
+        dumpedTree.Nodes = GetNodes(sourceIndex);
+
+        if (!dumpedTree.Nodes.empty())
+        {
+            dumpedTree.Nodes[0].TypeStringID = Strings.Intern(rtti.ClassName);
+            dumpedTree.Nodes[0].TypeCommonOffset = GetCommonOffset(rtti.ClassName);
+
+            if (NeedsSubtreeHashes())
+                dumpedTree.Nodes[0].SubtreeHash = HashSubtree(dumpedTree.Nodes, 0, Strings);
+        }
+
+        AddTree(std::move(dumpedTree));
+    }
+
+    // Adds the tree of a managed class, generated through the native MonoBehaviour or ScriptableObject type
+    void AddScript(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, char const* commonStringBuffer, const ScriptingClass& scriptingClass)
+    {
+        DumpedTypeTreeScript script{
+            .AssemblyName = scriptingClass.AssemblyName,
+            .Namespace = scriptingClass.Namespace,
+            .ClassName = scriptingClass.ClassName,
+            .RefTypeHash = 0,
+            .Tree = {},
+        };
+
+        ConvertTree(rtti, tree, flags, commonStringBuffer, script.Tree);
+        AddScript(std::move(script));
+    }
+
+    void AddCapturedScript(const DumpedTypeTreeRTTI& rtti, const TransferInstructionFlags& flags, const std::span<const TypeTreeNode> nodes, char const* stringBuffer, char const* commonStringBuffer, const std::span<const uint32_t> byteOffsets, const std::span<const int32_t> nextIndex, const ScriptingClass& scriptingClass)
+    {
+        DumpedTypeTreeScript script{
+            .AssemblyName = scriptingClass.AssemblyName,
+            .Namespace = scriptingClass.Namespace,
+            .ClassName = scriptingClass.ClassName,
+            .RefTypeHash = 0,
+            .Tree = {},
+        };
+
+        ConvertCapturedTree(rtti, flags, nodes, stringBuffer, commonStringBuffer, byteOffsets, nextIndex, script.Tree);
+        AddScript(std::move(script));
     }
 
-    void Write(std::ofstream &output) const
+    // Checks whether a tree matches the one AddReused would have produced from the source tree.
+    bool IsReusableTree(const size_t index, const size_t sourceIndex) const
+    {
+        const auto &nodes = GetNodes(index);
+        const auto &sourceNodes = GetNodes(sourceIndex);
+
+        if (nodes.empty() || nodes.size() != sourceNodes.size())
+            return false;
+
+        if (Strings.Get(nodes[0].TypeStringID) != TypeTrees[index].RTTI.ClassName)
+            return false;
+
+        if (nodes[0].TypeCommonOffset != GetCommonOffset(TypeTrees[index].RTTI.ClassName))
+            return false;
+
+        auto root = nodes[0];
+        root.TypeStringID = sourceNodes[0].TypeStringID;
+        root.TypeCommonOffset = sourceNodes[0].TypeCommonOffset;
+        root.SubtreeHash = sourceNodes[0].SubtreeHash;
+
+        return root == sourceNodes[0] && std::equal(nodes.begin() + 1, nodes.end(), sourceNodes.begin() + 1);
+    }
+
+    size_t GetTypeTreeCount() const
+    {
+        return TypeTrees.size();
+    }
+
+    // Store trees identical to a tree of the same type under other transfer flags as references
+    void SetDeduplicateTrees(const bool deduplicate)
+    {
+        DeduplicateTrees = deduplicate;
+    }
+
+    // Store node strings once in a string table, producing version 2 files
+    void SetUseStringTable(const bool useStringTable)
+    {
+        UseStringTable = useStringTable;
+    }
+
+    // Store the common string buffer and the offsets of the node strings taken from it, see SetCommonStringBuffer
+    void SetUseCommonStrings(const bool useCommonStrings)
+    {
+        UseCommonStrings = useCommonStrings;
+    }
+
+    // The common string buffer up to and including its terminating empty string. Without it, no common
+    // string offsets are written.
+    void SetCommonStringBuffer(const std::string_view commonStringBuffer)
+    {
+        CommonStringBuffer.assign(commonStringBuffer.begin(), commonStringBuffer.end());
+        CommonStringOffsets.clear();
+
+        for (size_t offset = 0; offset < CommonStringBuffer.size() && CommonStringBuffer[offset] != '\0';)
+        {
+            const auto value = std::string_view(CommonStringBuffer.data() + offset);
+            CommonStringOffsets.try_emplace(value, static_cast<uint32_t>(offset));
+            offset += value.size() + 1;
+        }
+    }
+
+    // Store the offset of every node's data within the object's data, where it is known without reading the data.
+    // The offsets are only computed with this set, so it applies to the trees added afterwards.
+    void SetUseByteOffsets(const bool useByteOffsets)
+    {
+        UseByteOffsets = useByteOffsets;
+    }
+
+    // Store the parent, next sibling and subtree size of every node. Like the subtree hashes, these are only computed
+    // when they are stored or needed to deduplicate trees or subtrees, so the options apply to the trees added afterwards.
+    void SetUseNavigation(const bool useNavigation)
+    {
+        UseNavigation = useNavigation;
+    }
+
+    // Store a structural hash of every node's subtree
+    void SetUseSubtreeHashes(const bool useSubtreeHashes)
+    {
+        UseSubtreeHashes = useSubtreeHashes;
+    }
+
+    // Store Unity's legacy type hash and a 64-bit hash of the nodes with every tree. The hashes are only computed
+    // with this set, so it applies to the trees added afterwards.
+    void SetUseTypeHashes(const bool useTypeHashes)
+    {
+        UseTypeHashes = useTypeHashes;
+    }
+
+    // Store every subtree shared by several trees or scripts once, and have the trees refer to it
+    void SetUseSubtreeReferences(const bool useSubtreeReferences)
+    {
+        UseSubtreeReferences = useSubtreeReferences;
+    }
+
+    // Store the RTTI of the trees once, and group the trees of every pass into a set labelled with its transfer flags
+    void SetUseTreeSets(const bool useTreeSets)
+    {
+        UseTreeSets = useTreeSets;
+    }
+
+    // Store the CRC32C of the trees and of every section, or of every compressed block, so that readers detect damaged files
+    void SetUseChecksums(const bool useChecksums)
+    {
+        UseChecksums = useChecksums;
+    }
+
+    // Also store the class hierarchy of the dumped types as a table of preorder intervals
+    void SetEmitHierarchy(const bool emitHierarchy)
+    {
+        EmitHierarchy = emitHierarchy;
+    }
+
+    // Also store the SerializedFile type tree blob of every tree, in the layout this revision writes
+    void SetEmitSerializedBlobs(const bool emitSerializedBlobs)
+    {
+        EmitSerializedBlobs = emitSerializedBlobs;
+    }
+
+    // Write the version 3 columnar layout instead of the stream layout, see columnar_format.hpp
+    void SetUseColumnarFormat(const bool useColumnarFormat)
+    {
+        UseColumnarFormat = useColumnarFormat;
+    }
+
+    // Write a version 4 file holding the file in independently compressed blocks of blockSize bytes,
+    // or the file itself with 0, see block_compression.hpp
+    void SetCompressionBlockSize(const uint32_t blockSize)
+    {
+        CompressionBlockSize = blockSize;
+    }
+
+    void SetShard(const DumpedTypeTreeShard &shard)
+    {
+        Shard = shard;
+    }
+
+    // Records the encoding and the compression of every block into tracer
+    void Write(OutputBuffer &output, TraceRecorder &tracer = TraceRecorder::Disabled()) const
+    {
+        if (CompressionBlockSize == 0)
+        {
+            TraceScope scope(tracer, "EncodeTypeTrees");
+            WriteUncompressed(output);
+            return;
+        }
+
+        OutputBuffer uncompressed;
+        {
+            TraceScope scope(tracer, "EncodeTypeTrees");
+            WriteUncompressed(uncompressed);
+        }
+
+        TraceScope scope(tracer, "CompressBlocks");
+        WriteBlockCompressed(output, uncompressed.GetData(), CompressionBlockSize, UseChecksums, tracer);
+    }
+
+    // Returns the nodes of a tree, resolving references to deduplicated trees
+    const std::vector<DumpedTypeTreeNode> &GetNodes(const size_t index) const
+    {
+        const auto &tree = TypeTrees[index];
+        if (tree.ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+            return TypeTrees[tree.ReferencedTree].Nodes;
+
+        return tree.Nodes;
+    }
+
+    std::string_view GetString(const uint32_t id) const
+    {
+        return Strings.Get(id);
+    }
+private:
+    // Only needed for the root type names of reused trees, all other offsets are taken from the engine's nodes
+    uint32_t GetCommonOffset(const std::string_view value) const
+    {
+        const auto it = CommonStringOffsets.find(value);
+        return it != CommonStringOffsets.end() ? it->second : DumpedTypeTreeNode::kNotCommonString;
+    }
+
+    void WriteUncompressed(OutputBuffer &output) const
     {
         const auto &[major, minor, patch] = RevisionToVersion(R);
+        const auto useCommonStrings = UseCommonStrings && !CommonStringBuffer.empty();
+        const auto flags = Deduplicator.GetHeaderFlags()
+            | (UseStringTable ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagStringTable) : 0)
+            | (useCommonStrings ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagCommonStrings) : 0)
+            | (UseByteOffsets ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagByteOffsets) : 0)
+            | (UseNavigation ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagNavigation) : 0)
+            | (UseSubtreeHashes ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes) : 0)
+            | (UseTypeHashes ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagTypeHashes) : 0)
+            | (UseSubtreeReferences ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences) : 0)
+            | (UseTreeSets ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagTreeSets) : 0)
+            | (UseChecksums ? static_cast<uint32_t>(DumpedTypeTreeHeader::kHeaderFlagChecksums) : 0);
+
+        if (UseColumnarFormat)
+        {
+            std::optional<DumpedTypeTreeHierarchy> hierarchy;
+            if (EmitHierarchy)
+                hierarchy = BuildTypeHierarchy(TypeTrees);
+
+            std::vector<DumpedTypeTreeSerializedBlobs> serializedBlobs;
+            if (EmitSerializedBlobs)
+                serializedBlobs.push_back(BuildSerializedBlobs(GetSerializedBlobFormatVersion(major), TypeTrees, Scripts, Strings, useCommonStrings));
+
+            internal::WriteColumnar(output, DumpedTypeTreeHeader{
+                .Magic = DumpedTypeTreeHeader::kDefaultMagic,
+                .Version = DumpedTypeTreeHeader::kVersion3,
+                .MajorRevision = major,
+                .MinorRevision = minor,
+                .PatchRevision = patch,
+                .Variant = std::string(VariantToString(V)),
+                .Flags = flags,
+            }, Strings, CommonStringBuffer, TypeTrees, Shard, hierarchy, Scripts, serializedBlobs);
+            return;
+        }
 
         internal::Write(output, DumpedTypeTreeHeader{
             .Magic = DumpedTypeTreeHeader::kDefaultMagic,
-            .Version = 1,
+            .Version = flags != 0 ? DumpedTypeTreeHeader::kVersion2 : DumpedTypeTreeHeader::kVersion1,
             .MajorRevision = major,
             .MinorRevision = minor,
             .PatchRevision = patch,
             .Variant = std::string(VariantToString(V)),
+            .Flags = flags,
         });
 
-        internal::Write(output, TypeTrees);
+        if (UseStringTable)
+            internal::WriteStringTable(output, Strings);
+
+        if (useCommonStrings)
+            internal::WriteBlob(output, CommonStringBuffer);
+
+        DumpedTypeTreeSubtreeEncoding subtrees;
+        if (UseSubtreeReferences)
+        {
+            subtrees = EncodeSubtreeReferences(TypeTrees, Scripts);
+            internal::WriteSubtrees(output, subtrees.Subtrees, Strings, flags);
+        }
+
+        DumpedTypeTreeRTTITable rtti;
+        if (UseTreeSets)
+        {
+            rtti = BuildRTTITable(TypeTrees, Scripts);
+            internal::WriteRTTITable(output, rtti.Records);
+        }
+
+        internal::WriteTypeTrees(output, TypeTrees, subtrees, rtti, Strings, flags);
+
+        const auto sectionsPosition = output.GetSize();
+
+        if (Shard.has_value())
+            internal::WriteSection(output, DumpedTypeTreeSectionHeader::kSectionShard, Shard.value());
+
+        if (EmitHierarchy)
+            internal::WriteSection(output, DumpedTypeTreeSectionHeader::kSectionHierarchy, BuildTypeHierarchy(TypeTrees));
+
+        if (!Scripts.empty())
+        {
+            internal::WriteSectionPayload(output, DumpedTypeTreeSectionHeader::kSectionScripts, [&]
+            {
+                internal::WriteScripts(output, Scripts, subtrees, rtti, Strings, flags);
+            });
+        }
+
+        if (EmitSerializedBlobs)
+        {
+            const std::vector serializedBlobs{ BuildSerializedBlobs(GetSerializedBlobFormatVersion(major), TypeTrees, Scripts, Strings, useCommonStrings) };
+
+            internal::WriteSectionPayload(output, DumpedTypeTreeSectionHeader::kSectionSerializedBlobs, [&]
+            {
+                internal::WriteSerializedBlobs(output, serializedBlobs);
+            });
+        }
+
+        if (UseChecksums)
+            internal::WriteStreamChecksums(output, sectionsPosition);
     }
-private:
+
+    DumpedTypeTreeStringTable Strings;
+    std::vector<char> CommonStringBuffer;
+    std::unordered_map<std::string_view, uint32_t> CommonStringOffsets;
     std::vector<DumpedTypeTree> TypeTrees;
+    std::optional<DumpedTypeTreeShard> Shard;
+    std::vector<DumpedTypeTreeScript> Scripts;
+
+    bool DeduplicateTrees = false;
+    bool UseStringTable = false;
+    bool UseCommonStrings = false;
+    bool UseByteOffsets = false;
+    bool UseNavigation = false;
+    bool UseSubtreeHashes = false;
+    bool UseTypeHashes = false;
+    bool UseSubtreeReferences = false;
+    bool UseTreeSets = false;
+    bool UseChecksums = false;
+    bool EmitHierarchy = false;
+    bool EmitSerializedBlobs = false;
+    bool UseColumnarFormat = false;
+    uint32_t CompressionBlockSize = 0;
+    DumpedTypeTreeDeduplicator Deduplicator;
 };
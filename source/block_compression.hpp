@@ -0,0 +1,600 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "checksum.hpp"
+#include "output_buffer.hpp"
+#include "trace.hpp"
+
+//
+// .ttbin version 4 layout, written with TYPETREERIPPER_BLOCK_COMPRESSION. It holds a complete file of another
+// version, split into blocks of BlockSize bytes (the last one may be shorter) that are compressed independently,
+// so that a reader only decompresses the blocks covering the bytes it needs:
+// DumpedTypeTreeBlockHeader
+// DumpedTypeTreeBlock[BlockCount]
+// Block data, at the offsets in the block table
+//
+// Blocks are compressed in the LZ4 block format (without the LZ4 frame), implemented here so that the dumper has no
+// dependencies. Blocks that do not get smaller are stored as they are. All scalars are little-endian.
+//
+// With TYPETREERIPPER_CHECKSUMS, every block's data is followed by the CRC32C of the data as stored, which readers
+// check before decompressing the block.
+//
+
+struct DumpedTypeTreeBlockHeader
+{
+    // Same magic as the stream layout, with DumpedTypeTreeHeader::kVersion4
+    uint64_t Magic;
+    uint32_t Version;
+
+    enum Codec : uint32_t
+    {
+        kCodecLz4Block = 1,
+    };
+    uint32_t Codec;
+
+    uint32_t BlockSize;
+    uint32_t BlockCount;
+
+    // Size of the file held in the blocks
+    uint64_t UncompressedSize;
+};
+static_assert(sizeof(DumpedTypeTreeBlockHeader) == 32);
+
+struct DumpedTypeTreeBlock
+{
+    enum Flags : uint32_t
+    {
+        // The block is stored uncompressed
+        kBlockFlagStored = 1 << 0,
+
+        // The block's data is followed by its uint32_t CRC32C, which CompressedSize does not include
+        kBlockFlagChecksum = 1 << 1,
+    };
+
+    // From the start of the file
+    uint64_t Offset;
+    uint32_t CompressedSize;
+    uint32_t Flags;
+};
+static_assert(sizeof(DumpedTypeTreeBlock) == 16);
+
+namespace block_compression_details
+{
+    constexpr size_t kMinimumMatchLength = 4;
+
+    // The format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end
+    constexpr size_t kLastLiteralCount = 5;
+    constexpr size_t kMatchStartLimit = 12;
+
+    constexpr size_t kMaximumOffset = 65535;
+    constexpr uint32_t kHashBits = 12;
+
+    inline uint32_t Load32(const uint8_t *data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t Hash(const uint32_t value)
+    {
+        return (value * 2654435761u) >> (32 - kHashBits);
+    }
+
+    inline void WriteLength(uint8_t *&output, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            *output++ = 255;
+        }
+
+        *output++ = static_cast<uint8_t>(length);
+    }
+
+    inline bool ReadLength(const uint8_t *&input, const uint8_t *end, size_t &length)
+    {
+        uint8_t value;
+        do
+        {
+            if (input == end)
+                return false;
+
+            value = *input++;
+            length += value;
+        } while (value == 255);
+
+        return true;
+    }
+
+    // Writes one sequence: the literals before a match, and the match unless matchLength is 0
+    inline void WriteSequence(uint8_t *&output, const uint8_t *literals, const size_t literalCount, const size_t offset, const size_t matchLength)
+    {
+        auto &token = *output++;
+        token = static_cast<uint8_t>((std::min)(literalCount, size_t{ 15 }) << 4);
+        if (literalCount >= 15)
+            WriteLength(output, literalCount - 15);
+
+        std::memcpy(output, literals, literalCount);
+        output += literalCount;
+
+        if (matchLength == 0)
+            return;
+
+        *output++ = static_cast<uint8_t>(offset);
+        *output++ = static_cast<uint8_t>(offset >> 8);
+
+        const auto length = matchLength - kMinimumMatchLength;
+        token |= static_cast<uint8_t>((std::min)(length, size_t{ 15 }));
+        if (length >= 15)
+            WriteLength(output, length - 15);
+    }
+
+    inline size_t GetMaxCompressedSize(const size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    // Greedy compression with a single-entry hash table, the output must hold GetMaxCompressedSize bytes
+    inline size_t Compress(const std::span<const char> input, const std::span<char> output)
+    {
+        const auto source = reinterpret_cast<const uint8_t *>(input.data());
+        const auto size = input.size();
+        const auto start = reinterpret_cast<uint8_t *>(output.data());
+        auto destination = start;
+
+        size_t anchor = 0;
+        if (size > kMatchStartLimit)
+        {
+            std::array<uint32_t, 1 << kHashBits> positions{};
+            const auto matchStartEnd = size - kMatchStartLimit;
+            const auto matchEnd = size - kLastLiteralCount;
+
+            for (size_t position = 0; position <= matchStartEnd;)
+            {
+                const auto value = Load32(source + position);
+                auto &entry = positions[Hash(value)];
+                size_t match = entry;
+                entry = static_cast<uint32_t>(position);
+
+                if (match >= position || position - match > kMaximumOffset || Load32(source + match) != value)
+                {
+                    // Skip ahead faster through data that does not compress
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+
+                while (position > anchor && match > 0 && source[position - 1] == source[match - 1])
+                {
+                    position--;
+                    match--;
+                }
+
+                auto length = kMinimumMatchLength;
+                while (position + length < matchEnd && source[position + length] == source[match + length])
+                {
+                    length++;
+                }
+
+                WriteSequence(destination, source + anchor, position - anchor, position - match, length);
+                position += length;
+                anchor = position;
+
+                if (position <= matchStartEnd)
+                    positions[Hash(Load32(source + position - 2))] = static_cast<uint32_t>(position - 2);
+            }
+        }
+
+        WriteSequence(destination, source + anchor, size - anchor, 0, 0);
+        return static_cast<size_t>(destination - start);
+    }
+
+    // Returns whether the input is a valid block decompressing into exactly the output
+    inline bool Decompress(const std::span<const char> input, const std::span<char> output)
+    {
+        auto source = reinterpret_cast<const uint8_t *>(input.data());
+        const auto sourceEnd = source + input.size();
+        const auto start = reinterpret_cast<uint8_t *>(output.data());
+        auto destination = start;
+        const auto destinationEnd = start + output.size();
+
+        while (true)
+        {
+            if (source == sourceEnd)
+                return false;
+
+            const auto token = *source++;
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !ReadLength(source, sourceEnd, literalCount))
+                return false;
+
+            if (literalCount > static_cast<size_t>(sourceEnd - source) || literalCount > static_cast<size_t>(destinationEnd - destination))
+                return false;
+
+            std::memcpy(destination, source, literalCount);
+            source += literalCount;
+            destination += literalCount;
+
+            // The last sequence has no match
+            if (source == sourceEnd)
+                return destination == destinationEnd;
+
+            if (sourceEnd - source < 2)
+                return false;
+
+            const size_t offset = source[0] | (source[1] << 8);
+            source += 2;
+
+            if (offset == 0 || offset > static_cast<size_t>(destination - start))
+                return false;
+
+            size_t length = token & 15;
+            if (length == 15 && !ReadLength(source, sourceEnd, length))
+                return false;
+
+            length += kMinimumMatchLength;
+            if (length > static_cast<size_t>(destinationEnd - destination))
+                return false;
+
+            // Matches may overlap their own output, repeating the last offset bytes
+            const auto match = destination - offset;
+            if (offset >= length)
+            {
+                std::memcpy(destination, match, length);
+            }
+            else
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    destination[i] = match[i];
+                }
+            }
+
+            destination += length;
+        }
+    }
+
+    // Calls function for every index below count, spread over the hardware threads. Each thread's share of the work
+    // is recorded as a span.
+    template<typename TFunction>
+    void ParallelFor(const size_t count, TFunction &&function, TraceRecorder &tracer)
+    {
+        const auto threadCount = (std::min)(count, static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1u)));
+        if (threadCount <= 1)
+        {
+            TraceScope scope(tracer, "BlockWorker");
+            for (size_t i = 0; i < count; i++)
+            {
+                function(i);
+            }
+
+            return;
+        }
+
+        std::atomic<size_t> next = 0;
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        const auto work = [&]
+        {
+            TraceScope scope(tracer, "BlockWorker");
+            for (auto i = next++; i < count; i = next++)
+            {
+                try
+                {
+                    function(i);
+                }
+                catch (...)
+                {
+                    const std::lock_guard lock(errorMutex);
+                    if (!error)
+                        error = std::current_exception();
+
+                    next = count;
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            for (size_t i = 1; i < threadCount; i++)
+            {
+                threads.emplace_back(work);
+            }
+
+            work();
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    template<typename T>
+    T LoadScalar(const char *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(value));
+
+        if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1)
+            value = std::byteswap(value);
+
+        return value;
+    }
+}
+
+// Larger blocks compress better, smaller blocks make reading a few bytes cheaper
+static constexpr uint32_t kDefaultCompressionBlockSize = 64 * 1024;
+static constexpr uint32_t kMaximumCompressionBlockSize = 64 * 1024 * 1024;
+
+//
+// Random access to the file held in a version 4 file in memory, e.g. a memory-mapped file. Blocks are
+// decompressed the first time a read covers them, into a buffer of the uncompressed size whose pages are only
+// touched for those blocks. The constructor checks the header and the block table against the data. Reads are
+// not thread-safe.
+//
+
+class DumpedTypeTreeBlockView
+{
+public:
+    using Header = DumpedTypeTreeBlockHeader;
+    using Block = DumpedTypeTreeBlock;
+
+    static constexpr uint64_t kMagic = 0x4545525445505954;
+    static constexpr uint32_t kVersion = 4;
+
+    explicit DumpedTypeTreeBlockView(const std::span<const char> data)
+        : Data(data)
+    {
+        using block_compression_details::LoadScalar;
+
+        if (data.size() < sizeof(Header))
+            throw std::runtime_error("Unexpected end of file");
+
+        FileHeader = {
+            .Magic = LoadScalar<uint64_t>(data.data() + offsetof(Header, Magic)),
+            .Version = LoadScalar<uint32_t>(data.data() + offsetof(Header, Version)),
+            .Codec = LoadScalar<uint32_t>(data.data() + offsetof(Header, Codec)),
+            .BlockSize = LoadScalar<uint32_t>(data.data() + offsetof(Header, BlockSize)),
+            .BlockCount = LoadScalar<uint32_t>(data.data() + offsetof(Header, BlockCount)),
+            .UncompressedSize = LoadScalar<uint64_t>(data.data() + offsetof(Header, UncompressedSize)),
+        };
+
+        if (FileHeader.Magic != kMagic)
+            throw std::runtime_error("Invalid magic number");
+
+        if (FileHeader.Version != kVersion)
+            throw std::runtime_error("Unsupported version");
+
+        if (FileHeader.Codec != Header::kCodecLz4Block)
+            throw std::runtime_error("Unsupported compression codec");
+
+        if (FileHeader.BlockSize == 0 || FileHeader.BlockSize > kMaximumCompressionBlockSize
+            || FileHeader.BlockCount != (FileHeader.UncompressedSize + FileHeader.BlockSize - 1) / FileHeader.BlockSize)
+        {
+            throw std::runtime_error("Invalid compressed block layout");
+        }
+
+        if (FileHeader.BlockCount > (data.size() - sizeof(Header)) / sizeof(Block))
+            throw std::runtime_error("Unexpected end of file");
+
+        Blocks.resize(FileHeader.BlockCount);
+        for (size_t i = 0; i < Blocks.size(); i++)
+        {
+            const auto entry = data.data() + sizeof(Header) + i * sizeof(Block);
+            auto &block = Blocks[i];
+
+            block = {
+                .Offset = LoadScalar<uint64_t>(entry + offsetof(Block, Offset)),
+                .CompressedSize = LoadScalar<uint32_t>(entry + offsetof(Block, CompressedSize)),
+                .Flags = LoadScalar<uint32_t>(entry + offsetof(Block, Flags)),
+            };
+
+            const auto storedSize = uint64_t{ block.CompressedSize } + (block.Flags & Block::kBlockFlagChecksum ? sizeof(uint32_t) : 0);
+            if (block.Offset > data.size() || storedSize > data.size() - block.Offset)
+                throw std::runtime_error("Unexpected end of file");
+
+            // A block can expand by at most 255 times, which keeps the buffer in proportion to the file
+            const auto size = GetBlockSize(i);
+            const auto isValid = (block.Flags & Block::kBlockFlagStored) != 0
+                ? block.CompressedSize == size
+                : block.CompressedSize != 0 && size <= uint64_t{ block.CompressedSize } * 255;
+
+            if (!isValid || (block.Flags & ~(Block::kBlockFlagStored | Block::kBlockFlagChecksum)) != 0)
+                throw std::runtime_error("Invalid compressed block");
+
+            // Checksums are written for all blocks or none
+            if ((block.Flags & Block::kBlockFlagChecksum) != (Blocks.front().Flags & Block::kBlockFlagChecksum))
+                throw std::runtime_error("Invalid compressed block");
+        }
+
+        Uncompressed = std::make_unique_for_overwrite<char[]>(FileHeader.UncompressedSize);
+        Decompressed.resize(Blocks.size());
+    }
+
+    const Header &GetHeader() const
+    {
+        return FileHeader;
+    }
+
+    uint64_t GetSize() const
+    {
+        return FileHeader.UncompressedSize;
+    }
+
+    bool HasChecksums() const
+    {
+        return !Blocks.empty() && (Blocks.front().Flags & Block::kBlockFlagChecksum) != 0;
+    }
+
+    // Checks the blocks against their checksums in parallel without decompressing them, or throws if the file has none
+    void VerifyChecksums(TraceRecorder &tracer = TraceRecorder::Disabled()) const
+    {
+        if (!HasChecksums())
+            throw std::runtime_error("The file has no checksums");
+
+        block_compression_details::ParallelFor(Blocks.size(), [&](const size_t index)
+        {
+            TraceScope scope(tracer, "VerifyBlock");
+            VerifyBlock(index);
+        }, tracer);
+    }
+
+    // Returns size bytes of the file held in the blocks, decompressing the blocks they cover
+    std::span<const char> Read(const uint64_t offset, const size_t size)
+    {
+        if (offset > GetSize() || size > GetSize() - offset)
+            throw std::runtime_error("Unexpected end of file");
+
+        if (size != 0)
+        {
+            for (auto i = offset / FileHeader.BlockSize; i <= (offset + size - 1) / FileHeader.BlockSize; i++)
+            {
+                DecompressBlock(static_cast<size_t>(i));
+            }
+        }
+
+        return { Uncompressed.get() + offset, size };
+    }
+
+    // Returns the whole file held in the blocks, decompressing the remaining blocks in parallel
+    std::span<const char> ReadAll(TraceRecorder &tracer = TraceRecorder::Disabled())
+    {
+        block_compression_details::ParallelFor(Blocks.size(), [&](const size_t index)
+        {
+            TraceScope scope(tracer, "DecompressBlock");
+            DecompressBlock(index);
+        }, tracer);
+
+        return { Uncompressed.get(), static_cast<size_t>(GetSize()) };
+    }
+private:
+    size_t GetBlockSize(const size_t index) const
+    {
+        const auto offset = uint64_t{ index } * FileHeader.BlockSize;
+        return static_cast<size_t>((std::min)(GetSize() - offset, uint64_t{ FileHeader.BlockSize }));
+    }
+
+    void VerifyBlock(const size_t index) const
+    {
+        const auto &block = Blocks[index];
+        if (!(block.Flags & Block::kBlockFlagChecksum))
+            return;
+
+        const auto input = Data.subspan(static_cast<size_t>(block.Offset), block.CompressedSize);
+        if (ComputeCrc32c(input) != block_compression_details::LoadScalar<uint32_t>(input.data() + input.size()))
+            throw std::runtime_error("Checksum mismatch in compressed block " + std::to_string(index));
+    }
+
+    void DecompressBlock(const size_t index)
+    {
+        if (Decompressed[index])
+            return;
+
+        VerifyBlock(index);
+
+        const auto &block = Blocks[index];
+        const auto input = Data.subspan(static_cast<size_t>(block.Offset), block.CompressedSize);
+        const std::span output(Uncompressed.get() + uint64_t{ index } * FileHeader.BlockSize, GetBlockSize(index));
+
+        if (block.Flags & Block::kBlockFlagStored)
+            std::memcpy(output.data(), input.data(), output.size());
+        else if (!block_compression_details::Decompress(input, output))
+            throw std::runtime_error("Invalid compressed block");
+
+        Decompressed[index] = true;
+    }
+
+    std::span<const char> Data;
+    Header FileHeader;
+    std::vector<Block> Blocks;
+    std::unique_ptr<char[]> Uncompressed;
+
+    // Not a vector<bool>, so that blocks can be decompressed in parallel
+    std::vector<uint8_t> Decompressed;
+};
+
+// Writes data, a complete file of another version, as a version 4 file. Blocks are compressed in parallel.
+inline void WriteBlockCompressed(OutputBuffer &output, const std::span<const char> data, const uint32_t blockSize, const bool checksums = false,
+    TraceRecorder &tracer = TraceRecorder::Disabled())
+{
+    using namespace block_compression_details;
+
+    if (blockSize == 0 || blockSize > kMaximumCompressionBlockSize)
+        throw std::runtime_error("Invalid compression block size");
+
+    const auto blockCount = (data.size() + blockSize - 1) / blockSize;
+    if (blockCount > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Too many compressed blocks");
+
+    const auto getBlockData = [&](const size_t index)
+    {
+        const auto offset = index * blockSize;
+        return data.subspan(offset, (std::min)(data.size() - offset, size_t{ blockSize }));
+    };
+
+    // Empty when the block is stored as it is
+    std::vector<std::vector<char>> compressedBlocks(blockCount);
+    ParallelFor(blockCount, [&](const size_t index)
+    {
+        TraceScope scope(tracer, "CompressBlock");
+        const auto block = getBlockData(index);
+        auto &compressed = compressedBlocks[index];
+
+        compressed.resize(GetMaxCompressedSize(block.size()));
+        compressed.resize(Compress(block, compressed));
+
+        if (compressed.size() >= block.size())
+            compressed = {};
+    }, tracer);
+
+    output.WriteScalar(DumpedTypeTreeBlockView::kMagic);
+    output.WriteScalar(DumpedTypeTreeBlockView::kVersion);
+    output.WriteScalar(static_cast<uint32_t>(DumpedTypeTreeBlockHeader::kCodecLz4Block));
+    output.WriteScalar(blockSize);
+    output.WriteScalar(static_cast<uint32_t>(blockCount));
+    output.WriteScalar(static_cast<uint64_t>(data.size()));
+
+    const auto getStoredData = [&](const size_t index)
+    {
+        return compressedBlocks[index].empty() ? getBlockData(index) : std::span<const char>(compressedBlocks[index]);
+    };
+
+    const auto checksumFlag = checksums ? static_cast<uint32_t>(DumpedTypeTreeBlock::kBlockFlagChecksum) : 0;
+    const auto checksumSize = checksums ? sizeof(uint32_t) : 0;
+
+    auto offset = sizeof(DumpedTypeTreeBlockHeader) + blockCount * sizeof(DumpedTypeTreeBlock);
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        const auto stored = compressedBlocks[i].empty();
+        const auto size = getStoredData(i).size();
+
+        output.WriteScalar(static_cast<uint64_t>(offset));
+        output.WriteScalar(static_cast<uint32_t>(size));
+        output.WriteScalar((stored ? static_cast<uint32_t>(DumpedTypeTreeBlock::kBlockFlagStored) : 0) | checksumFlag);
+        offset += size + checksumSize;
+    }
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        const auto block = getStoredData(i);
+        output.Write(block.data(), block.size());
+
+        if (checksums)
+            output.WriteScalar(ComputeCrc32c(block));
+    }
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define TYPETREERIPPER_CRC32C_X64 1
+#elif defined(_M_ARM64) || (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+#include <arm_acle.h>
+#define TYPETREERIPPER_CRC32C_ARM64 1
+#endif
+
+//
+// CRC32C (Castagnoli), which .ttbin files written with TYPETREERIPPER_CHECKSUMS carry to detect damaged and
+// truncated files. It is computed with the SSE4.2 CRC32 instruction on x64 CPUs that have it and the ARMv8 CRC32
+// instructions on arm64, interleaving three streams to hide the instruction latency, and with a table otherwise.
+//
+
+namespace checksum_details
+{
+    // Reflected Castagnoli polynomial
+    constexpr uint32_t kPolynomial = 0x82F63B78;
+
+    // Slicing-by-8 tables, where kTables[k][b] is the CRC of byte b followed by k zero bytes
+    constexpr auto kTables = []
+    {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            auto crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = crc & 1 ? (crc >> 1) ^ kPolynomial : crc >> 1;
+
+            tables[0][i] = crc;
+        }
+
+        for (size_t k = 1; k < tables.size(); k++)
+        {
+            for (uint32_t i = 0; i < 256; i++)
+                tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+
+        return tables;
+    }();
+
+    inline uint64_t LoadUInt64(const uint8_t *data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+
+        if constexpr (std::endian::native == std::endian::big)
+            value = std::byteswap(value);
+
+        return value;
+    }
+
+    // The product of two polynomials modulo the polynomial, all in reflected bit order
+    constexpr uint32_t MultiplyModP(const uint32_t left, uint32_t right)
+    {
+        uint32_t product = 0;
+
+        for (uint32_t bit = 1u << 31; bit != 0; bit >>= 1)
+        {
+            if (left & bit)
+                product ^= right;
+
+            right = right & 1 ? (right >> 1) ^ kPolynomial : right >> 1;
+        }
+
+        return product;
+    }
+
+    // x^(8 * size) modulo the polynomial, which advances a CRC over size zero bytes when multiplied with it
+    constexpr uint32_t GetShift(size_t size)
+    {
+        // x^1, and then x^(2^k) for the following bits of the bit count
+        uint32_t power = 1u << 30;
+        uint32_t shift = 1u << 31;
+
+        for (auto bits = size * 8; bits != 0; bits >>= 1)
+        {
+            if (bits & 1)
+                shift = MultiplyModP(power, shift);
+
+            power = MultiplyModP(power, power);
+        }
+
+        return shift;
+    }
+
+    inline uint32_t UpdateTable(uint32_t crc, const uint8_t *data, size_t size)
+    {
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            const auto value = LoadUInt64(data) ^ crc;
+            crc = kTables[7][value & 0xFF] ^ kTables[6][(value >> 8) & 0xFF] ^ kTables[5][(value >> 16) & 0xFF]
+                ^ kTables[4][(value >> 24) & 0xFF] ^ kTables[3][(value >> 32) & 0xFF] ^ kTables[2][(value >> 40) & 0xFF]
+                ^ kTables[1][(value >> 48) & 0xFF] ^ kTables[0][value >> 56];
+        }
+
+        for (; size != 0; data++, size--)
+            crc = (crc >> 8) ^ kTables[0][(crc ^ *data) & 0xFF];
+
+        return crc;
+    }
+
+    // Every stream of the hardware loop covers this many bytes, and the streams are joined with a precomputed shift
+    constexpr size_t kStreamSize = 8 * 1024;
+    constexpr uint32_t kStreamShift = GetShift(kStreamSize);
+
+#if defined(TYPETREERIPPER_CRC32C_X64) || defined(TYPETREERIPPER_CRC32C_ARM64)
+#if defined(TYPETREERIPPER_CRC32C_X64)
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TYPETREERIPPER_CRC32C_TARGET
+#else
+#define TYPETREERIPPER_CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+
+    TYPETREERIPPER_CRC32C_TARGET inline uint32_t Crc32Byte(const uint32_t crc, const uint8_t value)
+    {
+        return _mm_crc32_u8(crc, value);
+    }
+
+    TYPETREERIPPER_CRC32C_TARGET inline uint32_t Crc32Word(const uint32_t crc, const uint64_t value)
+    {
+        return static_cast<uint32_t>(_mm_crc32_u64(crc, value));
+    }
+
+    inline bool HasHardwareCrc32()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        static const auto hasSse42 = (info[2] & (1 << 20)) != 0;
+#else
+        static const auto hasSse42 = __builtin_cpu_supports("sse4.2") != 0;
+#endif
+        return hasSse42;
+    }
+#else
+#define TYPETREERIPPER_CRC32C_TARGET
+
+    inline uint32_t Crc32Byte(const uint32_t crc, const uint8_t value)
+    {
+        return __crc32cb(crc, value);
+    }
+
+    inline uint32_t Crc32Word(const uint32_t crc, const uint64_t value)
+    {
+        return __crc32cd(crc, value);
+    }
+
+    inline bool HasHardwareCrc32()
+    {
+        return true;
+    }
+#endif
+
+    TYPETREERIPPER_CRC32C_TARGET inline uint32_t UpdateHardware(uint32_t crc, const uint8_t *data, size_t size)
+    {
+        // Three independent streams keep the CRC unit busy, as every instruction waits for the previous one of its stream
+        for (; size >= 3 * kStreamSize; data += 3 * kStreamSize, size -= 3 * kStreamSize)
+        {
+            uint32_t crc1 = 0;
+            uint32_t crc2 = 0;
+
+            for (size_t i = 0; i < kStreamSize; i += 8)
+            {
+                crc = Crc32Word(crc, LoadUInt64(data + i));
+                crc1 = Crc32Word(crc1, LoadUInt64(data + kStreamSize + i));
+                crc2 = Crc32Word(crc2, LoadUInt64(data + 2 * kStreamSize + i));
+            }
+
+            crc = MultiplyModP(kStreamShift, MultiplyModP(kStreamShift, crc) ^ crc1) ^ crc2;
+        }
+
+        for (; size >= 8; data += 8, size -= 8)
+            crc = Crc32Word(crc, LoadUInt64(data));
+
+        for (; size != 0; data++, size--)
+            crc = Crc32Byte(crc, *data);
+
+        return crc;
+    }
+
+#undef TYPETREERIPPER_CRC32C_TARGET
+#endif
+}
+
+// The CRC32C of data. The CRC of data split into parts is computed by passing the CRC of the previous parts.
+inline uint32_t ComputeCrc32c(const std::span<const char> data, const uint32_t crc = 0)
+{
+    using namespace checksum_details;
+
+    const auto bytes = reinterpret_cast<const uint8_t *>(data.data());
+
+#if defined(TYPETREERIPPER_CRC32C_X64) || defined(TYPETREERIPPER_CRC32C_ARM64)
+    if (HasHardwareCrc32())
+        return ~UpdateHardware(~crc, bytes, data.size());
+#endif
+
+    return ~UpdateTable(~crc, bytes, data.size());
+}
@@ -0,0 +1,512 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "checksum.hpp"
+
+//
+// .ttbin version 3 layout, written instead of the stream layout with TYPETREERIPPER_COLUMNAR. Every structure has
+// a fixed size and is aligned, so that a memory-mapped file can be queried through DumpedTypeTreeColumnarView
+// without parsing it first:
+// DumpedTypeTreeColumnarHeader
+// Sections, each starting at a multiple of kColumnarSectionAlignment
+// DumpedTypeTreeColumnarSection[SectionCount] (at SectionTableOffset)
+//
+// Nodes are stored as one column per field over the nodes of all trees, and trees refer to a range of them.
+// Trees stored once share their range with the trees referring to them. All strings, including the RTTI
+// names, are kept in a single string pool.
+//
+
+static constexpr size_t kColumnarSectionAlignment = 16;
+
+struct DumpedTypeTreeColumnarHeader
+{
+    // Same magic as the stream layout, with DumpedTypeTreeHeader::kVersion3
+    uint64_t Magic;
+    uint32_t Version;
+
+    // Revision
+    uint16_t MajorRevision;
+    uint8_t MinorRevision;
+    uint8_t PatchRevision;
+
+    uint32_t VariantStringID;
+
+    // DumpedTypeTreeHeader flags selecting the optional columns: kHeaderFlagCommonStrings, kHeaderFlagByteOffsets,
+    // kHeaderFlagNavigation, kHeaderFlagSubtreeHashes and kHeaderFlagTypeHashes, and kHeaderFlagChecksums
+    uint32_t Flags;
+
+    // DumpedTypeTreeHeader::kHeaderFlagChecksums
+    static constexpr uint32_t kFlagChecksums = 1 << 9;
+
+    uint64_t SectionTableOffset;
+    uint32_t SectionCount;
+
+    // CRC32C of the section table with kFlagChecksums, otherwise zero
+    uint32_t SectionTableChecksum;
+};
+static_assert(sizeof(DumpedTypeTreeColumnarHeader) == 40);
+
+struct DumpedTypeTreeColumnarSection
+{
+    enum Tag : uint32_t
+    {
+        // uint32_t[StringCount + 1], the offset of every string in the string data followed by its size
+        kSectionStringOffsets = 0x4F525453, // 'STRO'
+
+        // NUL terminated UTF-8 strings
+        kSectionStringData = 0x44525453, // 'STRD'
+
+        // DumpedTypeTreeColumnarTree[TypeTreeCount]
+        kSectionTypeTrees = 0x45455254, // 'TREE'
+
+        // DumpedTypeTreeColumnarTypeIndexEntry[TypeTreeCount], sorted by persistent type ID and tree index
+        kSectionTypeIndex = 0x58444954, // 'TIDX'
+
+        // DumpedTypeTreeColumnarScript[ScriptCount]
+        kSectionScripts = 0x54524353, // 'SCRT'
+
+        // The engine's common string buffer, only with kHeaderFlagCommonStrings
+        kSectionCommonStrings = 0x52545343, // 'CSTR'
+
+        // Node columns, one element per node
+        kSectionNodeTypeStringIDs = 0x50595444, // 'DTYP', uint32_t
+        kSectionNodeNameStringIDs = 0x4D414E44, // 'DNAM', uint32_t
+        kSectionNodeFlags = 0x474C4644, // 'DFLG', uint32_t
+        kSectionNodeByteSizes = 0x5A534244, // 'DBSZ', int32_t
+        kSectionNodeIndices = 0x58444944, // 'DIDX', int32_t
+        kSectionNodeVersions = 0x52455644, // 'DVER', int16_t
+        kSectionNodeLevels = 0x4C564C44, // 'DLVL', uint8_t
+        kSectionNodeMetaFlags = 0x41544D44, // 'DMTA', uint32_t
+        kSectionNodeRefTypeHashes = 0x48545244, // 'DRTH', uint64_t
+
+        // Optional node columns, present with the header flag of the same field
+        kSectionNodeTypeCommonOffsets = 0x4F435444, // 'DTCO', uint32_t
+        kSectionNodeNameCommonOffsets = 0x4F434E44, // 'DNCO', uint32_t
+        kSectionNodeByteOffsets = 0x464F4244, // 'DBOF', uint32_t
+        kSectionNodeParentIndices = 0x52415044, // 'DPAR', uint32_t
+        kSectionNodeNextSiblingIndices = 0x54584E44, // 'DNXT', uint32_t
+        kSectionNodeSubtreeNodeCounts = 0x42555344, // 'DSUB', uint32_t
+        kSectionNodeSubtreeHashes = 0x53485344, // 'DSHS', uint64_t
+
+        // Same payloads as the stream layout's optional sections
+        kSectionShard = 0x44524853, // 'SHRD'
+        kSectionHierarchy = 0x52454948, // 'HIER'
+        kSectionSerializedBlobs = 0x424C4253, // 'SBLB'
+    };
+    std::underlying_type_t<Tag> Tag;
+
+    // CRC32C of the section with DumpedTypeTreeColumnarHeader::kFlagChecksums, otherwise zero
+    uint32_t Checksum;
+
+    // Offset of the section from the start of the file, and its size in bytes
+    uint64_t Offset;
+    uint64_t Size;
+};
+static_assert(sizeof(DumpedTypeTreeColumnarSection) == 24);
+
+// The RTTI and node range of a type tree, with the fields of DumpedTypeTreeRTTI and DumpedTypeTree
+struct DumpedTypeTreeColumnarTree
+{
+    uint32_t ClassNameStringID;
+    uint32_t ClassNamespaceStringID;
+    uint32_t ModuleStringID;
+    int32_t PersistentTypeID;
+    int32_t Size;
+    uint32_t RTTIFlags;
+    uint32_t BasePersistentTypeID;
+    uint32_t DerivedFromTypeIndex;
+    uint32_t DerivedFromDescendantCount;
+
+    uint32_t FirstNode;
+    uint32_t NodeCount;
+    uint32_t Reserved;
+
+    uint64_t TransferFlags;
+
+    // Zero unless kHeaderFlagTypeHashes is set
+    uint64_t TypeHash;
+    uint8_t OldTypeHash[16];
+};
+static_assert(sizeof(DumpedTypeTreeColumnarTree) == 80);
+
+struct DumpedTypeTreeColumnarScript
+{
+    uint32_t AssemblyNameStringID;
+    uint32_t NamespaceStringID;
+    uint32_t ClassNameStringID;
+    uint32_t Reserved;
+    uint64_t RefTypeHash;
+    DumpedTypeTreeColumnarTree Tree;
+};
+static_assert(sizeof(DumpedTypeTreeColumnarScript) == 104);
+
+struct DumpedTypeTreeColumnarTypeIndexEntry
+{
+    int32_t PersistentTypeID;
+    uint32_t TypeTreeIndex;
+
+    auto operator<=>(const DumpedTypeTreeColumnarTypeIndexEntry &) const = default;
+};
+static_assert(sizeof(DumpedTypeTreeColumnarTypeIndexEntry) == 8);
+
+// Views of the node columns. Optional columns the file does not have are empty.
+struct DumpedTypeTreeColumns
+{
+    std::span<const uint32_t> TypeStringIDs;
+    std::span<const uint32_t> NameStringIDs;
+    std::span<const uint32_t> Flags;
+    std::span<const int32_t> ByteSizes;
+    std::span<const int32_t> Indices;
+    std::span<const int16_t> Versions;
+    std::span<const uint8_t> Levels;
+    std::span<const uint32_t> MetaFlags;
+    std::span<const uint64_t> RefTypeHashes;
+
+    std::span<const uint32_t> TypeCommonOffsets;
+    std::span<const uint32_t> NameCommonOffsets;
+    std::span<const uint32_t> ByteOffsets;
+    std::span<const uint32_t> ParentIndices;
+    std::span<const uint32_t> NextSiblingIndices;
+    std::span<const uint32_t> SubtreeNodeCounts;
+    std::span<const uint64_t> SubtreeHashes;
+
+    size_t Size() const
+    {
+        return TypeStringIDs.size();
+    }
+
+    // The columns of the nodes [first, first + count)
+    DumpedTypeTreeColumns Slice(const size_t first, const size_t count) const
+    {
+        const auto slice = [&]<typename T>(const std::span<const T> column)
+        {
+            return column.empty() ? column : column.subspan(first, count);
+        };
+
+        return {
+            .TypeStringIDs = slice(TypeStringIDs),
+            .NameStringIDs = slice(NameStringIDs),
+            .Flags = slice(Flags),
+            .ByteSizes = slice(ByteSizes),
+            .Indices = slice(Indices),
+            .Versions = slice(Versions),
+            .Levels = slice(Levels),
+            .MetaFlags = slice(MetaFlags),
+            .RefTypeHashes = slice(RefTypeHashes),
+            .TypeCommonOffsets = slice(TypeCommonOffsets),
+            .NameCommonOffsets = slice(NameCommonOffsets),
+            .ByteOffsets = slice(ByteOffsets),
+            .ParentIndices = slice(ParentIndices),
+            .NextSiblingIndices = slice(NextSiblingIndices),
+            .SubtreeNodeCounts = slice(SubtreeNodeCounts),
+            .SubtreeHashes = slice(SubtreeHashes),
+        };
+    }
+};
+
+//
+// Read-only view of a version 3 file in memory, e.g. a memory-mapped file. The constructor only checks the header,
+// the section table and the tree records against the section bounds; strings are checked when they are looked up.
+// The data must be aligned to 8 bytes, and the view can only be used on little-endian hosts.
+//
+// With kFlagChecksums, the constructor checks the section table and the sections it reads. The node columns and the
+// other sections are checked the first time they are accessed, and VerifyChecksums checks the whole file.
+//
+
+class DumpedTypeTreeColumnarView
+{
+public:
+    using Header = DumpedTypeTreeColumnarHeader;
+    using Section = DumpedTypeTreeColumnarSection;
+
+    static constexpr uint64_t kMagic = 0x4545525445505954;
+    static constexpr uint32_t kVersion = 3;
+
+    explicit DumpedTypeTreeColumnarView(const std::span<const char> data)
+        : Data(data)
+    {
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("Columnar files can only be viewed on little-endian hosts");
+
+        if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0)
+            throw std::runtime_error("Columnar file data is not aligned");
+
+        if (data.size() < sizeof(Header))
+            throw std::runtime_error("Columnar file is too small");
+
+        FileHeader = reinterpret_cast<const Header *>(data.data());
+        if (FileHeader->Magic != kMagic)
+            throw std::runtime_error("Invalid magic number");
+
+        if (FileHeader->Version != kVersion)
+            throw std::runtime_error("Unsupported version");
+
+        Sections = GetArray<Section>(FileHeader->SectionTableOffset, uint64_t{ FileHeader->SectionCount } * sizeof(Section));
+        if (HasChecksums() && ComputeCrc32c({ reinterpret_cast<const char *>(Sections.data()), Sections.size_bytes() }) != FileHeader->SectionTableChecksum)
+            throw std::runtime_error("Checksum mismatch in the section table");
+
+        for (const auto &section : Sections)
+        {
+            if (section.Offset > data.size() || section.Size > data.size() - section.Offset || section.Offset % alignof(uint64_t) != 0)
+                throw std::runtime_error("Invalid section bounds");
+        }
+
+        // One more flag for the node columns as a whole
+        if (HasChecksums())
+        {
+            Verified = std::make_unique<std::atomic<bool>[]>(Sections.size() + 1);
+
+            for (const auto tag : { Section::kSectionStringOffsets, Section::kSectionStringData, Section::kSectionTypeTrees,
+                Section::kSectionTypeIndex, Section::kSectionScripts })
+            {
+                VerifySection(tag);
+            }
+        }
+
+        StringOffsets = GetSection<uint32_t>(Section::kSectionStringOffsets);
+        StringData = GetSection<char>(Section::kSectionStringData);
+        if (StringOffsets.empty() || StringOffsets.back() != StringData.size())
+            throw std::runtime_error("Invalid string pool");
+
+        TypeTrees = GetSection<DumpedTypeTreeColumnarTree>(Section::kSectionTypeTrees);
+        TypeIndex = GetSection<DumpedTypeTreeColumnarTypeIndexEntry>(Section::kSectionTypeIndex);
+        Scripts = GetSection<DumpedTypeTreeColumnarScript>(Section::kSectionScripts);
+        CommonStringBuffer = GetSection<char>(Section::kSectionCommonStrings);
+
+        Columns = {
+            .TypeStringIDs = GetSection<uint32_t>(Section::kSectionNodeTypeStringIDs),
+            .NameStringIDs = GetSection<uint32_t>(Section::kSectionNodeNameStringIDs),
+            .Flags = GetSection<uint32_t>(Section::kSectionNodeFlags),
+            .ByteSizes = GetSection<int32_t>(Section::kSectionNodeByteSizes),
+            .Indices = GetSection<int32_t>(Section::kSectionNodeIndices),
+            .Versions = GetSection<int16_t>(Section::kSectionNodeVersions),
+            .Levels = GetSection<uint8_t>(Section::kSectionNodeLevels),
+            .MetaFlags = GetSection<uint32_t>(Section::kSectionNodeMetaFlags),
+            .RefTypeHashes = GetSection<uint64_t>(Section::kSectionNodeRefTypeHashes),
+            .TypeCommonOffsets = GetSection<uint32_t>(Section::kSectionNodeTypeCommonOffsets),
+            .NameCommonOffsets = GetSection<uint32_t>(Section::kSectionNodeNameCommonOffsets),
+            .ByteOffsets = GetSection<uint32_t>(Section::kSectionNodeByteOffsets),
+            .ParentIndices = GetSection<uint32_t>(Section::kSectionNodeParentIndices),
+            .NextSiblingIndices = GetSection<uint32_t>(Section::kSectionNodeNextSiblingIndices),
+            .SubtreeNodeCounts = GetSection<uint32_t>(Section::kSectionNodeSubtreeNodeCounts),
+            .SubtreeHashes = GetSection<uint64_t>(Section::kSectionNodeSubtreeHashes),
+        };
+
+        ValidateColumns();
+        ValidateTypeIndex();
+    }
+
+    const Header &GetHeader() const
+    {
+        return *FileHeader;
+    }
+
+    bool HasChecksums() const
+    {
+        return (FileHeader->Flags & Header::kFlagChecksums) != 0;
+    }
+
+    // Checks every section not checked yet, or throws if the file has no checksums
+    void VerifyChecksums() const
+    {
+        if (!HasChecksums())
+            throw std::runtime_error("The file has no checksums");
+
+        for (size_t i = 0; i < Sections.size(); i++)
+        {
+            VerifySectionAt(i);
+        }
+    }
+
+    // The payload of a section, or an empty span if the file does not have it
+    std::span<const char> GetSectionData(const uint32_t tag) const
+    {
+        const auto it = std::ranges::find(Sections, tag, &Section::Tag);
+        if (it == Sections.end())
+            return {};
+
+        VerifySectionAt(static_cast<size_t>(it - Sections.begin()));
+        return Data.subspan(it->Offset, it->Size);
+    }
+
+    bool HasSection(const uint32_t tag) const
+    {
+        return std::ranges::find(Sections, tag, &Section::Tag) != Sections.end();
+    }
+
+    size_t GetStringCount() const
+    {
+        return StringOffsets.size() - 1;
+    }
+
+    std::string_view GetString(const uint32_t id) const
+    {
+        if (id >= GetStringCount() || StringOffsets[id] >= StringOffsets[id + 1] || StringOffsets[id + 1] > StringData.size()
+            || StringData[StringOffsets[id + 1] - 1] != '\0')
+            throw std::runtime_error("Invalid string ID");
+
+        return { StringData.data() + StringOffsets[id], StringOffsets[id + 1] - StringOffsets[id] - 1 };
+    }
+
+    std::span<const DumpedTypeTreeColumnarTree> GetTypeTrees() const
+    {
+        return TypeTrees;
+    }
+
+    std::span<const DumpedTypeTreeColumnarScript> GetScripts() const
+    {
+        return Scripts;
+    }
+
+    std::span<const char> GetCommonStringBuffer() const
+    {
+        VerifySection(Section::kSectionCommonStrings);
+        return CommonStringBuffer;
+    }
+
+    // The index entries of all trees of a type, in tree order
+    std::span<const DumpedTypeTreeColumnarTypeIndexEntry> FindTypeTrees(const int32_t persistentTypeID) const
+    {
+        const auto range = std::ranges::equal_range(TypeIndex, persistentTypeID, {}, &DumpedTypeTreeColumnarTypeIndexEntry::PersistentTypeID);
+        return { range.begin(), range.end() };
+    }
+
+    const DumpedTypeTreeColumns &GetColumns() const
+    {
+        VerifyColumns();
+        return Columns;
+    }
+
+    DumpedTypeTreeColumns GetNodes(const DumpedTypeTreeColumnarTree &tree) const
+    {
+        VerifyColumns();
+        return Columns.Slice(tree.FirstNode, tree.NodeCount);
+    }
+private:
+    void VerifySectionAt(const size_t index) const
+    {
+        if (!Verified || Verified[index].load(std::memory_order_acquire))
+            return;
+
+        const auto &section = Sections[index];
+        if (ComputeCrc32c(Data.subspan(section.Offset, section.Size)) != section.Checksum)
+        {
+            std::string name;
+            for (auto shift = 0; shift < 32; shift += 8)
+                name += static_cast<char>((section.Tag >> shift) & 0xFF);
+
+            throw std::runtime_error("Checksum mismatch in section " + name);
+        }
+
+        Verified[index].store(true, std::memory_order_release);
+    }
+
+    void VerifySection(const uint32_t tag) const
+    {
+        const auto it = std::ranges::find(Sections, tag, &Section::Tag);
+        if (it != Sections.end())
+            VerifySectionAt(static_cast<size_t>(it - Sections.begin()));
+    }
+
+    // The node columns are checked together, as they are handed out together
+    void VerifyColumns() const
+    {
+        if (!Verified || Verified[Sections.size()].load(std::memory_order_acquire))
+            return;
+
+        for (const auto tag : { Section::kSectionNodeTypeStringIDs, Section::kSectionNodeNameStringIDs, Section::kSectionNodeFlags,
+            Section::kSectionNodeByteSizes, Section::kSectionNodeIndices, Section::kSectionNodeVersions, Section::kSectionNodeLevels,
+            Section::kSectionNodeMetaFlags, Section::kSectionNodeRefTypeHashes, Section::kSectionNodeTypeCommonOffsets,
+            Section::kSectionNodeNameCommonOffsets, Section::kSectionNodeByteOffsets, Section::kSectionNodeParentIndices,
+            Section::kSectionNodeNextSiblingIndices, Section::kSectionNodeSubtreeNodeCounts, Section::kSectionNodeSubtreeHashes })
+        {
+            VerifySection(tag);
+        }
+
+        Verified[Sections.size()].store(true, std::memory_order_release);
+    }
+
+    template<typename T>
+    std::span<const T> GetArray(const uint64_t offset, const uint64_t size) const
+    {
+        if (offset > Data.size() || size > Data.size() - offset || offset % alignof(T) != 0 || size % sizeof(T) != 0)
+            throw std::runtime_error("Invalid section bounds");
+
+        return { reinterpret_cast<const T *>(Data.data() + offset), static_cast<size_t>(size / sizeof(T)) };
+    }
+
+    template<typename T>
+    std::span<const T> GetSection(const uint32_t tag) const
+    {
+        const auto it = std::ranges::find(Sections, tag, &Section::Tag);
+        if (it == Sections.end())
+            return {};
+
+        return GetArray<T>(it->Offset, it->Size);
+    }
+
+    // Every column has one element per node, and every tree refers to nodes within the columns
+    void ValidateColumns() const
+    {
+        const auto nodeCount = Columns.Size();
+        const auto isColumn = [&](const auto &column, const bool required)
+        {
+            return column.size() == nodeCount || (!required && column.empty());
+        };
+
+        // Which optional columns are present is up to the header flags, which readers check against the columns
+
+        if (!isColumn(Columns.NameStringIDs, true) || !isColumn(Columns.Flags, true) || !isColumn(Columns.ByteSizes, true)
+            || !isColumn(Columns.Indices, true) || !isColumn(Columns.Versions, true) || !isColumn(Columns.Levels, true)
+            || !isColumn(Columns.MetaFlags, true) || !isColumn(Columns.RefTypeHashes, true)
+            || !isColumn(Columns.TypeCommonOffsets, false) || !isColumn(Columns.NameCommonOffsets, false)
+            || !isColumn(Columns.ByteOffsets, false) || !isColumn(Columns.ParentIndices, false)
+            || !isColumn(Columns.NextSiblingIndices, false) || !isColumn(Columns.SubtreeNodeCounts, false)
+            || !isColumn(Columns.SubtreeHashes, false))
+        {
+            throw std::runtime_error("Invalid node columns");
+        }
+
+        const auto isValidRange = [&](const DumpedTypeTreeColumnarTree &tree)
+        {
+            return tree.FirstNode <= nodeCount && tree.NodeCount <= nodeCount - tree.FirstNode;
+        };
+
+        if (!std::ranges::all_of(TypeTrees, isValidRange) || !std::ranges::all_of(Scripts, isValidRange, &DumpedTypeTreeColumnarScript::Tree))
+            throw std::runtime_error("Invalid node range");
+    }
+
+    void ValidateTypeIndex() const
+    {
+        if (TypeIndex.size() != TypeTrees.size() || !std::ranges::is_sorted(TypeIndex))
+            throw std::runtime_error("Invalid type index");
+
+        for (const auto &entry : TypeIndex)
+        {
+            if (entry.TypeTreeIndex >= TypeTrees.size() || TypeTrees[entry.TypeTreeIndex].PersistentTypeID != entry.PersistentTypeID)
+                throw std::runtime_error("Invalid type index");
+        }
+    }
+
+    std::span<const char> Data;
+    const Header *FileHeader = nullptr;
+    std::span<const Section> Sections;
+    std::span<const uint32_t> StringOffsets;
+    std::span<const char> StringData;
+    std::span<const DumpedTypeTreeColumnarTree> TypeTrees;
+    std::span<const DumpedTypeTreeColumnarTypeIndexEntry> TypeIndex;
+    std::span<const DumpedTypeTreeColumnarScript> Scripts;
+    std::span<const char> CommonStringBuffer;
+    DumpedTypeTreeColumns Columns;
+
+    // Whether each section has been checked, only with checksums
+    std::unique_ptr<std::atomic<bool>[]> Verified;
+};
@@ -1,7 +1,11 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
 
 #define FOR_EACH_VARIANT(X) \
@@ -249,10 +253,10 @@ namespace details
 }
 
 #define DECLARE_REVISION(Type, Rev) \
-    template<Variant V> struct ::details::HasExplicitRevision<Type, Rev, V> : ::std::true_type {}
+    template<Variant V> struct details::HasExplicitRevision<Type, Rev, V> : ::std::true_type {}
 
 #define DECLARE_REVISION_VARIANT(Type, Rev, Var) \
-    template<> struct ::details::HasExplicitRevision<Type, Rev, Var> : ::std::true_type {}
+    template<> struct details::HasExplicitRevision<Type, Rev, Var> : ::std::true_type {}
 
 #define DEFINE_REVISION(T, Type, Rev) \
     template<Revision R, Variant V> \
@@ -0,0 +1,1071 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "serialized_blob.hpp"
+
+//
+// .ttdelta binary layout, written by the native tool's delta command. A delta holds what changed between a base
+// .ttbin and a target .ttbin, e.g. two revisions of the engine, so that a series of dumps can be kept as one full
+// dump followed by a chain of deltas:
+// DumpedTypeTreeDeltaHeader
+// TypeTreeHeader of the target, followed by its uint32 CompressionBlockSize
+// DeltaRun[] and string[]: the target's string table, as runs of base strings and strings the base does not have
+// CommonStringBuffer (only with kDeltaFlagCommonStringBuffer, the base's is kept otherwise)
+// DeltaTree[]: runs of unchanged base trees, and the changed and added trees
+// DeltaScript[]: the same for the scripts
+// DumpedTypeTreeShard (only with kDeltaFlagShard)
+// DumpedTypeTreeHierarchy (only with kDeltaFlagStoredHierarchy)
+// uint32[] serialized blob format versions, followed by the blobs with kDeltaFlagStoredSerializedBlobs
+//
+// Changed and added trees are stored as node edits: every subtree found anywhere in the base is copied from there,
+// with only the level, index and byte offset of its root, and the remaining nodes are stored in full. Base trees
+// the target does not have are left out. Navigation, subtree hashes and type hashes are computed again when the
+// delta is applied, and so are the hierarchy and the blobs whenever rebuilding them gives the target's.
+//
+
+struct DumpedTypeTreeDeltaHeader
+{
+    // 'TTBDELTA' in little-endian
+    static constexpr auto kDefaultMagic = 0x41544C4544425454;
+    static constexpr uint32_t kVersion1 = 1;
+
+    uint64_t Magic;
+    uint32_t Version;
+
+    // Fingerprints of the binary the delta applies to and of the one it produces, see ComputeDeltaFingerprint.
+    // Every delta of a chain applies to the target of the one before it.
+    uint64_t BaseFingerprint;
+    uint64_t TargetFingerprint;
+
+    // Copies and changed trees refer to the base's trees and scripts by index
+    uint32_t BaseTypeTreeCount;
+    uint32_t BaseScriptCount;
+
+    enum Flags : uint32_t
+    {
+        // The target's common string buffer differs from the base's and is stored
+        kDeltaFlagCommonStringBuffer = 1 << 0,
+
+        kDeltaFlagShard = 1 << 1,
+
+        // The target has a hierarchy, which is rebuilt from its trees unless kDeltaFlagStoredHierarchy is set
+        kDeltaFlagHierarchy = 1 << 2,
+        kDeltaFlagStoredHierarchy = 1 << 3,
+
+        // The target's serialized blobs are stored rather than rebuilt from its trees
+        kDeltaFlagStoredSerializedBlobs = 1 << 4,
+    };
+    std::underlying_type_t<Flags> Flags = 0;
+};
+
+struct DumpedTypeTreeDeltaRun
+{
+    static constexpr auto kNewStrings = std::numeric_limits<uint32_t>::max();
+
+    // Index of the run's first base string, or kNewStrings for a run of the strings stored with the delta
+    uint32_t First;
+    uint32_t Count;
+};
+
+// A node stored in full, or a subtree of the base copied into the node array
+struct DumpedTypeTreeDeltaNode
+{
+    static constexpr auto kLiteral = std::numeric_limits<uint32_t>::max();
+
+    // The base tree the subtree is copied from, counting the base's type trees followed by its scripts,
+    // or kLiteral for a node stored in full
+    uint32_t SourceTree = kLiteral;
+
+    // Index of the copied subtree's root in the source tree
+    uint32_t SourcePosition = 0;
+
+    // The node stored in full, with string IDs into the target's string table. Copies only use its Level, Index
+    // and ByteOffset, which are those of the copied root in the target.
+    DumpedTypeTreeNode Node{};
+};
+
+struct DumpedTypeTreeDeltaTree
+{
+    static constexpr auto kNoBaseTree = std::numeric_limits<uint32_t>::max();
+
+    // A run of CopyCount unchanged base trees starting at CopyFirst. The other fields are only used by changed
+    // and added trees, which have a CopyCount of 0.
+    uint32_t CopyFirst = 0;
+    uint32_t CopyCount = 0;
+
+    // The base tree a changed tree replaces, or kNoBaseTree for an added tree
+    uint32_t BaseTree = kNoBaseTree;
+
+    DumpedTypeTreeRTTI RTTI{};
+    std::underlying_type_t<DumpedTransferInstructionFlags> TransferFlags = 0;
+    std::vector<DumpedTypeTreeDeltaNode> Nodes;
+};
+
+// The runs and base trees of a script's tree refer to the base's scripts
+struct DumpedTypeTreeDeltaScript
+{
+    std::string AssemblyName;
+    std::string Namespace;
+    std::string ClassName;
+    uint64_t RefTypeHash = 0;
+
+    DumpedTypeTreeDeltaTree Tree;
+};
+
+struct DumpedTypeTreeDelta
+{
+    DumpedTypeTreeDeltaHeader Header;
+    DumpedTypeTreeHeader TargetHeader;
+    uint32_t CompressionBlockSize = 0;
+
+    std::vector<DumpedTypeTreeDeltaRun> StringRuns;
+    std::vector<std::string> NewStrings;
+
+    std::vector<char> CommonStringBuffer;
+    std::vector<DumpedTypeTreeDeltaTree> TypeTrees;
+    std::vector<DumpedTypeTreeDeltaScript> Scripts;
+    std::optional<DumpedTypeTreeShard> Shard;
+    std::optional<DumpedTypeTreeHierarchy> Hierarchy;
+    std::vector<uint32_t> SerializedBlobFormatVersions;
+    std::vector<DumpedTypeTreeSerializedBlobs> SerializedBlobs;
+};
+
+// What a delta does to the type trees or scripts of its base
+struct DumpedTypeTreeDeltaChanges
+{
+    size_t Unchanged = 0;
+    size_t Changed = 0;
+    size_t Added = 0;
+
+    // Indices of the base's trees the target no longer has
+    std::vector<uint32_t> Removed;
+};
+
+// Identifies a binary by the XXH3 of its uncompressed encoding, so that deltas are only applied to their own base
+inline uint64_t ComputeDeltaFingerprint(const DumpedTypeTreeBinary &binary)
+{
+    OutputBuffer output;
+    internal::WriteBinary(output, binary);
+
+    const auto data = output.GetData();
+    return CalculateXxh3_64(std::span(reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+}
+
+namespace delta_details
+{
+    constexpr auto kNoString = std::numeric_limits<uint32_t>::max();
+
+    // The ID every string of a table has in another table, or kNoString where the other table does not have it
+    inline std::vector<uint32_t> MapStrings(const DumpedTypeTreeStringTable &from, const DumpedTypeTreeStringTable &to)
+    {
+        std::unordered_map<std::string_view, uint32_t> ids;
+        for (uint32_t id = 0; id < to.Size(); id++)
+        {
+            ids.emplace(to.Get(id), id);
+        }
+
+        std::vector<uint32_t> result(from.Size(), kNoString);
+        for (uint32_t id = 0; id < from.Size(); id++)
+        {
+            if (const auto it = ids.find(from.Get(id)); it != ids.end())
+                result[id] = it->second;
+        }
+
+        return result;
+    }
+
+    inline DumpedTypeTreeNode MapNode(DumpedTypeTreeNode node, const std::span<const uint32_t> stringMap)
+    {
+        node.TypeStringID = stringMap[node.TypeStringID];
+        node.NameStringID = stringMap[node.NameStringID];
+        return node;
+    }
+
+    // Moves a base node to the target's string table, which has every string of the nodes the target kept
+    inline DumpedTypeTreeNode MoveNode(const DumpedTypeTreeNode &node, const std::span<const uint32_t> stringMap)
+    {
+        auto result = MapNode(node, stringMap);
+        if (result.TypeStringID == kNoString || result.NameStringID == kNoString)
+            throw std::runtime_error("The delta copies a string its string table does not have");
+
+        return result;
+    }
+
+    inline bool IsSameNodes(const std::span<const DumpedTypeTreeNode> base, const std::span<const DumpedTypeTreeNode> target,
+        const std::span<const uint32_t> stringMap)
+    {
+        return std::ranges::equal(base, target, [&](const DumpedTypeTreeNode &lhs, const DumpedTypeTreeNode &rhs)
+        {
+            return MapNode(lhs, stringMap) == rhs;
+        });
+    }
+
+    // The node arrays of the base's type trees followed by those of its scripts, which node copies refer to by index
+    inline std::vector<std::span<const DumpedTypeTreeNode>> GetSourceTrees(const DumpedTypeTreeBinary &base)
+    {
+        std::vector<std::span<const DumpedTypeTreeNode>> sources;
+        sources.reserve(base.TypeTrees.size() + base.Scripts.size());
+
+        for (const auto &tree : base.TypeTrees)
+        {
+            sources.emplace_back(tree.Nodes);
+        }
+
+        for (const auto &script : base.Scripts)
+        {
+            sources.emplace_back(script.Tree.Nodes);
+        }
+
+        return sources;
+    }
+
+    // Encodes node arrays as copies of the base's subtrees where it has them, and nodes stored in full elsewhere
+    class NodeEncoder
+    {
+    public:
+        NodeEncoder(std::vector<std::span<const DumpedTypeTreeNode>> sources, const std::span<const uint32_t> stringMap)
+            : Sources(std::move(sources)), StringMap(stringMap)
+        {
+            for (uint32_t source = 0; source < Sources.size(); source++)
+            {
+                for (uint32_t position = 0; position < Sources[source].size(); position++)
+                {
+                    auto &candidates = Candidates[Sources[source][position].SubtreeHash];
+                    if (candidates.size() < kMaxCandidates)
+                        candidates.emplace_back(source, position);
+                }
+            }
+        }
+
+        // Subtrees are preferably copied from the base tree the nodes replace
+        std::vector<DumpedTypeTreeDeltaNode> Encode(const std::span<const DumpedTypeTreeNode> nodes, const uint32_t preferredSource) const
+        {
+            std::vector<DumpedTypeTreeDeltaNode> result;
+
+            for (size_t position = 0; position < nodes.size();)
+            {
+                const auto &root = nodes[position];
+                const auto subtree = nodes.subspan(position, root.SubtreeNodeCount);
+
+                if (const auto copy = FindCopy(subtree, position, preferredSource); copy.has_value())
+                {
+                    DumpedTypeTreeNode copyRoot{};
+                    copyRoot.Index = root.Index;
+                    copyRoot.Level = root.Level;
+                    copyRoot.ByteOffset = root.ByteOffset;
+
+                    result.push_back({
+                        .SourceTree = copy->first,
+                        .SourcePosition = copy->second,
+                        .Node = copyRoot,
+                    });
+                    position += subtree.size();
+                    continue;
+                }
+
+                result.push_back({ .Node = root });
+                position++;
+            }
+
+            return result;
+        }
+    private:
+        // Most subtrees occur a few times at most, the rest are common structures any of whose copies will do
+        static constexpr size_t kMaxCandidates = 16;
+
+        std::optional<std::pair<uint32_t, uint32_t>> FindCopy(const std::span<const DumpedTypeTreeNode> subtree, const size_t position,
+            const uint32_t preferredSource) const
+        {
+            // Copies restore the subtree with Place, so it has to survive rebasing
+            if (!subtree_reference_details::IsRebasable(subtree))
+                return std::nullopt;
+
+            const auto candidates = Candidates.find(subtree.front().SubtreeHash);
+            if (candidates == Candidates.end())
+                return std::nullopt;
+
+            std::optional<std::pair<uint32_t, uint32_t>> found;
+            for (const auto &[source, sourcePosition] : candidates->second)
+            {
+                if (found.has_value() && source != preferredSource)
+                    continue;
+
+                if (!IsSameSubtree(Sources[source], sourcePosition, subtree, position))
+                    continue;
+
+                found.emplace(source, sourcePosition);
+                if (source == preferredSource)
+                    break;
+            }
+
+            return found;
+        }
+
+        bool IsSameSubtree(const std::span<const DumpedTypeTreeNode> source, const uint32_t sourcePosition,
+            const std::span<const DumpedTypeTreeNode> subtree, const size_t position) const
+        {
+            using subtree_reference_details::Rebase;
+
+            const auto sourceSubtree = source.subspan(sourcePosition, source[sourcePosition].SubtreeNodeCount);
+            if (sourceSubtree.size() != subtree.size())
+                return false;
+
+            for (size_t i = 0; i < subtree.size(); i++)
+            {
+                if (MapNode(Rebase(sourceSubtree, sourcePosition, i), StringMap) != Rebase(subtree, position, i))
+                    return false;
+            }
+
+            return true;
+        }
+
+        std::vector<std::span<const DumpedTypeTreeNode>> Sources;
+        std::span<const uint32_t> StringMap;
+        std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, uint32_t>>> Candidates;
+    };
+
+    inline std::vector<DumpedTypeTreeNode> DecodeNodes(const std::span<const DumpedTypeTreeDeltaNode> values,
+        const std::span<const std::span<const DumpedTypeTreeNode>> sources, const std::span<const uint32_t> stringMap,
+        const DumpedTypeTreeStringTable &strings)
+    {
+        using subtree_reference_details::Place;
+        using subtree_reference_details::Rebase;
+
+        std::vector<DumpedTypeTreeNode> nodes;
+
+        for (const auto &value : values)
+        {
+            if (value.SourceTree == DumpedTypeTreeDeltaNode::kLiteral)
+            {
+                if (value.Node.TypeStringID >= strings.Size() || value.Node.NameStringID >= strings.Size())
+                    throw std::runtime_error("Invalid string ID");
+
+                nodes.push_back(value.Node);
+                continue;
+            }
+
+            if (value.SourceTree >= sources.size() || value.SourcePosition >= sources[value.SourceTree].size())
+                throw std::runtime_error("Invalid subtree copy");
+
+            // The base's subtree sizes were validated when reading it
+            const auto &source = sources[value.SourceTree];
+            const auto subtree = source.subspan(value.SourcePosition, source[value.SourcePosition].SubtreeNodeCount);
+            const DumpedTypeTreeSubtreeReference reference{
+                .Subtree = 0,
+                .Position = static_cast<uint32_t>(nodes.size()),
+                .Level = value.Node.Level,
+                .Index = value.Node.Index,
+                .ByteOffset = value.Node.ByteOffset,
+            };
+
+            for (size_t i = 0; i < subtree.size(); i++)
+            {
+                nodes.push_back(MoveNode(Place(Rebase(subtree, value.SourcePosition, i), reference, i == 0), stringMap));
+            }
+        }
+
+        ComputeNodeNavigation(nodes);
+        ComputeSubtreeHashes(nodes, strings);
+        return nodes;
+    }
+
+    // Writers build the blobs over the deduplicated trees, where referring trees share the blob of the referenced one
+    inline std::vector<DumpedTypeTreeSerializedBlobs> RebuildSerializedBlobs(const DumpedTypeTreeBinary &binary, const std::span<const uint32_t> formatVersions)
+    {
+        std::vector<DumpedTypeTreeSerializedBlobs> result;
+        if (formatVersions.empty())
+            return result;
+
+        auto trees = binary.TypeTrees;
+        if (binary.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagTreeReferences)
+            DeduplicateTypeTrees(trees);
+
+        const auto useCommonStrings = (binary.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings) != 0;
+        for (const auto formatVersion : formatVersions)
+        {
+            result.push_back(BuildSerializedBlobs(formatVersion, trees, binary.Scripts, binary.Strings, useCommonStrings));
+        }
+
+        return result;
+    }
+
+    struct TreeMatch
+    {
+        // A run of unchanged base trees, or a target tree with the base tree it replaces if any
+        uint32_t CopyFirst = 0;
+        uint32_t CopyCount = 0;
+        uint32_t Target = 0;
+        uint32_t BaseTree = DumpedTypeTreeDeltaTree::kNoBaseTree;
+    };
+
+    // Pairs every target tree with the first base tree of the same key not paired yet
+    template<typename TKey, typename TIsUnchanged>
+    std::vector<TreeMatch> MatchTrees(const std::span<const TKey> baseKeys, const std::span<const TKey> targetKeys, TIsUnchanged &&isUnchanged)
+    {
+        // Base trees by key, last first
+        std::map<TKey, std::vector<uint32_t>> baseTrees;
+        for (auto i = static_cast<uint32_t>(baseKeys.size()); i-- > 0;)
+        {
+            baseTrees[baseKeys[i]].push_back(i);
+        }
+
+        std::vector<TreeMatch> matches;
+        for (uint32_t target = 0; target < targetKeys.size(); target++)
+        {
+            auto baseTree = DumpedTypeTreeDeltaTree::kNoBaseTree;
+            if (const auto it = baseTrees.find(targetKeys[target]); it != baseTrees.end() && !it->second.empty())
+            {
+                baseTree = it->second.back();
+                it->second.pop_back();
+            }
+
+            if (baseTree == DumpedTypeTreeDeltaTree::kNoBaseTree || !isUnchanged(baseTree, target))
+            {
+                matches.push_back({ .Target = target, .BaseTree = baseTree });
+                continue;
+            }
+
+            if (!matches.empty() && matches.back().CopyCount != 0 && matches.back().CopyFirst + matches.back().CopyCount == baseTree)
+                matches.back().CopyCount++;
+            else
+                matches.push_back({ .CopyFirst = baseTree, .CopyCount = 1 });
+        }
+
+        return matches;
+    }
+
+    template<typename TGetTree>
+    DumpedTypeTreeDeltaChanges GetChanges(const size_t count, TGetTree &&getTree, const uint32_t baseCount)
+    {
+        DumpedTypeTreeDeltaChanges changes;
+        std::vector<bool> kept(baseCount);
+
+        const auto keep = [&](const uint64_t baseTree)
+        {
+            if (baseTree < kept.size())
+                kept[baseTree] = true;
+        };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const DumpedTypeTreeDeltaTree &tree = getTree(i);
+            for (uint64_t j = 0; j < tree.CopyCount && tree.CopyFirst + j < baseCount; j++)
+            {
+                keep(tree.CopyFirst + j);
+            }
+
+            changes.Unchanged += tree.CopyCount;
+
+            if (tree.CopyCount != 0)
+                continue;
+
+            if (tree.BaseTree == DumpedTypeTreeDeltaTree::kNoBaseTree)
+            {
+                changes.Added++;
+                continue;
+            }
+
+            changes.Changed++;
+            keep(tree.BaseTree);
+        }
+
+        for (uint32_t i = 0; i < baseCount; i++)
+        {
+            if (!kept[i])
+                changes.Removed.push_back(i);
+        }
+
+        return changes;
+    }
+
+    // Counts the trees an entry list expands to, checking its runs stay within the base
+    template<typename TGetTree>
+    size_t GetTargetCount(const size_t count, TGetTree &&getTree, const uint32_t baseCount)
+    {
+        size_t targetCount = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const DumpedTypeTreeDeltaTree &tree = getTree(i);
+            if (uint64_t{ tree.CopyFirst } + tree.CopyCount > baseCount)
+                throw std::runtime_error("Invalid tree copy");
+
+            targetCount += tree.CopyCount != 0 ? tree.CopyCount : 1;
+        }
+
+        return targetCount;
+    }
+}
+
+inline DumpedTypeTreeDeltaChanges GetTypeTreeChanges(const DumpedTypeTreeDelta &delta)
+{
+    return delta_details::GetChanges(delta.TypeTrees.size(), [&](const size_t i) -> const DumpedTypeTreeDeltaTree &
+    {
+        return delta.TypeTrees[i];
+    }, delta.Header.BaseTypeTreeCount);
+}
+
+inline DumpedTypeTreeDeltaChanges GetScriptChanges(const DumpedTypeTreeDelta &delta)
+{
+    return delta_details::GetChanges(delta.Scripts.size(), [&](const size_t i) -> const DumpedTypeTreeDeltaTree &
+    {
+        return delta.Scripts[i].Tree;
+    }, delta.Header.BaseScriptCount);
+}
+
+//
+// Builds the delta turning base into target. Type trees are matched by persistent type ID and transfer flags,
+// scripts by class and transfer flags.
+//
+
+inline DumpedTypeTreeDelta BuildDelta(const DumpedTypeTreeBinary &base, const DumpedTypeTreeBinary &target)
+{
+    using namespace delta_details;
+
+    DumpedTypeTreeDelta delta{};
+    delta.Header = {
+        .Magic = DumpedTypeTreeDeltaHeader::kDefaultMagic,
+        .Version = DumpedTypeTreeDeltaHeader::kVersion1,
+        .BaseFingerprint = ComputeDeltaFingerprint(base),
+        .TargetFingerprint = ComputeDeltaFingerprint(target),
+        .BaseTypeTreeCount = static_cast<uint32_t>(base.TypeTrees.size()),
+        .BaseScriptCount = static_cast<uint32_t>(base.Scripts.size()),
+    };
+    delta.TargetHeader = target.Header;
+    delta.CompressionBlockSize = target.CompressionBlockSize;
+
+    // The target's string table is kept in its order, so that node string IDs stay the same
+    const auto baseStringIDs = MapStrings(target.Strings, base.Strings);
+    for (uint32_t id = 0; id < target.Strings.Size(); id++)
+    {
+        auto first = baseStringIDs[id];
+        if (first == kNoString)
+        {
+            first = DumpedTypeTreeDeltaRun::kNewStrings;
+            delta.NewStrings.emplace_back(target.Strings.Get(id));
+        }
+
+        // Runs of new strings continue as long as the strings are new, runs of base strings while they are consecutive
+        const auto continuesRun = [&](const DumpedTypeTreeDeltaRun &run)
+        {
+            if (run.First == DumpedTypeTreeDeltaRun::kNewStrings || first == DumpedTypeTreeDeltaRun::kNewStrings)
+                return run.First == first;
+
+            return run.First + run.Count == first;
+        };
+
+        if (!delta.StringRuns.empty() && continuesRun(delta.StringRuns.back()))
+            delta.StringRuns.back().Count++;
+        else
+            delta.StringRuns.push_back({ .First = first, .Count = 1 });
+    }
+
+    if (target.CommonStringBuffer != base.CommonStringBuffer)
+    {
+        delta.Header.Flags |= DumpedTypeTreeDeltaHeader::kDeltaFlagCommonStringBuffer;
+        delta.CommonStringBuffer = target.CommonStringBuffer;
+    }
+
+    const auto stringMap = MapStrings(base.Strings, target.Strings);
+    const NodeEncoder encoder(GetSourceTrees(base), stringMap);
+
+    const auto isSameTree = [&](const DumpedTypeTree &lhs, const DumpedTypeTree &rhs)
+    {
+        return lhs.RTTI == rhs.RTTI && lhs.TransferFlags == rhs.TransferFlags && lhs.OldTypeHash == rhs.OldTypeHash && lhs.TypeHash == rhs.TypeHash
+            && IsSameNodes(lhs.Nodes, rhs.Nodes, stringMap);
+    };
+
+    const auto encodeTree = [&](const DumpedTypeTree &tree, const uint32_t baseTree, const uint32_t sourceTree) -> DumpedTypeTreeDeltaTree
+    {
+        return {
+            .BaseTree = baseTree,
+            .RTTI = tree.RTTI,
+            .TransferFlags = tree.TransferFlags,
+            .Nodes = encoder.Encode(tree.Nodes, sourceTree),
+        };
+    };
+
+    std::vector<std::tuple<int32_t, uint64_t>> baseTreeKeys;
+    std::vector<std::tuple<int32_t, uint64_t>> targetTreeKeys;
+    for (const auto &tree : base.TypeTrees)
+    {
+        baseTreeKeys.emplace_back(tree.RTTI.PersistentTypeID, tree.TransferFlags);
+    }
+
+    for (const auto &tree : target.TypeTrees)
+    {
+        targetTreeKeys.emplace_back(tree.RTTI.PersistentTypeID, tree.TransferFlags);
+    }
+
+    const auto treeMatches = MatchTrees<std::tuple<int32_t, uint64_t>>(baseTreeKeys, targetTreeKeys, [&](const uint32_t baseTree, const uint32_t targetTree)
+    {
+        return isSameTree(base.TypeTrees[baseTree], target.TypeTrees[targetTree]);
+    });
+
+    for (const auto &match : treeMatches)
+    {
+        if (match.CopyCount != 0)
+            delta.TypeTrees.push_back({ .CopyFirst = match.CopyFirst, .CopyCount = match.CopyCount, .Nodes = {} });
+        else
+            delta.TypeTrees.push_back(encodeTree(target.TypeTrees[match.Target], match.BaseTree, match.BaseTree));
+    }
+
+    using ScriptKey = std::tuple<std::string, std::string, std::string, uint64_t>;
+    std::vector<ScriptKey> baseScriptKeys;
+    std::vector<ScriptKey> targetScriptKeys;
+    for (const auto &script : base.Scripts)
+    {
+        baseScriptKeys.emplace_back(script.AssemblyName, script.Namespace, script.ClassName, script.Tree.TransferFlags);
+    }
+
+    for (const auto &script : target.Scripts)
+    {
+        targetScriptKeys.emplace_back(script.AssemblyName, script.Namespace, script.ClassName, script.Tree.TransferFlags);
+    }
+
+    const auto scriptMatches = MatchTrees<ScriptKey>(baseScriptKeys, targetScriptKeys, [&](const uint32_t baseScript, const uint32_t targetScript)
+    {
+        const auto &lhs = base.Scripts[baseScript];
+        const auto &rhs = target.Scripts[targetScript];
+        return lhs.RefTypeHash == rhs.RefTypeHash && isSameTree(lhs.Tree, rhs.Tree);
+    });
+
+    for (const auto &match : scriptMatches)
+    {
+        if (match.CopyCount != 0)
+        {
+            delta.Scripts.push_back({
+                .AssemblyName = {},
+                .Namespace = {},
+                .ClassName = {},
+                .Tree = { .CopyFirst = match.CopyFirst, .CopyCount = match.CopyCount, .Nodes = {} },
+            });
+            continue;
+        }
+
+        const auto &script = target.Scripts[match.Target];
+        const auto sourceTree = match.BaseTree != DumpedTypeTreeDeltaTree::kNoBaseTree
+            ? static_cast<uint32_t>(base.TypeTrees.size()) + match.BaseTree
+            : DumpedTypeTreeDeltaTree::kNoBaseTree;
+
+        delta.Scripts.push_back({
+            .AssemblyName = script.AssemblyName,
+            .Namespace = script.Namespace,
+            .ClassName = script.ClassName,
+            .RefTypeHash = script.RefTypeHash,
+            .Tree = encodeTree(script.Tree, match.BaseTree, sourceTree),
+        });
+    }
+
+    if (target.Shard.has_value())
+    {
+        delta.Header.Flags |= DumpedTypeTreeDeltaHeader::kDeltaFlagShard;
+        delta.Shard = target.Shard;
+    }
+
+    if (target.Hierarchy.has_value())
+    {
+        delta.Header.Flags |= DumpedTypeTreeDeltaHeader::kDeltaFlagHierarchy;
+
+        if (BuildTypeHierarchy(target.TypeTrees).Types != target.Hierarchy->Types)
+        {
+            delta.Header.Flags |= DumpedTypeTreeDeltaHeader::kDeltaFlagStoredHierarchy;
+            delta.Hierarchy = target.Hierarchy;
+        }
+    }
+
+    for (const auto &serializedBlobs : target.SerializedBlobs)
+    {
+        delta.SerializedBlobFormatVersions.push_back(serializedBlobs.FormatVersion);
+    }
+
+    if (RebuildSerializedBlobs(target, delta.SerializedBlobFormatVersions) != target.SerializedBlobs)
+        delta.Header.Flags |= DumpedTypeTreeDeltaHeader::kDeltaFlagStoredSerializedBlobs;
+
+    if (delta.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredSerializedBlobs)
+        delta.SerializedBlobs = target.SerializedBlobs;
+
+    return delta;
+}
+
+// Reconstructs the target of a delta, checking that the delta belongs to base and reproduces its target exactly
+inline DumpedTypeTreeBinary ApplyDelta(const DumpedTypeTreeBinary &base, const DumpedTypeTreeDelta &delta)
+{
+    using namespace delta_details;
+
+    if (delta.Header.BaseTypeTreeCount != base.TypeTrees.size() || delta.Header.BaseScriptCount != base.Scripts.size()
+        || delta.Header.BaseFingerprint != ComputeDeltaFingerprint(base))
+    {
+        throw std::runtime_error("The delta was made against a different base");
+    }
+
+    DumpedTypeTreeBinary target{};
+    target.Header = delta.TargetHeader;
+    target.CompressionBlockSize = delta.CompressionBlockSize;
+
+    size_t newString = 0;
+    for (const auto &run : delta.StringRuns)
+    {
+        for (uint32_t i = 0; i < run.Count; i++)
+        {
+            std::string_view value;
+            if (run.First == DumpedTypeTreeDeltaRun::kNewStrings)
+            {
+                if (newString == delta.NewStrings.size())
+                    throw std::runtime_error("Invalid string run");
+
+                value = delta.NewStrings[newString++];
+            }
+            else
+            {
+                if (uint64_t{ run.First } + i >= base.Strings.Size())
+                    throw std::runtime_error("Invalid string run");
+
+                value = base.Strings.Get(run.First + i);
+            }
+
+            if (const auto id = target.Strings.Size(); target.Strings.Intern(value) != id)
+                throw std::runtime_error("Duplicate string in string table");
+        }
+    }
+
+    target.CommonStringBuffer = delta.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagCommonStringBuffer
+        ? delta.CommonStringBuffer
+        : base.CommonStringBuffer;
+
+    const auto stringMap = MapStrings(base.Strings, target.Strings);
+    const auto sources = GetSourceTrees(base);
+
+    const auto decodeTree = [&](const DumpedTypeTreeDeltaTree &value)
+    {
+        DumpedTypeTree tree{
+            .RTTI = value.RTTI,
+            .TransferFlags = value.TransferFlags,
+            .Nodes = DecodeNodes(value.Nodes, sources, stringMap, target.Strings),
+            .CompactNodes = {},
+        };
+
+        ComputeTypeHashes(tree, target.Strings);
+        return tree;
+    };
+
+    for (const auto &value : delta.TypeTrees)
+    {
+        if (value.CopyCount == 0)
+        {
+            target.TypeTrees.push_back(decodeTree(value));
+            continue;
+        }
+
+        if (uint64_t{ value.CopyFirst } + value.CopyCount > base.TypeTrees.size())
+            throw std::runtime_error("Invalid tree copy");
+
+        for (uint32_t i = 0; i < value.CopyCount; i++)
+        {
+            auto &tree = target.TypeTrees.emplace_back(base.TypeTrees[value.CopyFirst + i]);
+            for (auto &node : tree.Nodes)
+            {
+                node = MoveNode(node, stringMap);
+            }
+        }
+    }
+
+    for (const auto &value : delta.Scripts)
+    {
+        if (value.Tree.CopyCount == 0)
+        {
+            target.Scripts.push_back({
+                .AssemblyName = value.AssemblyName,
+                .Namespace = value.Namespace,
+                .ClassName = value.ClassName,
+                .RefTypeHash = value.RefTypeHash,
+                .Tree = decodeTree(value.Tree),
+            });
+            continue;
+        }
+
+        if (uint64_t{ value.Tree.CopyFirst } + value.Tree.CopyCount > base.Scripts.size())
+            throw std::runtime_error("Invalid tree copy");
+
+        for (uint32_t i = 0; i < value.Tree.CopyCount; i++)
+        {
+            auto &script = target.Scripts.emplace_back(base.Scripts[value.Tree.CopyFirst + i]);
+            for (auto &node : script.Tree.Nodes)
+            {
+                node = MoveNode(node, stringMap);
+            }
+        }
+    }
+
+    target.Shard = delta.Shard;
+
+    if (delta.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredHierarchy)
+        target.Hierarchy = delta.Hierarchy;
+    else if (delta.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagHierarchy)
+        target.Hierarchy = BuildTypeHierarchy(target.TypeTrees);
+
+    if (delta.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredSerializedBlobs)
+        target.SerializedBlobs = delta.SerializedBlobs;
+    else
+        target.SerializedBlobs = RebuildSerializedBlobs(target, delta.SerializedBlobFormatVersions);
+
+    if (ComputeDeltaFingerprint(target) != delta.Header.TargetFingerprint)
+        throw std::runtime_error("The delta does not reproduce its target");
+
+    return target;
+}
+
+namespace internal
+{
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDeltaHeader &value)
+    {
+        Write(output, value.Magic);
+        Write(output, value.Version);
+        Write(output, value.BaseFingerprint);
+        Write(output, value.TargetFingerprint);
+        Write(output, value.BaseTypeTreeCount);
+        Write(output, value.BaseScriptCount);
+        Write(output, value.Flags);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDeltaRun &value)
+    {
+        Write(output, value.First);
+        Write(output, value.Count);
+    }
+
+    // Literal nodes are written with every field but the ones computed again, copies with the root's positional fields
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDeltaNode &value)
+    {
+        Write(output, value.SourceTree);
+
+        const auto &node = value.Node;
+        if (value.SourceTree != DumpedTypeTreeDeltaNode::kLiteral)
+        {
+            Write(output, value.SourcePosition);
+            Write(output, node.Level);
+            Write(output, node.Index);
+            Write(output, node.ByteOffset);
+            return;
+        }
+
+        Write(output, node.TypeStringID);
+        Write(output, node.NameStringID);
+        Write(output, node.Flags);
+        Write(output, node.ByteSize);
+        Write(output, node.Index);
+        Write(output, node.Version);
+        Write(output, node.Level);
+        Write(output, node.MetaFlags);
+        Write(output, node.RefTypeHash);
+        Write(output, node.TypeCommonOffset);
+        Write(output, node.NameCommonOffset);
+        Write(output, node.ByteOffset);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDeltaTree &value)
+    {
+        Write(output, value.CopyFirst);
+        Write(output, value.CopyCount);
+
+        if (value.CopyCount != 0)
+            return;
+
+        Write(output, value.BaseTree);
+        Write(output, value.RTTI);
+        Write(output, value.TransferFlags);
+        Write(output, value.Nodes);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDeltaScript &value)
+    {
+        Write(output, value.Tree.CopyFirst);
+        Write(output, value.Tree.CopyCount);
+
+        if (value.Tree.CopyCount != 0)
+            return;
+
+        Write(output, value.AssemblyName);
+        Write(output, value.Namespace);
+        Write(output, value.ClassName);
+        Write(output, value.RefTypeHash);
+        Write(output, value.Tree.BaseTree);
+        Write(output, value.Tree.RTTI);
+        Write(output, value.Tree.TransferFlags);
+        Write(output, value.Tree.Nodes);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const DumpedTypeTreeDelta &value)
+    {
+        Write(output, value.Header);
+        Write(output, value.TargetHeader);
+        Write(output, value.CompressionBlockSize);
+        Write(output, value.StringRuns);
+        Write(output, value.NewStrings);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagCommonStringBuffer)
+            WriteBlob(output, value.CommonStringBuffer);
+
+        Write(output, value.TypeTrees);
+        Write(output, value.Scripts);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagShard)
+            Write(output, value.Shard.value());
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredHierarchy)
+            Write(output, value.Hierarchy.value());
+
+        Write(output, value.SerializedBlobFormatVersions);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredSerializedBlobs)
+            WriteSerializedBlobs(output, value.SerializedBlobs);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDeltaHeader &value)
+    {
+        Read(input, value.Magic);
+        Read(input, value.Version);
+        Read(input, value.BaseFingerprint);
+        Read(input, value.TargetFingerprint);
+        Read(input, value.BaseTypeTreeCount);
+        Read(input, value.BaseScriptCount);
+        Read(input, value.Flags);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDeltaRun &value)
+    {
+        Read(input, value.First);
+        Read(input, value.Count);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDeltaNode &value)
+    {
+        Read(input, value.SourceTree);
+
+        auto &node = value.Node;
+        if (value.SourceTree != DumpedTypeTreeDeltaNode::kLiteral)
+        {
+            Read(input, value.SourcePosition);
+            Read(input, node.Level);
+            Read(input, node.Index);
+            Read(input, node.ByteOffset);
+            return;
+        }
+
+        Read(input, node.TypeStringID);
+        Read(input, node.NameStringID);
+        Read(input, node.Flags);
+        Read(input, node.ByteSize);
+        Read(input, node.Index);
+        Read(input, node.Version);
+        Read(input, node.Level);
+        Read(input, node.MetaFlags);
+        Read(input, node.RefTypeHash);
+        Read(input, node.TypeCommonOffset);
+        Read(input, node.NameCommonOffset);
+        Read(input, node.ByteOffset);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDeltaTree &value)
+    {
+        Read(input, value.CopyFirst);
+        Read(input, value.CopyCount);
+
+        if (value.CopyCount != 0)
+            return;
+
+        Read(input, value.BaseTree);
+        Read(input, value.RTTI);
+        Read(input, value.TransferFlags);
+        Read(input, value.Nodes);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDeltaScript &value)
+    {
+        Read(input, value.Tree.CopyFirst);
+        Read(input, value.Tree.CopyCount);
+
+        if (value.Tree.CopyCount != 0)
+            return;
+
+        Read(input, value.AssemblyName);
+        Read(input, value.Namespace);
+        Read(input, value.ClassName);
+        Read(input, value.RefTypeHash);
+        Read(input, value.Tree.BaseTree);
+        Read(input, value.Tree.RTTI);
+        Read(input, value.Tree.TransferFlags);
+        Read(input, value.Tree.Nodes);
+    }
+
+    template<>
+    inline void Read(std::istream &input, DumpedTypeTreeDelta &value)
+    {
+        Read(input, value.Header);
+
+        if (value.Header.Magic != DumpedTypeTreeDeltaHeader::kDefaultMagic)
+            throw std::runtime_error("Invalid magic number");
+
+        if (value.Header.Version != DumpedTypeTreeDeltaHeader::kVersion1)
+            throw std::runtime_error("Unsupported version");
+
+        Read(input, value.TargetHeader);
+        Read(input, value.CompressionBlockSize);
+        Read(input, value.StringRuns);
+        Read(input, value.NewStrings);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagCommonStringBuffer)
+            ReadBlob(input, value.CommonStringBuffer);
+
+        Read(input, value.TypeTrees);
+        Read(input, value.Scripts);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagShard)
+            Read(input, value.Shard.emplace());
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredHierarchy)
+            Read(input, value.Hierarchy.emplace());
+
+        Read(input, value.SerializedBlobFormatVersions);
+
+        if (value.Header.Flags & DumpedTypeTreeDeltaHeader::kDeltaFlagStoredSerializedBlobs)
+        {
+            const auto typeTreeCount = delta_details::GetTargetCount(value.TypeTrees.size(), [&](const size_t i) -> const DumpedTypeTreeDeltaTree &
+            {
+                return value.TypeTrees[i];
+            }, value.Header.BaseTypeTreeCount);
+
+            const auto scriptCount = delta_details::GetTargetCount(value.Scripts.size(), [&](const size_t i) -> const DumpedTypeTreeDeltaTree &
+            {
+                return value.Scripts[i].Tree;
+            }, value.Header.BaseScriptCount);
+
+            ReadSerializedBlobs(input, value.SerializedBlobs, typeTreeCount, scriptCount);
+        }
+    }
+}
@@ -5,7 +5,9 @@
 #include <span>
 #include <functional>
 #include <algorithm>
+#include <map>
 #include <ranges>
+#include <sstream>
 
 #include "MemLabelId.hpp"
 #include "Object.hpp"
@@ -14,6 +16,13 @@
 #include "dumper.hpp"
 #include "executable.hpp"
 #include "binary_output.hpp"
+#include "options.hpp"
+#include "output_buffer.hpp"
+#include "raw_capture_output.hpp"
+#include "profile.hpp"
+#include "scripting.hpp"
+#include "trace.hpp"
+#include "vtable.hpp"
 
 struct IDumper
 {
@@ -34,6 +43,7 @@ class Dumper : public IDumper
     using RTTI = ::RTTI<R, V>;
 
     using DumpedTypeTreeWriter = ::DumpedTypeTreeWriter<R, V>;
+    using RawCaptureWriter = ::RawCaptureWriter<R, V>;
 
     bool IsValidPointer(void const *ptr, const size_t size, const uint8_t expectedProtection = ExecutableSection::kSectionProtectionRead)
     {
@@ -91,7 +101,8 @@ class Dumper : public IDumper
 
         return false;
     }
-
+public:
+    // The memory scans are public so that they can be benchmarked in isolation
     RuntimeTypeArray const *GetRuntimeTypeArray()
     {
         PlatformImpl.DebugLog("Retrieving RuntimeTypeArray");
@@ -147,6 +158,105 @@ class Dumper : public IDumper
 
         return nullptr;
     }
+
+    // The common string buffer is a sequence of null-terminated strings ending with an empty string.
+    // Returns it up to and including that empty string, or up to the end of its section if there is none.
+    std::string_view GetCommonStringBufferExtent(char const *pTable)
+    {
+        for (const auto &section : PlatformImpl.GetExecutableSections())
+        {
+            if (!section.IsValidPointer(pTable, 1))
+                continue;
+
+            char const *const end = section.Data.data() + section.Data.size();
+
+            auto string = pTable;
+            while (string != end && *string != '\0')
+            {
+                string = std::find(string, end, '\0');
+                if (string != end)
+                    string++;
+            }
+
+            return { pTable, static_cast<size_t>((string != end ? string + 1 : end) - pTable) };
+        }
+
+        return {};
+    }
+private:
+    // Returns the VirtualRedirectTransfer(GenerateTypeTreeTransfer &) implementation of an object.
+    // Types sharing an implementation and a size generate the same tree, except for the root type name.
+    void const *GetTransferImplementation(Object const *object)
+    {
+        static const auto kTransferSlot = GetVirtualFunctionSlot<Object>([](Object *probe)
+        {
+            alignas(GenerateTypeTreeTransfer) char transfer[sizeof(GenerateTypeTreeTransfer)];
+            probe->VirtualRedirectTransfer(*reinterpret_cast<GenerateTypeTreeTransfer *>(transfer));
+        });
+
+        if (kTransferSlot >= vtable_details::kMaxProbedSlots)
+            return nullptr;
+
+        const auto vtable = *reinterpret_cast<void const *const *const *>(object);
+        if (!IsValidPointer(vtable + kTransferSlot, sizeof(void const *)))
+            return nullptr;
+
+        return vtable[kTransferSlot];
+    }
+
+    // Platforms may optionally report the process resident set size for cost profiles
+    uint64_t GetResidentSetSize()
+    {
+        if constexpr (requires { { PlatformImpl.GetResidentSetSize() } -> std::convertible_to<uint64_t>; })
+        {
+            return PlatformImpl.GetResidentSetSize();
+        }
+
+        return 0;
+    }
+
+    // Platforms may optionally enumerate the loaded scripting classes
+    std::vector<ScriptingClass> GetScriptingClasses()
+    {
+        if constexpr (requires { { PlatformImpl.GetScriptingClasses() } -> std::convertible_to<std::vector<ScriptingClass>>; })
+        {
+            return PlatformImpl.GetScriptingClasses();
+        }
+
+        PlatformImpl.DebugLog("Scripting classes cannot be enumerated on this platform");
+        return {};
+    }
+
+    RTTI *FindRTTI(RuntimeTypeArray const *pArray, const std::string_view className)
+    {
+        for (int32_t i = 0; i < pArray->Count; i++)
+        {
+            if (pArray->Types[i]->className == className)
+                return pArray->Types[i];
+        }
+
+        return nullptr;
+    }
+
+    // Generates the tree of a managed class through the native MonoBehaviour type, with an instance of the class attached
+    void TransferScriptingClass(RTTI *pRTTI, const ScriptingClass &scriptingClass, const TransferInstructionFlags &flags, TypeTree &tree)
+    {
+        MemLabelId label;
+        Object *object = pRTTI->factory(label, kCreateObjectDefault);
+
+        if constexpr (requires { object->SetCachedScriptingObject(static_cast<MonoObject *>(nullptr)); })
+        {
+            object->SetCachedScriptingObject(static_cast<MonoObject *>(scriptingClass.Instance));
+        }
+        else
+        {
+            object->SetCachedScriptingObject(ScriptingObjectPtr(scriptingClass.Instance));
+        }
+
+        GenerateTypeTreeTransfer transfer(tree, flags, object, pRTTI->size);
+        transfer.SetScriptingObject(scriptingClass.InstanceData, scriptingClass.InstanceDataSize);
+        object->VirtualRedirectTransfer(transfer);
+    }
 public:
     void Run() override
     {
@@ -154,14 +264,129 @@ public:
 
         if constexpr (R >= Revision::V5_2_0)
         {
-            auto pArray = GetRuntimeTypeArray();
-            auto pTable = GetCommonStringBuffer();
+            const auto options = DumperOptions::FromEnvironment();
 
-            const auto dumpTypes = [&](const TransferInstructionFlags &flags, const std::string_view outputName)
+            if (options.InvalidShard.has_value())
             {
-                for (int i = 0; i < pArray->Count; i++)
+                PlatformImpl.DebugLog((std::string("Invalid ") + DumperOptions::kShardEnvironmentVariable + " \"" + options.InvalidShard.value()
+                    + "\", expected <index>/<count> with index below count, nothing was dumped").c_str());
+                return;
+            }
+
+            TraceRecorder tracer(options.Trace ? TraceRecorder::kDefaultCapacity : 0);
+
+            {
+                TraceScope scope(tracer, "EnumerateSections");
+                PlatformImpl.GetExecutableSections();
+            }
+
+            RuntimeTypeArray const *pArray;
+            {
+                TraceScope scope(tracer, "ScanRuntimeTypeArray");
+                pArray = GetRuntimeTypeArray();
+            }
+
+            char const *pTable;
+            {
+                TraceScope scope(tracer, "ScanCommonStringBuffer");
+                pTable = GetCommonStringBuffer();
+            }
+
+            Writer.SetDeduplicateTrees(options.DeduplicateTrees);
+            Writer.SetUseStringTable(options.UseStringTable);
+            Writer.SetUseCommonStrings(options.UseCommonStrings);
+            Writer.SetUseByteOffsets(options.UseByteOffsets);
+            Writer.SetUseNavigation(options.UseNavigation);
+            Writer.SetUseSubtreeHashes(options.UseSubtreeHashes);
+            Writer.SetUseTypeHashes(options.UseTypeHashes);
+            Writer.SetEmitHierarchy(options.Hierarchy);
+            Writer.SetUseSubtreeReferences(options.UseSubtreeReferences);
+            Writer.SetUseTreeSets(options.UseTreeSets);
+            Writer.SetUseChecksums(options.UseChecksums);
+            Writer.SetUseColumnarFormat(options.Columnar);
+            Writer.SetCompressionBlockSize(options.CompressionBlockSize);
+            Writer.SetEmitSerializedBlobs(options.SerializedBlobs);
+
+            const auto commonStringBuffer = GetCommonStringBufferExtent(pTable);
+            Writer.SetCommonStringBuffer(commonStringBuffer);
+            RawWriter.SetCommonStringBuffer(commonStringBuffer);
+
+            // When sharding, only a contiguous range of the RuntimeTypeArray is dumped. The resulting
+            // partial files are combined by the native tool's merge command.
+            uint32_t typeIndexBegin = 0;
+            uint32_t typeIndexEnd = pArray->Count;
+
+            if (options.Shard.has_value())
+            {
+                std::tie(typeIndexBegin, typeIndexEnd) = options.Shard->GetTypeIndexRange(pArray->Count);
+
+                const DumpedTypeTreeShard shard{
+                    .TypeIndexBegin = typeIndexBegin,
+                    .TypeIndexEnd = typeIndexEnd,
+                    .TypeCount = static_cast<uint32_t>(pArray->Count),
+                };
+
+                Writer.SetShard(shard);
+                RawWriter.SetShard(shard);
+
+                PlatformImpl.DebugLog(("Dumping shard " + std::to_string(options.Shard->Index) + " of " + std::to_string(options.Shard->Count)
+                    + " (types " + std::to_string(typeIndexBegin) + " to " + std::to_string(typeIndexEnd) + ")").c_str());
+            }
+
+            const auto getOutputName = [&](const std::string_view name, const std::string_view extension)
+            {
+                if (!options.Shard.has_value())
+                    return std::string(name) + std::string(extension);
+
+                return std::string(name) + ".shard-" + std::to_string(options.Shard->Index) + "-of-" + std::to_string(options.Shard->Count) + std::string(extension);
+            };
+
+            // Scripting classes are not part of the RuntimeTypeArray, so they are dumped with the first shard
+            std::vector<ScriptingClass> scriptingClasses;
+            RTTI *pMonoBehaviour = nullptr;
+
+            if (options.Scripts && (!options.Shard.has_value() || options.Shard->Index == 0))
+            {
+                TraceScope scope(tracer, "EnumerateScriptingClasses");
+
+                scriptingClasses = GetScriptingClasses();
+                pMonoBehaviour = FindRTTI(pArray, "MonoBehaviour");
+
+                if (pMonoBehaviour == nullptr || pMonoBehaviour->isAbstract || !pMonoBehaviour->factory)
+                {
+                    PlatformImpl.DebugLog("MonoBehaviour type not found, skipping scripting classes");
+                    scriptingClasses.clear();
+                }
+
+                PlatformImpl.DebugLog(("Found " + std::to_string(scriptingClasses.size()) + " scripting classes").c_str());
+            }
+
+            TypeCostProfile profile;
+
+            const auto getTypeTreeCount = [&]
+            {
+                return options.RawCapture ? RawWriter.GetTypeTreeCount() : Writer.GetTypeTreeCount();
+            };
+
+            // Captured trees are only converted offline
+            const auto convertPhase = options.RawCapture ? "Capture" : "Convert";
+
+            // Building a message per type is not free, so it is only done when asked for and never while tracing
+            const auto logTypes = options.Verbose && !options.Trace;
+
+            const auto dumpTypes = [&](const TransferInstructionFlags &flags, const std::string_view outputName, const bool writeOutput)
+            {
+                // Trees depend on the transfer flags, so memoized trees are only reused within a pass
+                TraceScope passScope(tracer, "DumpTypes", outputName.data());
+
+                std::map<std::pair<void const *, int32_t>, size_t> memoizedTrees;
+                uint32_t reusedCount = 0;
+                uint32_t verifiedCount = 0;
+
+                for (uint32_t i = typeIndexBegin; i < typeIndexEnd; i++)
                 {
-                    PlatformImpl.DebugLog((std::string("Processing type ") + pArray->Types[i]->className).c_str());
+                    if (logTypes)
+                        PlatformImpl.DebugLog((std::string("Processing type ") + pArray->Types[i]->className).c_str());
 
                     RTTI *pRTTI = pArray->Types[i];
 
@@ -169,29 +394,174 @@ public:
                     TypeTreeShareableData data(label);
                     TypeTree tree(&data, label);
 
+                    std::optional<size_t> verifySourceIndex;
+
+                    TraceScope typeScope(tracer, "Type", pRTTI->className);
+                    TracePhases phases(tracer, pRTTI->className);
+
+                    TypeCostProfileEntry profileEntry{
+                        .TypeIndex = i,
+                        .PersistentTypeID = pRTTI->persistentTypeID,
+                        .ClassName = pRTTI->className,
+                    };
+
+                    ProfileStopwatch stopwatch;
+
+                    if (options.Profile)
+                        profileEntry.ResidentBytesBefore = GetResidentSetSize();
+
+                    const auto addProfileEntry = [&]
+                    {
+                        if (!options.Profile)
+                            return;
+
+                        profileEntry.ConvertTime = stopwatch.Lap();
+                        profileEntry.ResidentBytesAfter = GetResidentSetSize();
+
+                        // The strings of captured trees are only resolved when they are converted
+                        if (options.RawCapture)
+                        {
+                            profileEntry.NodeCount = static_cast<uint32_t>(RawWriter.GetNodeCount(RawWriter.GetTypeTreeCount() - 1));
+                        }
+                        else
+                        {
+                            const auto &nodes = Writer.GetNodes(Writer.GetTypeTreeCount() - 1);
+                            profileEntry.NodeCount = static_cast<uint32_t>(nodes.size());
+
+                            for (const auto &node : nodes)
+                                profileEntry.StringBytes += Writer.GetString(node.TypeStringID).size() + Writer.GetString(node.NameStringID).size();
+                        }
+
+                        profile.Add(std::move(profileEntry));
+                    };
+
                     if (!pRTTI->isAbstract && pRTTI->factory)
                     {
                         Object *object = pRTTI->factory(label, kCreateObjectDefault);
+                        profileEntry.FactoryTime = stopwatch.Lap();
+                        phases.EndPhase("Factory");
+
+                        const auto implementation = options.Memoize ? GetTransferImplementation(object) : nullptr;
+                        if (implementation != nullptr)
+                        {
+                            const auto [memoized, inserted] = memoizedTrees.try_emplace(std::make_pair(implementation, pRTTI->size), getTypeTreeCount());
+
+                            if (!inserted)
+                            {
+                                reusedCount++;
+
+                                // Captured trees cannot be compared before they are converted, so they are not verified
+                                if (options.MemoizeVerifyInterval == 0 || options.RawCapture || reusedCount % options.MemoizeVerifyInterval != 0)
+                                {
+                                    profileEntry.IsReused = true;
+
+                                    if (options.RawCapture)
+                                        RawWriter.AddReused(pRTTI, flags, memoized->second);
+                                    else
+                                        Writer.AddReused(pRTTI, flags, memoized->second);
+
+                                    phases.EndPhase(convertPhase);
+                                    addProfileEntry();
+                                    continue;
+                                }
+
+                                verifySourceIndex = memoized->second;
+                            }
+                        }
+
                         GenerateTypeTreeTransfer transfer(tree, flags, object, pRTTI->size);
                         object->VirtualRedirectTransfer(transfer);
+                        profileEntry.TransferTime = stopwatch.Lap();
+                        phases.EndPhase("Transfer");
                     }
 
-                    Writer.Add(pRTTI, tree, flags, pTable);
+                    if (options.RawCapture)
+                        RawWriter.Add(pRTTI, tree, flags);
+                    else
+                        Writer.Add(pRTTI, tree, flags, pTable);
+
+                    phases.EndPhase(convertPhase);
+                    addProfileEntry();
+
+                    if (verifySourceIndex.has_value())
+                    {
+                        verifiedCount++;
+
+                        if (!Writer.IsReusableTree(Writer.GetTypeTreeCount() - 1, verifySourceIndex.value()))
+                        {
+                            PlatformImpl.DebugLog((std::string("Memoized tree mismatch for type ") + pRTTI->className).c_str());
+                        }
+                    }
                 }
 
-                PlatformImpl.DebugLog("Dumped types, now writing to file");
+                for (const auto &scriptingClass : scriptingClasses)
+                {
+                    TraceScope scriptScope(tracer, "Script", scriptingClass.ClassName.c_str());
+
+                    MemLabelId label;
+                    TypeTreeShareableData data(label);
+                    TypeTree tree(&data, label);
 
-                auto outputStream = PlatformImpl.CreateOutputFile(outputName.data());
-                Writer.Write(outputStream);
+                    TransferScriptingClass(pMonoBehaviour, scriptingClass, flags, tree);
+                    if (options.RawCapture)
+                        RawWriter.AddScript(pMonoBehaviour, tree, flags, scriptingClass);
+                    else
+                        Writer.AddScript(pMonoBehaviour, tree, flags, pTable, scriptingClass);
+                }
+
+                if (options.Memoize)
+                {
+                    PlatformImpl.DebugLog(("Reused " + std::to_string(reusedCount - verifiedCount) + " memoized trees, verified "
+                        + std::to_string(verifiedCount)).c_str());
+                }
+
+                ProfileStopwatch writeStopwatch;
+
+                if (writeOutput)
+                {
+                    PlatformImpl.DebugLog("Dumped types, now writing to file");
+                    TraceScope scope(tracer, "WriteTypeTrees", outputName.data());
+
+                    // The file is encoded in memory first and written out in one piece
+                    OutputBuffer outputBuffer;
+                    if (options.RawCapture)
+                        RawWriter.Write(outputBuffer);
+                    else
+                        Writer.Write(outputBuffer, tracer);
+
+                    const auto outputPath = getOutputName(outputName, options.RawCapture ? ".ttraw" : ".ttbin");
+                    if (!PlatformImpl.CreateOutputFile(outputPath.c_str()).Write(outputBuffer))
+                        PlatformImpl.DebugLog(("Failed to write " + outputPath).c_str());
+                }
+
+                if (options.Profile)
+                {
+                    PlatformImpl.DebugLog(("Wrote type trees in " + std::to_string(writeStopwatch.Lap() / 1000000) + " ms").c_str());
+
+                    std::ostringstream profileStream;
+                    profile.WriteCsv(profileStream);
+                    PlatformImpl.CreateOutputFile(getOutputName(outputName, ".profile.csv").c_str()).Write(profileStream.view());
+                    profile.Clear();
+                }
             };
 
-            // Always dump release types
-            dumpTypes(TransferInstructionFlags::kSerializeGameRelease, "release.ttbin");
+            // Always dump release types. With tree sets, the editor file holds them as a set of its own and is the only one written.
+            dumpTypes(TransferInstructionFlags::kSerializeGameRelease, "release", V != Variant::Editor || !options.UseTreeSets);
 
             // If we are in an editor, also dump the editor types
             if constexpr (V == Variant::Editor)
             {
-                dumpTypes(TransferInstructionFlags::kNone, "editor.ttbin");
+                dumpTypes(TransferInstructionFlags::kNone, "editor", true);
+            }
+
+            if (tracer.IsEnabled())
+            {
+                if (const auto dropped = tracer.GetDroppedEventCount(); dropped != 0)
+                    PlatformImpl.DebugLog(("Trace buffer overflowed, dropped the oldest " + std::to_string(dropped) + " events").c_str());
+
+                std::ostringstream traceStream;
+                tracer.WriteJson(traceStream);
+                PlatformImpl.CreateOutputFile(getOutputName("trace", ".json").c_str()).Write(traceStream.view());
             }
         }
     }
@@ -200,6 +570,7 @@ public:
 private:
     TPlatformImpl PlatformImpl{};
     DumpedTypeTreeWriter Writer{};
+    RawCaptureWriter RawWriter{};
 };
 
 template<Revision R, Variant V, typename TPlatformImpl>
@@ -0,0 +1,136 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+//
+// Compile-time translation of engine flag enums into the dumped format's flags.
+// Every mapping moves a single source bit to a single target bit. Mappings that move their bit by the same
+// distance are merged into one mask-and-shift group, so a translation between identical layouts collapses
+// into a single mask, and any other layout into one mask-and-shift per distinct distance.
+//
+
+struct FlagMapping
+{
+    uint64_t Source;
+    uint64_t Target;
+};
+
+struct FlagShiftGroup
+{
+    uint64_t Mask = 0;
+    int32_t Shift = 0;
+};
+
+template<size_t N>
+class FlagTranslation
+{
+public:
+    consteval explicit FlagTranslation(const std::array<FlagMapping, N> &mappings) : Mappings(mappings)
+    {
+        for (const auto &mapping : mappings)
+        {
+            // Not a constant expression, which turns an invalid mapping into a compile error
+            if (!std::has_single_bit(mapping.Source) || !std::has_single_bit(mapping.Target))
+                throw "Flag mappings must map a single bit to a single bit";
+
+            const auto shift = std::countr_zero(mapping.Target) - std::countr_zero(mapping.Source);
+
+            size_t group = 0;
+            while (group < GroupCount && Groups[group].Shift != shift)
+                group++;
+
+            if (group == GroupCount)
+                GroupCount++;
+
+            Groups[group].Mask |= mapping.Source;
+            Groups[group].Shift = shift;
+        }
+    }
+
+    constexpr size_t GetGroupCount() const
+    {
+        return GroupCount;
+    }
+
+    constexpr FlagShiftGroup GetGroup(const size_t index) const
+    {
+        return Groups[index];
+    }
+
+    // Whether every flag keeps its bit position, making the translation a single mask
+    constexpr bool IsIdentity() const
+    {
+        return GroupCount == 0 || (GroupCount == 1 && Groups[0].Shift == 0);
+    }
+
+    constexpr uint64_t Translate(const uint64_t bits) const
+    {
+        uint64_t result = 0;
+        for (size_t i = 0; i < GroupCount; i++)
+        {
+            const auto masked = bits & Groups[i].Mask;
+            result |= Groups[i].Shift >= 0 ? masked << Groups[i].Shift : masked >> -Groups[i].Shift;
+        }
+
+        return result;
+    }
+
+    // Checks the merged groups against the individual mappings, for use in static_asserts
+    constexpr bool IsValid() const
+    {
+        uint64_t sources = 0;
+        uint64_t targets = 0;
+
+        for (const auto &mapping : Mappings)
+        {
+            if (Translate(mapping.Source) != mapping.Target || (sources & mapping.Source) != 0 || (targets & mapping.Target) != 0)
+                return false;
+
+            sources |= mapping.Source;
+            targets |= mapping.Target;
+        }
+
+        // Unmapped bits are dropped
+        return Translate(sources) == targets && Translate(~sources) == 0;
+    }
+private:
+    std::array<FlagMapping, N> Mappings;
+    std::array<FlagShiftGroup, N> Groups{};
+    size_t GroupCount = 0;
+};
+
+template<size_t N>
+consteval auto MakeFlagTranslation(const FlagMapping (&mappings)[N])
+{
+    return FlagTranslation<N>(std::to_array(mappings));
+}
+
+namespace flag_translation_details
+{
+    template<const auto &Translation, size_t I>
+    constexpr uint64_t ApplyGroup(const uint64_t bits)
+    {
+        constexpr auto group = Translation.GetGroup(I);
+
+        if constexpr (group.Shift >= 0)
+            return (bits & group.Mask) << group.Shift;
+        else
+            return (bits & group.Mask) >> -group.Shift;
+    }
+}
+
+// Translates flags through a translation known at compile time, unrolled into its mask-and-shift groups
+template<const auto &Translation, typename T>
+constexpr uint64_t TranslateFlags(const T value)
+{
+    const auto bits = static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(value));
+
+    return [bits]<size_t... I>(std::index_sequence<I...>)
+    {
+        return (uint64_t{ 0 } | ... | flag_translation_details::ApplyGroup<Translation, I>(bits));
+    }(std::make_index_sequence<Translation.GetGroupCount()>{});
+}
@@ -0,0 +1,392 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+//
+// Self-contained implementations of the hash functions type trees are identified by:
+// MD4 (RFC 1320), which Unity's legacy type hash is built on, and the 64-bit XXH3 of xxHash 0.8 with the
+// default secret and seed 0. Both read their input as little-endian words, like the .ttbin format.
+//
+
+namespace hash_algorithms_details
+{
+    inline uint32_t ReadUInt32(const uint8_t *data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+
+        if constexpr (std::endian::native == std::endian::big)
+            value = std::byteswap(value);
+
+        return value;
+    }
+
+    inline uint64_t ReadUInt64(const uint8_t *data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+
+        if constexpr (std::endian::native == std::endian::big)
+            value = std::byteswap(value);
+
+        return value;
+    }
+
+    // The 128-bit product of two 64-bit values, with its halves folded into 64 bits
+    inline uint64_t Multiply128Fold64(const uint64_t left, const uint64_t right)
+    {
+#if defined(__SIZEOF_INT128__)
+        const auto product = static_cast<unsigned __int128>(left) * right;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+        const auto loLo = (left & 0xFFFFFFFF) * (right & 0xFFFFFFFF);
+        const auto hiLo = (left >> 32) * (right & 0xFFFFFFFF);
+        const auto loHi = (left & 0xFFFFFFFF) * (right >> 32);
+        const auto hiHi = (left >> 32) * (right >> 32);
+
+        const auto cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+        const auto upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+        const auto lower = (cross << 32) | (loLo & 0xFFFFFFFF);
+        return lower ^ upper;
+#endif
+    }
+
+    class Md4
+    {
+    public:
+        void Update(const std::span<const uint8_t> data)
+        {
+            auto input = data.data();
+            auto size = data.size();
+            const auto buffered = static_cast<size_t>(Length % kBlockSize);
+            Length += size;
+
+            if (buffered != 0)
+            {
+                const auto fill = (std::min)(size, kBlockSize - buffered);
+                std::memcpy(Buffer.data() + buffered, input, fill);
+                input += fill;
+                size -= fill;
+
+                if (buffered + fill < kBlockSize)
+                    return;
+
+                ProcessBlock(Buffer.data());
+            }
+
+            for (; size >= kBlockSize; input += kBlockSize, size -= kBlockSize)
+            {
+                ProcessBlock(input);
+            }
+
+            std::memcpy(Buffer.data(), input, size);
+        }
+
+        std::array<uint8_t, 16> Finish()
+        {
+            const auto bitLength = Length * 8;
+
+            // 0x80, then zeros up to 8 bytes before the end of a block, then the length in bits
+            std::array<uint8_t, kBlockSize + 8> padding{ 0x80 };
+            const auto buffered = static_cast<size_t>(Length % kBlockSize);
+            const auto padSize = (buffered < kBlockSize - 8 ? kBlockSize - 8 : 2 * kBlockSize - 8) - buffered;
+            Update({ padding.data(), padSize });
+
+            std::array<uint8_t, 8> length;
+            for (size_t i = 0; i < length.size(); i++)
+            {
+                length[i] = static_cast<uint8_t>(bitLength >> (8 * i));
+            }
+
+            Update(length);
+
+            std::array<uint8_t, 16> digest;
+            for (size_t i = 0; i < digest.size(); i++)
+            {
+                digest[i] = static_cast<uint8_t>(State[i / 4] >> (8 * (i % 4)));
+            }
+
+            return digest;
+        }
+    private:
+        static constexpr size_t kBlockSize = 64;
+
+        void ProcessBlock(const uint8_t *block)
+        {
+            uint32_t x[16];
+            for (size_t i = 0; i < 16; i++)
+            {
+                x[i] = ReadUInt32(block + 4 * i);
+            }
+
+            auto [a, b, c, d] = State;
+
+            const auto f = [](const uint32_t x, const uint32_t y, const uint32_t z) { return (x & y) | (~x & z); };
+            const auto g = [](const uint32_t x, const uint32_t y, const uint32_t z) { return (x & y) | (x & z) | (y & z); };
+            const auto h = [](const uint32_t x, const uint32_t y, const uint32_t z) { return x ^ y ^ z; };
+
+            for (size_t i = 0; i < 16; i += 4)
+            {
+                a = std::rotl(a + f(b, c, d) + x[i], 3);
+                d = std::rotl(d + f(a, b, c) + x[i + 1], 7);
+                c = std::rotl(c + f(d, a, b) + x[i + 2], 11);
+                b = std::rotl(b + f(c, d, a) + x[i + 3], 19);
+            }
+
+            for (size_t i = 0; i < 4; i++)
+            {
+                a = std::rotl(a + g(b, c, d) + x[i] + 0x5A827999, 3);
+                d = std::rotl(d + g(a, b, c) + x[i + 4] + 0x5A827999, 5);
+                c = std::rotl(c + g(d, a, b) + x[i + 8] + 0x5A827999, 9);
+                b = std::rotl(b + g(c, d, a) + x[i + 12] + 0x5A827999, 13);
+            }
+
+            for (const size_t i : { 0, 2, 1, 3 })
+            {
+                a = std::rotl(a + h(b, c, d) + x[i] + 0x6ED9EBA1, 3);
+                d = std::rotl(d + h(a, b, c) + x[i + 8] + 0x6ED9EBA1, 9);
+                c = std::rotl(c + h(d, a, b) + x[i + 4] + 0x6ED9EBA1, 11);
+                b = std::rotl(b + h(c, d, a) + x[i + 12] + 0x6ED9EBA1, 15);
+            }
+
+            State[0] += a;
+            State[1] += b;
+            State[2] += c;
+            State[3] += d;
+        }
+
+        std::array<uint32_t, 4> State = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476 };
+        std::array<uint8_t, kBlockSize> Buffer{};
+        uint64_t Length = 0;
+    };
+
+    namespace xxh3
+    {
+        constexpr uint64_t kPrime32_1 = 0x9E3779B1;
+        constexpr uint64_t kPrime32_2 = 0x85EBCA77;
+        constexpr uint64_t kPrime32_3 = 0xC2B2AE3D;
+        constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87;
+        constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4F;
+        constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9;
+        constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63;
+        constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5;
+
+        constexpr size_t kStripeSize = 64;
+        constexpr size_t kSecretConsumeRate = 8;
+        constexpr size_t kAccumulatorCount = kStripeSize / sizeof(uint64_t);
+        constexpr size_t kSecretMergeAccumulatorsStart = 11;
+        constexpr size_t kSecretLastAccumulatorStart = 7;
+        constexpr size_t kSecretSizeMin = 136;
+        constexpr size_t kMidSizeMax = 240;
+
+        constexpr uint8_t kDefaultSecret[192] = {
+            0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+            0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+            0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+            0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+            0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+            0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+            0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+            0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+            0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+            0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+            0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+            0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+        };
+
+        inline uint64_t Xxh64Avalanche(uint64_t value)
+        {
+            value ^= value >> 33;
+            value *= kPrime64_2;
+            value ^= value >> 29;
+            value *= kPrime64_3;
+            return value ^ (value >> 32);
+        }
+
+        inline uint64_t Avalanche(uint64_t value)
+        {
+            value ^= value >> 37;
+            value *= 0x165667919E3779F9;
+            return value ^ (value >> 32);
+        }
+
+        inline uint64_t StrongAvalanche(uint64_t value, const uint64_t size)
+        {
+            value ^= std::rotl(value, 49) ^ std::rotl(value, 24);
+            value *= 0x9FB21C651E98DF25;
+            value ^= (value >> 35) + size;
+            value *= 0x9FB21C651E98DF25;
+            return value ^ (value >> 28);
+        }
+
+        inline uint64_t Mix16(const uint8_t *input, const uint8_t *secret)
+        {
+            return Multiply128Fold64(ReadUInt64(input) ^ ReadUInt64(secret), ReadUInt64(input + 8) ^ ReadUInt64(secret + 8));
+        }
+
+        inline uint64_t Hash0To16(const uint8_t *input, const size_t size)
+        {
+            const auto secret = kDefaultSecret;
+
+            if (size > 8)
+            {
+                const auto lo = ReadUInt64(input) ^ (ReadUInt64(secret + 24) ^ ReadUInt64(secret + 32));
+                const auto hi = ReadUInt64(input + size - 8) ^ (ReadUInt64(secret + 40) ^ ReadUInt64(secret + 48));
+                return Avalanche(size + std::byteswap(lo) + hi + Multiply128Fold64(lo, hi));
+            }
+
+            if (size >= 4)
+            {
+                const auto combined = ReadUInt32(input + size - 4) + (uint64_t{ ReadUInt32(input) } << 32);
+                return StrongAvalanche(combined ^ (ReadUInt64(secret + 8) ^ ReadUInt64(secret + 16)), size);
+            }
+
+            if (size > 0)
+            {
+                const auto combined = (uint32_t{ input[0] } << 16) | (uint32_t{ input[size >> 1] } << 24)
+                    | uint32_t{ input[size - 1] } | (static_cast<uint32_t>(size) << 8);
+                return Xxh64Avalanche(combined ^ uint64_t{ ReadUInt32(secret) ^ ReadUInt32(secret + 4) });
+            }
+
+            return Xxh64Avalanche(ReadUInt64(secret + 56) ^ ReadUInt64(secret + 64));
+        }
+
+        inline uint64_t Hash17To128(const uint8_t *input, const size_t size)
+        {
+            const auto secret = kDefaultSecret;
+            auto acc = size * kPrime64_1;
+
+            if (size > 32)
+            {
+                if (size > 64)
+                {
+                    if (size > 96)
+                    {
+                        acc += Mix16(input + 48, secret + 96);
+                        acc += Mix16(input + size - 64, secret + 112);
+                    }
+
+                    acc += Mix16(input + 32, secret + 64);
+                    acc += Mix16(input + size - 48, secret + 80);
+                }
+
+                acc += Mix16(input + 16, secret + 32);
+                acc += Mix16(input + size - 32, secret + 48);
+            }
+
+            acc += Mix16(input, secret);
+            acc += Mix16(input + size - 16, secret + 16);
+            return Avalanche(acc);
+        }
+
+        inline uint64_t Hash129To240(const uint8_t *input, const size_t size)
+        {
+            const auto secret = kDefaultSecret;
+            auto acc = size * kPrime64_1;
+
+            size_t round = 0;
+            for (; round < 8; round++)
+            {
+                acc += Mix16(input + 16 * round, secret + 16 * round);
+            }
+
+            acc = Avalanche(acc);
+
+            for (; round < size / 16; round++)
+            {
+                acc += Mix16(input + 16 * round, secret + 16 * (round - 8) + 3);
+            }
+
+            acc += Mix16(input + size - 16, secret + kSecretSizeMin - 17);
+            return Avalanche(acc);
+        }
+
+        inline void Accumulate512(uint64_t *acc, const uint8_t *input, const uint8_t *secret)
+        {
+            for (size_t i = 0; i < kAccumulatorCount; i++)
+            {
+                const auto value = ReadUInt64(input + 8 * i);
+                const auto key = value ^ ReadUInt64(secret + 8 * i);
+
+                acc[i ^ 1] += value;
+                acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+            }
+        }
+
+        inline void ScrambleAccumulators(uint64_t *acc, const uint8_t *secret)
+        {
+            for (size_t i = 0; i < kAccumulatorCount; i++)
+            {
+                acc[i] = (acc[i] ^ (acc[i] >> 47) ^ ReadUInt64(secret + 8 * i)) * kPrime32_1;
+            }
+        }
+
+        inline uint64_t HashLong(const uint8_t *input, const size_t size)
+        {
+            const auto secret = kDefaultSecret;
+            constexpr auto kSecretSize = sizeof(kDefaultSecret);
+            constexpr auto kStripesPerBlock = (kSecretSize - kStripeSize) / kSecretConsumeRate;
+            constexpr auto kBlockSize = kStripeSize * kStripesPerBlock;
+
+            uint64_t acc[kAccumulatorCount] = { kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1 };
+
+            const auto blockCount = (size - 1) / kBlockSize;
+            for (size_t block = 0; block < blockCount; block++)
+            {
+                for (size_t stripe = 0; stripe < kStripesPerBlock; stripe++)
+                {
+                    Accumulate512(acc, input + block * kBlockSize + stripe * kStripeSize, secret + stripe * kSecretConsumeRate);
+                }
+
+                ScrambleAccumulators(acc, secret + kSecretSize - kStripeSize);
+            }
+
+            const auto stripeCount = ((size - 1) - blockCount * kBlockSize) / kStripeSize;
+            for (size_t stripe = 0; stripe < stripeCount; stripe++)
+            {
+                Accumulate512(acc, input + blockCount * kBlockSize + stripe * kStripeSize, secret + stripe * kSecretConsumeRate);
+            }
+
+            Accumulate512(acc, input + size - kStripeSize, secret + kSecretSize - kStripeSize - kSecretLastAccumulatorStart);
+
+            auto result = size * kPrime64_1;
+            for (size_t i = 0; i < kAccumulatorCount; i += 2)
+            {
+                const auto mergeSecret = secret + kSecretMergeAccumulatorsStart + 8 * i;
+                result += Multiply128Fold64(acc[i] ^ ReadUInt64(mergeSecret), acc[i + 1] ^ ReadUInt64(mergeSecret + 8));
+            }
+
+            return Avalanche(result);
+        }
+    }
+}
+
+inline std::array<uint8_t, 16> CalculateMd4(const std::span<const uint8_t> data)
+{
+    hash_algorithms_details::Md4 md4;
+    md4.Update(data);
+    return md4.Finish();
+}
+
+inline uint64_t CalculateXxh3_64(const std::span<const uint8_t> data)
+{
+    using namespace hash_algorithms_details::xxh3;
+
+    const auto input = data.data();
+    const auto size = data.size();
+
+    if (size <= 16)
+        return Hash0To16(input, size);
+
+    if (size <= 128)
+        return Hash17To128(input, size);
+
+    if (size <= kMidSizeMax)
+        return Hash129To240(input, size);
+
+    return HashLong(input, size);
+}
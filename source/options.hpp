@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "block_compression.hpp"
+
+//
+// Dumper options are read from the environment, as the dumper runs inside the engine process
+// and has no command line of its own.
+//
+
+struct DumperOptions
+{
+    // "<index>/<count>", e.g. "2/8" dumps the third of eight equally sized RuntimeTypeArray ranges
+    static constexpr auto kShardEnvironmentVariable = "TYPETREERIPPER_SHARD";
+
+    struct ShardOptions
+    {
+        uint32_t Index;
+        uint32_t Count;
+
+        // Splits [0, typeCount) into Count contiguous ranges and returns the range for Index
+        std::pair<uint32_t, uint32_t> GetTypeIndexRange(const uint32_t typeCount) const
+        {
+            const auto begin = static_cast<uint64_t>(typeCount) * Index / Count;
+            const auto end = static_cast<uint64_t>(typeCount) * (Index + 1) / Count;
+            return { static_cast<uint32_t>(begin), static_cast<uint32_t>(end) };
+        }
+    };
+
+    // Reuse the tree of an already dumped type when another type shares both its
+    // VirtualRedirectTransfer(GenerateTypeTreeTransfer &) implementation and its size
+    static constexpr auto kMemoizeEnvironmentVariable = "TYPETREERIPPER_MEMOIZE";
+
+    // Regenerate every Nth reused tree and compare it against the reused one
+    static constexpr auto kMemoizeVerifyEnvironmentVariable = "TYPETREERIPPER_MEMOIZE_VERIFY";
+
+    // Store trees identical to a tree of the same type under other transfer flags as references to it,
+    // producing files with the tree references header flag
+    static constexpr auto kDeduplicateEnvironmentVariable = "TYPETREERIPPER_DEDUPLICATE";
+
+    // Write node strings once in a string table that the nodes refer to by index rather than inline,
+    // producing files with the string table header flag
+    static constexpr auto kStringTableEnvironmentVariable = "TYPETREERIPPER_STRING_TABLE";
+
+    // Store the engine's common string buffer and the nodes' offsets into it,
+    // producing files with the common strings header flag
+    static constexpr auto kCommonStringsEnvironmentVariable = "TYPETREERIPPER_COMMON_STRINGS";
+
+    // Store the nodes' byte offsets within the object's data,
+    // producing files with the byte offsets header flag
+    static constexpr auto kByteOffsetsEnvironmentVariable = "TYPETREERIPPER_BYTE_OFFSETS";
+
+    // Store the nodes' parent, next sibling and subtree size, which readers otherwise compute from the levels,
+    // producing files with the navigation header flag
+    static constexpr auto kNavigationEnvironmentVariable = "TYPETREERIPPER_NAVIGATION";
+
+    // Store the structural hashes of the nodes' subtrees, which readers otherwise compute,
+    // producing files with the subtree hashes header flag
+    static constexpr auto kSubtreeHashesEnvironmentVariable = "TYPETREERIPPER_SUBTREE_HASHES";
+
+    // Store every tree's legacy type hash and 64-bit node hash, which readers otherwise compute,
+    // producing files with the type hashes header flag
+    static constexpr auto kTypeHashesEnvironmentVariable = "TYPETREERIPPER_TYPE_HASHES";
+
+    // Store every subtree shared by several trees once and have the trees refer to it,
+    // producing files with the subtree references header flag
+    static constexpr auto kSubtreeReferencesEnvironmentVariable = "TYPETREERIPPER_SUBTREE_REFERENCES";
+
+    // Store the RTTI of the trees once and group them into a set per pass, producing files with the tree sets
+    // header flag. Editor runs then only write editor.ttbin, which holds the release trees as a set of its own.
+    static constexpr auto kTreeSetsEnvironmentVariable = "TYPETREERIPPER_TREE_SETS";
+
+    // Store the CRC32C of the trees and of every section, or of every compressed block, producing files with the
+    // checksums header flag that readers check before using the parts they read
+    static constexpr auto kChecksumsEnvironmentVariable = "TYPETREERIPPER_CHECKSUMS";
+
+    // Also store the class hierarchy of the dumped types in an optional section
+    static constexpr auto kHierarchyEnvironmentVariable = "TYPETREERIPPER_HIERARCHY";
+
+    // Write version 3 files with fixed-size records and node columns that can be queried in place when memory-mapped,
+    // instead of the stream layout
+    static constexpr auto kColumnarEnvironmentVariable = "TYPETREERIPPER_COLUMNAR";
+
+    // Set to a block size in KiB, e.g. 64, to write version 4 files holding the file in independently compressed
+    // blocks of that size, which readers can decompress selectively
+    static constexpr auto kBlockCompressionEnvironmentVariable = "TYPETREERIPPER_BLOCK_COMPRESSION";
+
+    // Also store every tree as the binary blob SerializedFiles embed, in an optional section
+    static constexpr auto kSerializedBlobsEnvironmentVariable = "TYPETREERIPPER_SERIALIZED_BLOBS";
+
+    // Write a per-type cost profile (<name>.profile.csv) alongside each .ttbin file
+    static constexpr auto kProfileEnvironmentVariable = "TYPETREERIPPER_PROFILE";
+
+    // Write a Chrome trace-event timeline of the dump (trace.json)
+    static constexpr auto kTraceEnvironmentVariable = "TYPETREERIPPER_TRACE";
+
+    // Log every type before dumping it, e.g. to find the type the engine crashes on. Ignored while tracing,
+    // as building the messages would show up in the trace.
+    static constexpr auto kVerboseEnvironmentVariable = "TYPETREERIPPER_VERBOSE";
+
+    // Also dump the trees of the loaded MonoBehaviour and ScriptableObject scripting classes,
+    // on platforms that can enumerate them
+    static constexpr auto kScriptsEnvironmentVariable = "TYPETREERIPPER_SCRIPTS";
+
+    // Write each tree's engine node array and buffers verbatim to a .ttraw capture instead of converting
+    // them in the engine process. Captures are converted into .ttbin files with the native tool.
+    static constexpr auto kRawCaptureEnvironmentVariable = "TYPETREERIPPER_RAW_CAPTURE";
+
+    std::optional<ShardOptions> Shard;
+
+    // The value of TYPETREERIPPER_SHARD when it is malformed. Nothing is dumped then, as a full dump would be taken
+    // for a shard.
+    std::optional<std::string> InvalidShard;
+    bool Memoize = false;
+    uint32_t MemoizeVerifyInterval = 0;
+    bool DeduplicateTrees = false;
+    bool UseStringTable = false;
+    bool UseCommonStrings = false;
+    bool UseByteOffsets = false;
+    bool UseNavigation = false;
+    bool UseSubtreeHashes = false;
+    bool UseTypeHashes = false;
+    bool UseSubtreeReferences = false;
+    bool UseTreeSets = false;
+    bool UseChecksums = false;
+    bool Hierarchy = false;
+    bool Columnar = false;
+    uint32_t CompressionBlockSize = 0;
+    bool SerializedBlobs = false;
+    bool Profile = false;
+    bool Trace = false;
+    bool Verbose = false;
+    bool Scripts = false;
+    bool RawCapture = false;
+
+    static std::optional<uint32_t> ParseUInt32(const std::string_view value)
+    {
+        uint32_t result;
+        if (std::from_chars(value.data(), value.data() + value.size(), result).ec != std::errc{})
+            return std::nullopt;
+
+        return result;
+    }
+
+    static std::optional<ShardOptions> ParseShard(const std::string_view value)
+    {
+        const auto separator = value.find('/');
+        if (separator == std::string_view::npos)
+            return std::nullopt;
+
+        // Both numbers must be complete, so that e.g. "1/3x" is not taken for "1/3"
+        const auto parseNumber = [](const std::string_view number) -> std::optional<uint32_t>
+        {
+            uint32_t result;
+            const auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), result);
+            if (error != std::errc{} || end != number.data() + number.size())
+                return std::nullopt;
+
+            return result;
+        };
+
+        const auto index = parseNumber(value.substr(0, separator));
+        const auto count = parseNumber(value.substr(separator + 1));
+
+        if (!index.has_value() || !count.has_value() || count.value() == 0 || index.value() >= count.value())
+            return std::nullopt;
+
+        return ShardOptions{ .Index = index.value(), .Count = count.value() };
+    }
+
+    static DumperOptions FromEnvironment()
+    {
+        DumperOptions options;
+
+        // An empty value, as left by drivers clearing the variable, dumps all types
+        if (const auto shard = std::getenv(kShardEnvironmentVariable); shard != nullptr && *shard != '\0')
+        {
+            options.Shard = ParseShard(shard);
+            if (!options.Shard.has_value())
+                options.InvalidShard = shard;
+        }
+
+        if (const auto memoize = std::getenv(kMemoizeEnvironmentVariable))
+            options.Memoize = ParseUInt32(memoize).value_or(0) != 0;
+
+        if (const auto interval = std::getenv(kMemoizeVerifyEnvironmentVariable))
+            options.MemoizeVerifyInterval = ParseUInt32(interval).value_or(0);
+
+        if (const auto deduplicate = std::getenv(kDeduplicateEnvironmentVariable))
+            options.DeduplicateTrees = ParseUInt32(deduplicate).value_or(0) != 0;
+
+        if (const auto stringTable = std::getenv(kStringTableEnvironmentVariable))
+            options.UseStringTable = ParseUInt32(stringTable).value_or(0) != 0;
+
+        if (const auto commonStrings = std::getenv(kCommonStringsEnvironmentVariable))
+            options.UseCommonStrings = ParseUInt32(commonStrings).value_or(0) != 0;
+
+        if (const auto byteOffsets = std::getenv(kByteOffsetsEnvironmentVariable))
+            options.UseByteOffsets = ParseUInt32(byteOffsets).value_or(0) != 0;
+
+        if (const auto navigation = std::getenv(kNavigationEnvironmentVariable))
+            options.UseNavigation = ParseUInt32(navigation).value_or(0) != 0;
+
+        if (const auto subtreeHashes = std::getenv(kSubtreeHashesEnvironmentVariable))
+            options.UseSubtreeHashes = ParseUInt32(subtreeHashes).value_or(0) != 0;
+
+        if (const auto typeHashes = std::getenv(kTypeHashesEnvironmentVariable))
+            options.UseTypeHashes = ParseUInt32(typeHashes).value_or(0) != 0;
+
+        if (const auto subtreeReferences = std::getenv(kSubtreeReferencesEnvironmentVariable))
+            options.UseSubtreeReferences = ParseUInt32(subtreeReferences).value_or(0) != 0;
+
+        if (const auto treeSets = std::getenv(kTreeSetsEnvironmentVariable))
+            options.UseTreeSets = ParseUInt32(treeSets).value_or(0) != 0;
+
+        if (const auto checksums = std::getenv(kChecksumsEnvironmentVariable))
+            options.UseChecksums = ParseUInt32(checksums).value_or(0) != 0;
+
+        if (const auto hierarchy = std::getenv(kHierarchyEnvironmentVariable))
+            options.Hierarchy = ParseUInt32(hierarchy).value_or(0) != 0;
+
+        if (const auto columnar = std::getenv(kColumnarEnvironmentVariable))
+            options.Columnar = ParseUInt32(columnar).value_or(0) != 0;
+
+        if (const auto blockCompression = std::getenv(kBlockCompressionEnvironmentVariable))
+            options.CompressionBlockSize = (std::min)(ParseUInt32(blockCompression).value_or(0), kMaximumCompressionBlockSize / 1024) * 1024;
+
+        if (const auto serializedBlobs = std::getenv(kSerializedBlobsEnvironmentVariable))
+            options.SerializedBlobs = ParseUInt32(serializedBlobs).value_or(0) != 0;
+
+        if (const auto profile = std::getenv(kProfileEnvironmentVariable))
+            options.Profile = ParseUInt32(profile).value_or(0) != 0;
+
+        if (const auto trace = std::getenv(kTraceEnvironmentVariable))
+            options.Trace = ParseUInt32(trace).value_or(0) != 0;
+
+        if (const auto verbose = std::getenv(kVerboseEnvironmentVariable))
+            options.Verbose = ParseUInt32(verbose).value_or(0) != 0;
+
+        if (const auto scripts = std::getenv(kScriptsEnvironmentVariable))
+            options.Scripts = ParseUInt32(scripts).value_or(0) != 0;
+
+        if (const auto rawCapture = std::getenv(kRawCaptureEnvironmentVariable))
+            options.RawCapture = ParseUInt32(rawCapture).value_or(0) != 0;
+
+        return options;
+    }
+};
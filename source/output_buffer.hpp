@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+
+//
+// Contiguous, growable byte buffer the binary formats are encoded into before being written out in one piece.
+// Scalars are stored little-endian. Unlike a stream, earlier bytes can be patched in place, e.g. section sizes.
+//
+
+class OutputBuffer
+{
+public:
+    OutputBuffer() = default;
+
+    explicit OutputBuffer(const size_t capacity)
+    {
+        Reserve(capacity);
+    }
+
+    void Write(const void *data, const size_t size)
+    {
+        if (size > Capacity - Size)
+            Grow(size);
+
+        std::memcpy(Data.get() + Size, data, size);
+        Size += size;
+    }
+
+    void Write(const std::string_view value)
+    {
+        Write(value.data(), value.size());
+    }
+
+    template<typename T>
+        requires std::integral<T> || std::floating_point<T>
+    void WriteScalar(T value)
+    {
+        if constexpr (std::endian::native == std::endian::big && std::integral<T> && sizeof(T) > 1)
+            value = std::byteswap(value);
+
+        Write(&value, sizeof(value));
+    }
+
+    // Overwrites a scalar written earlier, at its offset from the start of the buffer
+    template<typename T>
+        requires std::integral<T>
+    void PatchScalar(const size_t offset, T value)
+    {
+        if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1)
+            value = std::byteswap(value);
+
+        std::memcpy(Data.get() + offset, &value, sizeof(value));
+    }
+
+    void Reserve(const size_t capacity)
+    {
+        if (capacity > Capacity)
+            Reallocate(capacity);
+    }
+
+    void Clear()
+    {
+        Size = 0;
+    }
+
+    size_t GetSize() const
+    {
+        return Size;
+    }
+
+    std::span<const char> GetData() const
+    {
+        return { Data.get(), Size };
+    }
+private:
+    static constexpr size_t kMinimumCapacity = 64 * 1024;
+
+    void Grow(const size_t size)
+    {
+        Reallocate((std::max)({ kMinimumCapacity, Capacity * 2, Size + size }));
+    }
+
+    void Reallocate(const size_t capacity)
+    {
+        auto data = std::make_unique_for_overwrite<char[]>(capacity);
+        if (Size != 0)
+            std::memcpy(data.get(), Data.get(), Size);
+
+        Data = std::move(data);
+        Capacity = capacity;
+    }
+
+    std::unique_ptr<char[]> Data;
+    size_t Size = 0;
+    size_t Capacity = 0;
+};
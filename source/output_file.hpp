@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "output_buffer.hpp"
+
+//
+// Binary output file written with a few large unbuffered writes, as returned by IsPlatformImpl::CreateOutputFile.
+// Output is encoded into an OutputBuffer first, so the file never sees small writes.
+//
+
+class OutputFile
+{
+public:
+    OutputFile() = default;
+
+    explicit OutputFile(const std::filesystem::path &path)
+    {
+#if defined(_WIN32)
+        Handle = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        Handle = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    }
+
+    OutputFile(OutputFile &&other) noexcept
+        : Handle(std::exchange(other.Handle, kInvalidHandle))
+    {
+    }
+
+    OutputFile &operator=(OutputFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            Handle = std::exchange(other.Handle, kInvalidHandle);
+        }
+
+        return *this;
+    }
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    ~OutputFile()
+    {
+        Close();
+    }
+
+    bool IsOpen() const
+    {
+        return Handle != kInvalidHandle;
+    }
+
+    explicit operator bool() const
+    {
+        return IsOpen();
+    }
+
+    // Writes all of the data, returning false if the file is not open or the write failed
+    bool Write(std::span<const char> data)
+    {
+        if (!IsOpen())
+            return false;
+
+        while (!data.empty())
+        {
+            const auto chunkSize = (std::min)(data.size(), kMaxChunkSize);
+
+#if defined(_WIN32)
+            DWORD written = 0;
+            if (!WriteFile(Handle, data.data(), static_cast<DWORD>(chunkSize), &written, nullptr) || written == 0)
+                return false;
+#else
+            const auto written = ::write(Handle, data.data(), chunkSize);
+            if (written < 0 && errno == EINTR)
+                continue;
+
+            if (written <= 0)
+                return false;
+#endif
+
+            data = data.subspan(static_cast<size_t>(written));
+        }
+
+        return true;
+    }
+
+    bool Write(const std::string_view value)
+    {
+        return Write(std::span(value.data(), value.size()));
+    }
+
+    bool Write(const OutputBuffer &buffer)
+    {
+        return Write(buffer.GetData());
+    }
+
+    void Close()
+    {
+        if (!IsOpen())
+            return;
+
+#if defined(_WIN32)
+        CloseHandle(Handle);
+#else
+        ::close(Handle);
+#endif
+        Handle = kInvalidHandle;
+    }
+private:
+    // Keeps every write within the limits of a single WriteFile and write call
+    static constexpr size_t kMaxChunkSize = 1 << 30;
+
+#if defined(_WIN32)
+    static inline const HANDLE kInvalidHandle = INVALID_HANDLE_VALUE;
+    HANDLE Handle = INVALID_HANDLE_VALUE;
+#else
+    static constexpr int kInvalidHandle = -1;
+    int Handle = -1;
+#endif
+};
@@ -1,11 +1,12 @@
 #pragma once
 #include "common.hpp"
 #include "executable.hpp"
+#include "output_file.hpp"
 
 template<Revision R, Variant V, typename T>
 concept IsPlatformImpl = requires(T impl, char const *filename)
 {   
     { impl.GetExecutableSections() } -> std::convertible_to<std::span<ExecutableSection>>;
-    { impl.CreateOutputFile(filename) } -> std::convertible_to<std::ofstream>;
+    { impl.CreateOutputFile(filename) } -> std::convertible_to<OutputFile>;
     { impl.DebugLog(filename) } -> std::convertible_to<void>;
 };
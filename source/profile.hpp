@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+// Per-type cost profile, written as a CSV sidecar next to each .ttbin file.
+// Times are in nanoseconds and sizes in bytes. Resident set sizes are 0 on platforms that do not report them.
+//
+
+struct TypeCostProfileEntry
+{
+    uint32_t TypeIndex;
+    int32_t PersistentTypeID;
+    std::string ClassName;
+
+    // The tree was copied from a memoized type rather than generated
+    bool IsReused = false;
+
+    uint64_t FactoryTime = 0;
+    uint64_t TransferTime = 0;
+    uint64_t ConvertTime = 0;
+
+    uint32_t NodeCount = 0;
+    uint64_t StringBytes = 0;
+
+    uint64_t ResidentBytesBefore = 0;
+    uint64_t ResidentBytesAfter = 0;
+};
+
+// Measures consecutive phases with a single clock read per phase.
+class ProfileStopwatch
+{
+    using Clock = std::chrono::steady_clock;
+public:
+    // Returns the time since the previous call, or since construction
+    uint64_t Lap()
+    {
+        const auto now = Clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - Last).count();
+        Last = now;
+        return static_cast<uint64_t>(elapsed);
+    }
+private:
+    Clock::time_point Last = Clock::now();
+};
+
+class TypeCostProfile
+{
+public:
+    void Add(TypeCostProfileEntry entry)
+    {
+        Entries.push_back(std::move(entry));
+    }
+
+    void Clear()
+    {
+        Entries.clear();
+    }
+
+    void WriteCsv(std::ostream &output) const
+    {
+        output << "TypeIndex,PersistentTypeID,ClassName,IsReused,FactoryNs,TransferNs,ConvertNs,NodeCount,StringBytes,ResidentBytesBefore,ResidentBytesAfter\n";
+
+        for (const auto &entry : Entries)
+        {
+            output << entry.TypeIndex << ','
+                << entry.PersistentTypeID << ','
+                << entry.ClassName << ','
+                << (entry.IsReused ? 1 : 0) << ','
+                << entry.FactoryTime << ','
+                << entry.TransferTime << ','
+                << entry.ConvertTime << ','
+                << entry.NodeCount << ','
+                << entry.StringBytes << ','
+                << entry.ResidentBytesBefore << ','
+                << entry.ResidentBytesAfter << '\n';
+        }
+    }
+private:
+    std::vector<TypeCostProfileEntry> Entries;
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_format.hpp"
+
+//
+// .ttraw binary layout, written instead of a .ttbin with TYPETREERIPPER_RAW_CAPTURE:
+// RawCaptureHeader
+// CommonStringBuffer (blob, up to and including its terminating empty string)
+// RawCapturedTree[TreeCount]
+// RawCapturedScript[ScriptCount]
+// DumpedTypeTreeShard (only with kCaptureFlagShard)
+//
+// Blobs are a uint32 byte count followed by the bytes. The node, level, next index and byte offset blobs
+// hold the engine's arrays verbatim, so they can only be interpreted with the TypeTreeNode<R, V> of the
+// revision and variant in the header. The converter checks NodeSize against its own layout.
+//
+
+struct RawCaptureHeader
+{
+    // 'TTRAWCAP' in little-endian
+    static constexpr auto kDefaultMagic = 0x5041435741525454;
+    static constexpr uint32_t kVersion1 = 1;
+
+    uint64_t Magic;
+    uint32_t Version;
+
+    // Revision
+    uint16_t MajorRevision;
+    uint8_t MinorRevision;
+    uint8_t PatchRevision;
+
+    std::string Variant;
+
+    // sizeof(TypeTreeNode<R, V>) in the capturing build
+    uint32_t NodeSize;
+
+    enum Flags : uint32_t
+    {
+        kCaptureFlagShard = 1 << 0,
+    };
+    std::underlying_type_t<Flags> Flags = 0;
+};
+
+struct RawCapturedTree
+{
+    static constexpr auto kNoSourceTree = std::numeric_limits<uint32_t>::max();
+
+    // RTTI records hold pointers into the engine, so they are captured in their dumped form
+    DumpedTypeTreeRTTI RTTI;
+
+    // The engine's TransferInstructionFlags value the tree was generated with
+    uint64_t TransferFlags;
+
+    // Index of an earlier tree generated by the same transfer implementation (see TYPETREERIPPER_MEMOIZE),
+    // whose nodes are reused with the root type name replaced. The arrays are empty for such trees.
+    uint32_t SourceTree = kNoSourceTree;
+
+    std::vector<char> Nodes;
+    std::vector<char> StringBuffer;
+
+    // Only captured from revisions whose TypeTreeShareableData has them, empty otherwise
+    std::vector<char> Levels;
+    std::vector<char> NextIndex;
+    std::vector<char> ByteOffsets;
+};
+
+struct RawCapturedScript
+{
+    std::string AssemblyName;
+    std::string Namespace;
+    std::string ClassName;
+    RawCapturedTree Tree;
+};
+
+struct RawCapture
+{
+    RawCaptureHeader Header;
+    std::vector<char> CommonStringBuffer;
+    std::vector<RawCapturedTree> Trees;
+    std::vector<RawCapturedScript> Scripts;
+    std::optional<DumpedTypeTreeShard> Shard;
+};
+
+namespace internal
+{
+    template<>
+    inline void Write(OutputBuffer &output, const RawCaptureHeader &value)
+    {
+        Write(output, value.Magic);
+        Write(output, value.Version);
+        Write(output, value.MajorRevision);
+        Write(output, value.MinorRevision);
+        Write(output, value.PatchRevision);
+        Write(output, value.Variant);
+        Write(output, value.NodeSize);
+        Write(output, value.Flags);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const RawCapturedTree &value)
+    {
+        Write(output, value.RTTI);
+        Write(output, value.TransferFlags);
+        Write(output, value.SourceTree);
+        WriteBlob(output, value.Nodes);
+        WriteBlob(output, value.StringBuffer);
+        WriteBlob(output, value.Levels);
+        WriteBlob(output, value.NextIndex);
+        WriteBlob(output, value.ByteOffsets);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const RawCapturedScript &value)
+    {
+        Write(output, value.AssemblyName);
+        Write(output, value.Namespace);
+        Write(output, value.ClassName);
+        Write(output, value.Tree);
+    }
+
+    template<>
+    inline void Write(OutputBuffer &output, const RawCapture &value)
+    {
+        Write(output, value.Header);
+        WriteBlob(output, value.CommonStringBuffer);
+        Write(output, value.Trees);
+        Write(output, value.Scripts);
+
+        if (value.Header.Flags & RawCaptureHeader::kCaptureFlagShard)
+            Write(output, value.Shard.value());
+    }
+
+    template<>
+    inline void Read(std::istream &input, RawCaptureHeader &value)
+    {
+        Read(input, value.Magic);
+        Read(input, value.Version);
+        Read(input, value.MajorRevision);
+        Read(input, value.MinorRevision);
+        Read(input, value.PatchRevision);
+        Read(input, value.Variant);
+        Read(input, value.NodeSize);
+        Read(input, value.Flags);
+    }
+
+    template<>
+    inline void Read(std::istream &input, RawCapturedTree &value)
+    {
+        Read(input, value.RTTI);
+        Read(input, value.TransferFlags);
+        Read(input, value.SourceTree);
+        ReadBlob(input, value.Nodes);
+        ReadBlob(input, value.StringBuffer);
+        ReadBlob(input, value.Levels);
+        ReadBlob(input, value.NextIndex);
+        ReadBlob(input, value.ByteOffsets);
+    }
+
+    template<>
+    inline void Read(std::istream &input, RawCapturedScript &value)
+    {
+        Read(input, value.AssemblyName);
+        Read(input, value.Namespace);
+        Read(input, value.ClassName);
+        Read(input, value.Tree);
+    }
+
+    template<>
+    inline void Read(std::istream &input, RawCapture &value)
+    {
+        Read(input, value.Header);
+
+        if (value.Header.Magic != RawCaptureHeader::kDefaultMagic)
+            throw std::runtime_error("Invalid magic number");
+
+        if (value.Header.Version != RawCaptureHeader::kVersion1)
+            throw std::runtime_error("Unsupported version");
+
+        ReadBlob(input, value.CommonStringBuffer);
+        Read(input, value.Trees);
+        Read(input, value.Scripts);
+
+        if (value.Header.Flags & RawCaptureHeader::kCaptureFlagShard)
+            Read(input, value.Shard.emplace());
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common.hpp"
+#include "RTTI.hpp"
+#include "TypeTree.hpp"
+#include "binary_output.hpp"
+#include "output_buffer.hpp"
+#include "raw_capture_format.hpp"
+#include "scripting.hpp"
+
+//
+// Captures trees exactly as the engine generated them, for TYPETREERIPPER_RAW_CAPTURE. The node array and
+// buffers of each tree are copied verbatim, and converted into a .ttbin offline by the native tool's convert
+// command, which runs DumpedTypeTreeWriter<R, V> over them.
+//
+
+template<Revision R, Variant V>
+class RawCaptureWriter
+{
+    using RTTI = ::RTTI<R, V>;
+    using TypeTree = ::TypeTree<R, V>;
+    using TypeTreeNode = ::TypeTreeNode<R, V>;
+    using TransferInstructionFlags = ::TransferInstructionFlags<R, V>;
+
+    template<typename TArray>
+    static std::vector<char> CopyArray(const TArray &array)
+    {
+        const auto bytes = reinterpret_cast<char const *>(array.data());
+        return { bytes, bytes + array.size() * sizeof(*array.data()) };
+    }
+
+    static void CaptureTree(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, RawCapturedTree& capturedTree)
+    {
+        DumpedTypeTreeWriter<R, V>::ConvertRTTI(rtti, capturedTree.RTTI);
+        capturedTree.TransferFlags = static_cast<uint64_t>(flags);
+
+        // Like DumpedTypeTreeWriter, types that cannot be instantiated have no nodes
+        if (rtti->isAbstract || !rtti->factory)
+            return;
+
+        capturedTree.Nodes = CopyArray(tree.Nodes());
+        capturedTree.StringBuffer = CopyArray(tree.StringsBuffer());
+        capturedTree.ByteOffsets = CopyArray(tree.ByteOffsets());
+
+        if constexpr (requires { tree.GetData()->Levels(); tree.GetData()->NextIndex(); })
+        {
+            capturedTree.Levels = CopyArray(tree.GetData()->Levels());
+            capturedTree.NextIndex = CopyArray(tree.GetData()->NextIndex());
+        }
+    }
+public:
+    void Add(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags)
+    {
+        CaptureTree(rtti, tree, flags, Capture.Trees.emplace_back());
+    }
+
+    // Records that a type reuses the tree of an earlier type, see DumpedTypeTreeWriter::AddReused
+    void AddReused(const RTTI* rtti, const TransferInstructionFlags& flags, const size_t sourceIndex)
+    {
+        auto &capturedTree = Capture.Trees.emplace_back();
+
+        DumpedTypeTreeWriter<R, V>::ConvertRTTI(rtti, capturedTree.RTTI);
+        capturedTree.TransferFlags = static_cast<uint64_t>(flags);
+        capturedTree.SourceTree = static_cast<uint32_t>(sourceIndex);
+    }
+
+    void AddScript(const RTTI* rtti, const TypeTree& tree, const TransferInstructionFlags& flags, const ScriptingClass& scriptingClass)
+    {
+        auto &script = Capture.Scripts.emplace_back(RawCapturedScript{
+            .AssemblyName = scriptingClass.AssemblyName,
+            .Namespace = scriptingClass.Namespace,
+            .ClassName = scriptingClass.ClassName,
+            .Tree = {},
+        });
+
+        CaptureTree(rtti, tree, flags, script.Tree);
+    }
+
+    size_t GetTypeTreeCount() const
+    {
+        return Capture.Trees.size();
+    }
+
+    // Returns the number of nodes of a tree, following reused trees to their source
+    size_t GetNodeCount(const size_t index) const
+    {
+        const auto &tree = Capture.Trees[index];
+        if (tree.SourceTree != RawCapturedTree::kNoSourceTree)
+            return GetNodeCount(tree.SourceTree);
+
+        return tree.Nodes.size() / sizeof(TypeTreeNode);
+    }
+
+    // The buffer node offsets with the high bit set refer to, up to and including its terminating empty string
+    void SetCommonStringBuffer(const std::string_view commonStringBuffer)
+    {
+        Capture.CommonStringBuffer.assign(commonStringBuffer.begin(), commonStringBuffer.end());
+    }
+
+    void SetShard(const DumpedTypeTreeShard &shard)
+    {
+        Capture.Shard = shard;
+    }
+
+    void Write(OutputBuffer &output)
+    {
+        const auto &[major, minor, patch] = RevisionToVersion(R);
+
+        Capture.Header = {
+            .Magic = RawCaptureHeader::kDefaultMagic,
+            .Version = RawCaptureHeader::kVersion1,
+            .MajorRevision = major,
+            .MinorRevision = minor,
+            .PatchRevision = patch,
+            .Variant = std::string(VariantToString(V)),
+            .NodeSize = sizeof(TypeTreeNode),
+            .Flags = Capture.Shard.has_value() ? RawCaptureHeader::kCaptureFlagShard : 0u,
+        };
+
+        internal::Write(output, Capture);
+    }
+private:
+    RawCapture Capture;
+};
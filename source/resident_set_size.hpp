@@ -0,0 +1,43 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+//
+// The resident set size of the process on Linux and Android, as cost profiles sample it twice per type.
+// /proc/self/statm is opened once and reread in place, rather than reopened and parsed through a stream every time.
+//
+
+inline uint64_t ReadResidentSetSize()
+{
+    static const auto statm = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    static const auto pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    if (statm < 0)
+        return 0;
+
+    // Total program size, resident set size and five more fields, all in pages
+    char buffer[128];
+    const auto length = pread(statm, buffer, sizeof(buffer), 0);
+    if (length <= 0)
+        return 0;
+
+    const auto end = buffer + length;
+    const char *position = buffer;
+    const auto parseField = [&](uint64_t &value)
+    {
+        while (position != end && *position == ' ')
+            position++;
+
+        const auto [next, error] = std::from_chars(position, end, value);
+        position = next;
+        return error == std::errc{};
+    };
+
+    uint64_t size = 0, resident = 0;
+    if (!parseField(size) || !parseField(resident))
+        return 0;
+
+    return resident * pageSize;
+}
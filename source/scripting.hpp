@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+//
+// A loaded managed class deriving from MonoBehaviour or ScriptableObject. Instances of both are native
+// MonoBehaviour objects, so the class's tree is generated by the native MonoBehaviour type with an
+// instance of the class attached.
+//
+
+struct ScriptingClass
+{
+    std::string AssemblyName;
+    std::string Namespace;
+    std::string ClassName;
+
+    // The managed object (MonoObject *), and its field data following the object header
+    void *Instance = nullptr;
+    void *InstanceData = nullptr;
+    int32_t InstanceDataSize = 0;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "binary_format.hpp"
+
+//
+// Builds the binary type tree blobs SerializedFiles store for every type in their metadata
+// (TypeTree::BlobRead/BlobWrite, SerializedFile format version 12 onwards):
+// int32 NodeCount
+// int32 StringBufferSize
+// Node[NodeCount]
+// char StringBuffer[StringBufferSize]
+//
+// Node records hold uint16 m_Version, uint8 m_Level, uint8 m_TypeFlags, uint32 m_TypeStrOffset, uint32 m_NameStrOffset,
+// int32 m_ByteSize, int32 m_Index and uint32 m_MetaFlag, followed by uint64 m_RefTypeHash from format version 19.
+// String offsets with the high bit set refer to the engine's common string buffer, all other strings are stored in
+// the tree's own buffer in the order the nodes first use them, like the engine does. Blobs are little-endian, tools
+// writing big-endian SerializedFiles have to swap every field.
+//
+
+// The first format version storing blobs, and the first one adding m_RefTypeHash to the node records
+constexpr uint32_t kSerializedFormatVersionBlob = 12;
+constexpr uint32_t kSerializedFormatVersionRefTypeHash = 19;
+
+// The blob layout the engine of a revision writes. Editors from 2019.1 on write format version 19 or later.
+constexpr uint32_t GetSerializedBlobFormatVersion(const uint16_t majorRevision)
+{
+    return majorRevision >= 2019 ? kSerializedFormatVersionRefTypeHash : kSerializedFormatVersionBlob;
+}
+
+namespace serialized_blob_details
+{
+    template<typename T>
+    void Append(std::vector<char> &blob, const T value)
+    {
+        const auto offset = blob.size();
+        blob.resize(offset + sizeof(value));
+        std::memcpy(blob.data() + offset, &value, sizeof(value));
+    }
+}
+
+// Common string offsets are only used when the nodes carry them, i.e. the binary has kHeaderFlagCommonStrings
+inline std::vector<char> BuildSerializedTypeTreeBlob(const std::vector<DumpedTypeTreeNode> &nodes, const DumpedTypeTreeStringTable &strings,
+    const uint32_t formatVersion, const bool useCommonStrings)
+{
+    using serialized_blob_details::Append;
+
+    std::string stringBuffer;
+    std::unordered_map<uint32_t, uint32_t> localOffsets;
+
+    const auto getStringOffset = [&](const uint32_t stringID, const uint32_t commonOffset) -> uint32_t
+    {
+        if (useCommonStrings && commonOffset != DumpedTypeTreeNode::kNotCommonString)
+            return commonOffset | 0x80000000;
+
+        const auto [it, inserted] = localOffsets.try_emplace(stringID, static_cast<uint32_t>(stringBuffer.size()));
+        if (inserted)
+        {
+            stringBuffer += strings.Get(stringID);
+            stringBuffer += '\0';
+        }
+
+        return it->second;
+    };
+
+    std::vector<char> blob;
+    Append(blob, static_cast<int32_t>(nodes.size()));
+    Append(blob, int32_t{});
+
+    for (const auto &node : nodes)
+    {
+        // Resolve type before name, which decides the order of the local strings
+        const auto typeOffset = getStringOffset(node.TypeStringID, node.TypeCommonOffset);
+        const auto nameOffset = getStringOffset(node.NameStringID, node.NameCommonOffset);
+
+        Append(blob, node.Version);
+        Append(blob, node.Level);
+        Append(blob, static_cast<uint8_t>(node.Flags));
+        Append(blob, typeOffset);
+        Append(blob, nameOffset);
+        Append(blob, node.ByteSize);
+        Append(blob, node.Index);
+        Append(blob, node.MetaFlags);
+
+        if (formatVersion >= kSerializedFormatVersionRefTypeHash)
+            Append(blob, node.RefTypeHash);
+    }
+
+    const auto stringBufferSize = static_cast<int32_t>(stringBuffer.size());
+    std::memcpy(blob.data() + sizeof(int32_t), &stringBufferSize, sizeof(stringBufferSize));
+    blob.insert(blob.end(), stringBuffer.begin(), stringBuffer.end());
+    return blob;
+}
+
+// Trees referring to an earlier identical tree share its blob
+inline DumpedTypeTreeSerializedBlobs BuildSerializedBlobs(const uint32_t formatVersion, const std::vector<DumpedTypeTree> &typeTrees,
+    const std::vector<DumpedTypeTreeScript> &scripts, const DumpedTypeTreeStringTable &strings, const bool useCommonStrings)
+{
+    DumpedTypeTreeSerializedBlobs result{ .FormatVersion = formatVersion, .Blobs = {}, .TypeTreeBlobs = {}, .ScriptBlobs = {} };
+
+    const auto addBlob = [&](const std::vector<DumpedTypeTreeNode> &nodes)
+    {
+        if (nodes.empty())
+            return DumpedTypeTreeSerializedBlobs::kNoBlob;
+
+        result.Blobs.push_back(BuildSerializedTypeTreeBlob(nodes, strings, formatVersion, useCommonStrings));
+        return static_cast<uint32_t>(result.Blobs.size() - 1);
+    };
+
+    result.TypeTreeBlobs.reserve(typeTrees.size());
+    for (const auto &tree : typeTrees)
+    {
+        if (tree.ReferencedTree != DumpedTypeTree::kNoReferencedTree)
+            result.TypeTreeBlobs.push_back(result.TypeTreeBlobs[tree.ReferencedTree]);
+        else
+            result.TypeTreeBlobs.push_back(addBlob(tree.Nodes));
+    }
+
+    result.ScriptBlobs.reserve(scripts.size());
+    for (const auto &script : scripts)
+    {
+        result.ScriptBlobs.push_back(addBlob(script.Tree.Nodes));
+    }
+
+    return result;
+}
@@ -0,0 +1,263 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//
+// Timeline recording in the Chrome trace-event format, viewable in chrome://tracing or Perfetto.
+// Spans are recorded as fixed-size events into a ring buffer of the recording thread and only formatted
+// when the trace is written, so recording a span costs two clock reads and no synchronization once the
+// thread has its buffer. When a thread records more events than its buffer holds, its oldest ones are
+// overwritten.
+//
+
+struct TraceEvent
+{
+    // Both strings must outlive the recorder, i.e. be literals or engine-owned (such as RTTI class names)
+    char const *Name;
+    char const *Detail;
+    uint64_t Begin;
+    uint64_t Duration;
+    uint32_t ThreadId;
+};
+
+class TraceRecorder
+{
+    using Clock = std::chrono::steady_clock;
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    // A recorder with no capacity is disabled and records nothing. The capacity applies to every thread.
+    explicit TraceRecorder(const size_t capacity = 0)
+        : Capacity(capacity)
+    {
+    }
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    // A shared disabled recorder, for code that is traced only when its caller passes a recorder
+    static TraceRecorder &Disabled()
+    {
+        static TraceRecorder disabled;
+        return disabled;
+    }
+
+    bool IsEnabled() const
+    {
+        return Capacity != 0;
+    }
+
+    uint64_t Now() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Start).count());
+    }
+
+    void Record(char const *name, char const *detail, const uint64_t begin, const uint64_t end)
+    {
+        auto &buffer = GetThreadBuffer();
+        const TraceEvent event{
+            .Name = name,
+            .Detail = detail,
+            .Begin = begin,
+            .Duration = end - begin,
+            .ThreadId = buffer.ThreadId,
+        };
+
+        // Buffers grow up to the capacity, so that short-lived worker threads stay small
+        if (buffer.Events.size() < Capacity)
+            buffer.Events.push_back(event);
+        else
+            buffer.Events[buffer.NextEvent % Capacity] = event;
+
+        buffer.NextEvent++;
+    }
+
+    // Must not be called while other threads are recording
+    uint64_t GetDroppedEventCount() const
+    {
+        uint64_t dropped = 0;
+        for (const auto &buffer : Buffers)
+        {
+            dropped += buffer->NextEvent - buffer->Events.size();
+        }
+
+        return dropped;
+    }
+
+    // Must not be called while other threads are recording
+    void WriteJson(std::ostream &output) const
+    {
+        output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        auto first = true;
+        for (const auto &buffer : Buffers)
+        {
+            const auto count = buffer->Events.size();
+            for (uint64_t i = buffer->NextEvent - count; i < buffer->NextEvent; i++)
+            {
+                const auto &event = buffer->Events[i % count];
+
+                // Timestamps are in microseconds
+                char timestamps[64];
+                std::snprintf(timestamps, sizeof(timestamps), "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu",
+                    static_cast<unsigned long long>(event.Begin / 1000), static_cast<unsigned long long>(event.Begin % 1000),
+                    static_cast<unsigned long long>(event.Duration / 1000), static_cast<unsigned long long>(event.Duration % 1000));
+
+                output << (!first ? ",\n" : "\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << event.ThreadId << ',' << timestamps << ",\"name\":";
+                WriteJsonString(output, event.Name);
+
+                if (event.Detail != nullptr)
+                {
+                    output << ",\"args\":{\"detail\":";
+                    WriteJsonString(output, event.Detail);
+                    output << '}';
+                }
+
+                output << '}';
+                first = false;
+            }
+        }
+
+        output << "\n]}\n";
+    }
+private:
+    // Only written by its thread, so recording needs no atomics
+    struct ThreadBuffer
+    {
+        std::thread::id Thread;
+        uint32_t ThreadId = 0;
+        std::vector<TraceEvent> Events;
+        uint64_t NextEvent = 0;
+    };
+
+    ThreadBuffer &GetThreadBuffer()
+    {
+        // The buffer last used by this thread is cached, and looked up again for another recorder
+        struct Cache
+        {
+            uint64_t RecorderId = 0;
+            ThreadBuffer *Buffer = nullptr;
+        };
+
+        thread_local Cache cache;
+        if (cache.RecorderId == Id)
+            return *cache.Buffer;
+
+        const auto thread = std::this_thread::get_id();
+        const std::lock_guard lock(BuffersMutex);
+
+        const auto it = std::find_if(Buffers.begin(), Buffers.end(), [&](const auto &buffer)
+        {
+            return buffer->Thread == thread;
+        });
+
+        auto buffer = it != Buffers.end() ? it->get() : nullptr;
+        if (buffer == nullptr)
+        {
+            buffer = Buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+            buffer->Thread = thread;
+
+            // Small sequential IDs keep the viewer's thread list readable
+            buffer->ThreadId = static_cast<uint32_t>(Buffers.size());
+        }
+
+        cache = { Id, buffer };
+        return *buffer;
+    }
+
+    static uint64_t GetNextId()
+    {
+        static std::atomic<uint64_t> nextId = 1;
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void WriteJsonString(std::ostream &output, const std::string_view value)
+    {
+        output << '"';
+
+        for (const auto c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                output << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                output << escaped;
+            }
+            else
+            {
+                output << c;
+            }
+        }
+
+        output << '"';
+    }
+
+    // Identifies the recorder in the threads' caches, unlike its address which may be reused
+    const uint64_t Id = GetNextId();
+    Clock::time_point Start = Clock::now();
+    size_t Capacity;
+    std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+    std::mutex BuffersMutex;
+};
+
+// Records a span from construction to destruction
+class TraceScope
+{
+public:
+    TraceScope(TraceRecorder &recorder, char const *name, char const *detail = nullptr)
+        : Recorder(recorder), Name(name), Detail(detail), Begin(recorder.IsEnabled() ? recorder.Now() : 0)
+    {
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    ~TraceScope()
+    {
+        if (Recorder.IsEnabled())
+            Recorder.Record(Name, Detail, Begin, Recorder.Now());
+    }
+private:
+    TraceRecorder &Recorder;
+    char const *Name;
+    char const *Detail;
+    uint64_t Begin;
+};
+
+// Records consecutive spans that share their boundaries, such as the steps of processing one type
+class TracePhases
+{
+public:
+    TracePhases(TraceRecorder &recorder, char const *detail)
+        : Recorder(recorder), Detail(detail), PhaseBegin(recorder.IsEnabled() ? recorder.Now() : 0)
+    {
+    }
+
+    // Ends the current phase under the given name and begins the next one
+    void EndPhase(char const *name)
+    {
+        if (!Recorder.IsEnabled())
+            return;
+
+        const auto now = Recorder.Now();
+        Recorder.Record(name, Detail, PhaseBegin, now);
+        PhaseBegin = now;
+    }
+private:
+    TraceRecorder &Recorder;
+    char const *Detail;
+    uint64_t PhaseBegin;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+
+//
+// Virtual function slot discovery.
+// Rather than hardcoding vtable indices for every revision, a virtual call is dispatched through a fake
+// object whose vtable consists of probes that record their own index. The result is therefore always
+// the slot the compiler uses for the declared class layout, which is the same one used to call into the engine.
+//
+
+namespace vtable_details
+{
+    inline constexpr size_t kMaxProbedSlots = 256;
+
+    inline thread_local size_t ProbedSlot;
+
+    template<size_t I>
+    void RecordSlot()
+    {
+        // The probe is called with the arguments of the probed function, which are ignored.
+        // Both supported calling conventions leave argument cleanup to the caller.
+        ProbedSlot = I;
+    }
+
+    template<size_t... I>
+    consteval auto MakeProbeTable(std::index_sequence<I...>)
+    {
+        return std::array<void (*)(), sizeof...(I)>{ &RecordSlot<I>... };
+    }
+
+    inline constexpr auto kProbeTable = MakeProbeTable(std::make_index_sequence<kMaxProbedSlots>{});
+}
+
+// Returns the vtable index invoked by `call`, which must perform exactly one virtual call on the object it is given.
+template<typename T, typename TCall>
+size_t GetVirtualFunctionSlot(TCall &&call)
+{
+    struct
+    {
+        void (*const *vtable)();
+    } probe{ vtable_details::kProbeTable.data() };
+
+    // Prevent the compiler from reasoning about the dynamic type of the probe
+    T *volatile object = reinterpret_cast<T *>(&probe);
+
+    vtable_details::ProbedSlot = vtable_details::kMaxProbedSlots;
+    call(object);
+    return vtable_details::ProbedSlot;
+}
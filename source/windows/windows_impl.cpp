@@ -1,13 +1,19 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <Psapi.h>
 #include <detours/detours.h>
 #include <wil/win32_helpers.h>
 #include <wil/win32_result_macros.h>
 #include "common.hpp"
 #include "dumper.hpp"
+#include "scripting.hpp"
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #pragma comment(lib, "Version.lib")
+#pragma comment(lib, "Psapi.lib")
 #undef WIN32_LEAN_AND_MEAN
 
 namespace
@@ -27,6 +33,162 @@ namespace
 
         FAIL_FAST_WIN32(ERROR_NOT_FOUND);
     }
+
+    // The subset of the Mono embedding API needed to enumerate and instantiate scripting classes
+    struct MonoApi
+    {
+        using MonoDomain = void;
+        using MonoAssembly = void;
+        using MonoImage = void;
+        using MonoClass = void;
+        using MonoObject = void;
+
+        MonoDomain *(*mono_get_root_domain)();
+        void *(*mono_thread_attach)(MonoDomain *);
+        void (*mono_assembly_foreach)(void (*)(void *, void *), void *);
+        MonoImage *(*mono_assembly_get_image)(MonoAssembly *);
+        char const *(*mono_image_get_name)(MonoImage *);
+        int32_t (*mono_image_get_table_rows)(MonoImage *, int32_t);
+        MonoClass *(*mono_class_get)(MonoImage *, uint32_t);
+        MonoClass *(*mono_class_from_name)(MonoImage *, char const *, char const *);
+        int32_t (*mono_class_is_subclass_of)(MonoClass *, MonoClass *, int32_t);
+        char const *(*mono_class_get_name)(MonoClass *);
+        char const *(*mono_class_get_namespace)(MonoClass *);
+        uint32_t (*mono_class_get_flags)(MonoClass *);
+        int32_t (*mono_class_instance_size)(MonoClass *);
+        MonoObject *(*mono_object_new)(MonoDomain *, MonoClass *);
+        uint32_t (*mono_gchandle_new)(MonoObject *, int32_t);
+
+        static constexpr int32_t kTableTypeDef = 2;
+        static constexpr uint32_t kTokenTypeDef = 0x02000000;
+        static constexpr uint32_t kTypeAttributeAbstract = 0x80;
+
+        static std::optional<MonoApi> Load()
+        {
+            HMODULE hModule = nullptr;
+            for (const auto module : { L"mono-2.0-bdwgc.dll", L"mono.dll" })
+            {
+                hModule = GetModuleHandleW(module);
+                if (hModule != nullptr)
+                    break;
+            }
+
+            if (hModule == nullptr)
+                return std::nullopt;
+
+            MonoApi api{};
+            bool resolved = true;
+
+            const auto resolve = [&]<typename T>(T &function, char const *name)
+            {
+                function = reinterpret_cast<T>(GetProcAddress(hModule, name));
+                resolved = resolved && function != nullptr;
+            };
+
+            resolve(api.mono_get_root_domain, "mono_get_root_domain");
+            resolve(api.mono_thread_attach, "mono_thread_attach");
+            resolve(api.mono_assembly_foreach, "mono_assembly_foreach");
+            resolve(api.mono_assembly_get_image, "mono_assembly_get_image");
+            resolve(api.mono_image_get_name, "mono_image_get_name");
+            resolve(api.mono_image_get_table_rows, "mono_image_get_table_rows");
+            resolve(api.mono_class_get, "mono_class_get");
+            resolve(api.mono_class_from_name, "mono_class_from_name");
+            resolve(api.mono_class_is_subclass_of, "mono_class_is_subclass_of");
+            resolve(api.mono_class_get_name, "mono_class_get_name");
+            resolve(api.mono_class_get_namespace, "mono_class_get_namespace");
+            resolve(api.mono_class_get_flags, "mono_class_get_flags");
+            resolve(api.mono_class_instance_size, "mono_class_instance_size");
+            resolve(api.mono_object_new, "mono_object_new");
+            resolve(api.mono_gchandle_new, "mono_gchandle_new");
+
+            if (!resolved)
+                return std::nullopt;
+
+            return api;
+        }
+    };
+
+    // Enumerates the concrete, non-generic MonoBehaviour and ScriptableObject subclasses of all loaded
+    // assemblies and creates a pinned instance of each. Constructors are not run, as field values do not
+    // affect the type trees.
+    std::vector<ScriptingClass> GetMonoScriptingClasses()
+    {
+        const auto api = MonoApi::Load();
+        if (!api.has_value())
+            return {};
+
+        const auto domain = api->mono_get_root_domain();
+        api->mono_thread_attach(domain);
+
+        struct AssemblyEnumeration
+        {
+            const MonoApi *Api;
+            std::vector<MonoApi::MonoImage *> Images;
+        } enumeration{ &api.value() };
+
+        api->mono_assembly_foreach([](void *assembly, void *userData)
+        {
+            const auto enumeration = static_cast<AssemblyEnumeration *>(userData);
+            enumeration->Images.push_back(enumeration->Api->mono_assembly_get_image(assembly));
+        }, &enumeration);
+
+        const auto &images = enumeration.Images;
+
+        std::vector<MonoApi::MonoClass *> baseClasses;
+        for (const auto image : images)
+        {
+            for (const auto name : { "MonoBehaviour", "ScriptableObject" })
+            {
+                if (const auto klass = api->mono_class_from_name(image, "UnityEngine", name))
+                    baseClasses.push_back(klass);
+            }
+        }
+
+        std::vector<ScriptingClass> result;
+        constexpr auto kObjectHeaderSize = static_cast<int32_t>(2 * sizeof(void *));
+
+        for (const auto image : images)
+        {
+            const auto typeCount = api->mono_image_get_table_rows(image, MonoApi::kTableTypeDef);
+
+            for (int32_t i = 0; i < typeCount; i++)
+            {
+                const auto klass = api->mono_class_get(image, MonoApi::kTokenTypeDef | static_cast<uint32_t>(i + 1));
+                if (klass == nullptr || (api->mono_class_get_flags(klass) & MonoApi::kTypeAttributeAbstract) != 0)
+                    continue;
+
+                // Generic type definitions carry their arity after a backtick and cannot be instantiated
+                const auto className = std::string_view(api->mono_class_get_name(klass));
+                if (className.find('`') != std::string_view::npos)
+                    continue;
+
+                const auto isScript = std::ranges::any_of(baseClasses, [&](MonoApi::MonoClass *baseClass)
+                {
+                    return klass != baseClass && api->mono_class_is_subclass_of(klass, baseClass, false);
+                });
+
+                if (!isScript)
+                    continue;
+
+                const auto instance = api->mono_object_new(domain, klass);
+                if (instance == nullptr)
+                    continue;
+
+                api->mono_gchandle_new(instance, true);
+
+                result.push_back({
+                    .AssemblyName = api->mono_image_get_name(image),
+                    .Namespace = api->mono_class_get_namespace(klass),
+                    .ClassName = std::string(className),
+                    .Instance = instance,
+                    .InstanceData = static_cast<char *>(instance) + kObjectHeaderSize,
+                    .InstanceDataSize = api->mono_class_instance_size(klass) - kObjectHeaderSize,
+                });
+            }
+        }
+
+        return result;
+    }
 }
 
 template<Revision R, Variant V>
@@ -67,11 +229,11 @@ public:
         return CachedSections;
     }
 
-    static std::ofstream CreateOutputFile(char const *filename)
+    static OutputFile CreateOutputFile(char const *filename)
     {
         // Create the output file in the current directory.
         // NOTE: Should this be made configurable? i.e. through an environment variable?
-        return std::ofstream(std::filesystem::current_path() / filename, std::ios::out | std::ios::binary);
+        return OutputFile(std::filesystem::current_path() / filename);
     }
 
     static void DebugLog(char const *message)
@@ -79,6 +241,20 @@ public:
         OutputDebugStringA(message);
         OutputDebugStringA("\n");
     }
+
+    static uint64_t GetResidentSetSize()
+    {
+        PROCESS_MEMORY_COUNTERS counters{ .cb = sizeof(PROCESS_MEMORY_COUNTERS) };
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+
+        return counters.WorkingSetSize;
+    }
+
+    static std::vector<ScriptingClass> GetScriptingClasses()
+    {
+        return GetMonoScriptingClasses();
+    }
 private:
     std::vector<ExecutableSection> CachedSections;
 };
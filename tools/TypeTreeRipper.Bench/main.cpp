@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <regex>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common.hpp"
+#include "binary_output.hpp"
+#include "mock_platform.hpp"
+
+//
+// Benchmarks for the dumper's hot paths, run against the mock engine.
+// Every result is a throughput (higher is better), so that results can be compared against a
+// baseline with a single relative threshold.
+//
+
+namespace
+{
+    constexpr auto kRevision = Revision::V2022_3_0;
+    constexpr auto kVariant = Variant::Editor;
+
+    using Engine = MockEngine<kRevision, kVariant>;
+    using BenchDumper = Dumper<kRevision, kVariant, MockPlatformImpl<kRevision, kVariant>>;
+    using Writer = DumpedTypeTreeWriter<kRevision, kVariant>;
+    using RTTI = ::RTTI<kRevision, kVariant>;
+    using RuntimeTypeArray = ::RuntimeTypeArray<kRevision, kVariant>;
+    using MemLabelId = ::MemLabelId<kRevision, kVariant>;
+    using TypeTree = ::TypeTree<kRevision, kVariant>;
+    using TypeTreeShareableData = ::TypeTreeShareableData<kRevision, kVariant>;
+    using TransferInstructionFlags = ::TransferInstructionFlags<kRevision, kVariant>;
+    using GenerateTypeTreeTransfer = ::GenerateTypeTreeTransfer<kRevision, kVariant>;
+    using Object = ::Object<kRevision, kVariant>;
+
+    constexpr size_t kMegabyte = 1024 * 1024;
+
+    // Results of unoptimized builds say nothing about release performance, and the baseline is recorded from a
+    // release build
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && !defined(__clang__) && defined(NDEBUG))
+    constexpr auto kOptimizedBuild = true;
+#else
+    constexpr auto kOptimizedBuild = false;
+#endif
+
+    struct BenchmarkResult
+    {
+        std::string Name;
+        double Value;
+        std::string Unit;
+    };
+
+    struct BenchOptions
+    {
+        std::filesystem::path OutputPath;
+        std::filesystem::path BaselinePath = TYPETREERIPPER_BENCH_BASELINE;
+        double Threshold = 0.25;
+        size_t MaxImageSize = 1024 * kMegabyte;
+        double MinimumTime = 0.5;
+        bool WriteBaseline = false;
+        bool AllowUnoptimized = false;
+    };
+
+    // Runs a benchmark until it has taken at least the minimum time, and returns the fastest run in seconds
+    double MeasureBestSeconds(const BenchOptions &options, const std::function<void()> &run)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto best = std::numeric_limits<double>::max();
+        double total = 0;
+
+        do
+        {
+            const auto begin = Clock::now();
+            run();
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+            best = std::min(best, elapsed);
+            total += elapsed;
+        } while (total < options.MinimumTime);
+
+        return best;
+    }
+
+    std::string FormatSize(const size_t bytes)
+    {
+        return bytes >= 1024 * kMegabyte ? std::to_string(bytes / (1024 * kMegabyte)) + "GB" : std::to_string(bytes / kMegabyte) + "MB";
+    }
+
+    // Generates one tree of a shape, using the mock engine's transfer like the dumper does
+    template<typename TConsumer>
+    void GenerateTree(Engine &engine, const uint32_t typeIndex, const TransferInstructionFlags flags, TConsumer &&consumer)
+    {
+        const auto pArray = static_cast<RuntimeTypeArray const *>(engine.GetRuntimeTypeArray());
+        const auto pRTTI = pArray->Types[typeIndex];
+
+        MemLabelId label;
+        TypeTreeShareableData data(label);
+        TypeTree tree(&data, label);
+
+        Object *object = pRTTI->factory(label, kCreateObjectDefault);
+        GenerateTypeTreeTransfer transfer(tree, flags, object, pRTTI->size);
+        object->VirtualRedirectTransfer(transfer);
+
+        consumer(pRTTI, tree);
+    }
+
+    void BenchmarkScans(const BenchOptions &options, std::vector<BenchmarkResult> &results)
+    {
+        const auto registry = MockRegistry::CreateSynthetic({ .TypeCount = 300, .ShapeCount = 16, .NodesPerTree = 8 });
+
+        for (const auto imageSize : { 10 * kMegabyte, 100 * kMegabyte, 1024 * kMegabyte })
+        {
+            if (imageSize > options.MaxImageSize)
+                continue;
+
+            for (const auto percentage : { 10, 50, 90 })
+            {
+                const auto offset = imageSize / 100 * percentage;
+
+                Engine engine(registry, {
+                    .ReadOnlySectionSize = imageSize,
+                    .WritableSectionSize = imageSize,
+                    .CommonStringBufferOffset = offset,
+                    .TypeArrayOffset = offset,
+                });
+
+                engine.MakeCurrent();
+                BenchDumper dumper;
+                const auto suffix = "/" + FormatSize(imageSize) + "@" + std::to_string(percentage) + "%";
+
+                const auto arraySeconds = MeasureBestSeconds(options, [&]
+                {
+                    if (dumper.GetRuntimeTypeArray() == nullptr)
+                        throw std::runtime_error("RuntimeTypeArray was not found");
+                });
+
+                results.push_back({ "scan/runtime-type-array" + suffix, offset / arraySeconds / kMegabyte, "MB/s" });
+
+                const auto stringSeconds = MeasureBestSeconds(options, [&]
+                {
+                    if (dumper.GetCommonStringBuffer() == nullptr)
+                        throw std::runtime_error("Common string buffer was not found");
+                });
+
+                results.push_back({ "scan/common-string-buffer" + suffix, offset / stringSeconds / kMegabyte, "MB/s" });
+            }
+        }
+    }
+
+    void BenchmarkConvert(const BenchOptions &options, std::vector<BenchmarkResult> &results)
+    {
+        for (const auto nodeCount : { 100u, 10000u })
+        {
+            Engine engine(MockRegistry::CreateSynthetic({ .TypeCount = 3, .ShapeCount = 1, .NodesPerTree = nodeCount }));
+
+            size_t convertedNodes = 0;
+            double seconds = 0;
+
+            GenerateTree(engine, 2, TransferInstructionFlags::kSerializeGameRelease, [&](RTTI const *pRTTI, const TypeTree &tree)
+            {
+                constexpr auto kTreesPerRun = 64;
+
+                seconds = MeasureBestSeconds(options, [&]
+                {
+                    Writer writer;
+                    writer.SetDeduplicateTrees(false);
+
+                    for (int i = 0; i < kTreesPerRun; i++)
+                        writer.Add(pRTTI, tree, TransferInstructionFlags::kSerializeGameRelease, engine.GetCommonStringBuffer());
+                });
+
+                convertedNodes = tree.Nodes().size() * kTreesPerRun;
+            });
+
+            results.push_back({ "convert/nodes-per-tree-" + std::to_string(nodeCount), convertedNodes / seconds, "nodes/s" });
+        }
+    }
+
+    void BenchmarkWrite(const BenchOptions &options, std::vector<BenchmarkResult> &results)
+    {
+        Engine engine(MockRegistry::CreateSynthetic({ .TypeCount = 1000, .ShapeCount = 128, .NodesPerTree = 100 }));
+        const auto &registry = engine.GetRegistry();
+
+        Writer writer;
+        size_t nodeCount = 0;
+
+        for (uint32_t i = 0; i < registry.Types.size(); i++)
+        {
+            if (registry.Types[i].IsAbstract)
+                continue;
+
+            GenerateTree(engine, i, TransferInstructionFlags::kSerializeGameRelease, [&](RTTI const *pRTTI, const TypeTree &tree)
+            {
+                writer.Add(pRTTI, tree, TransferInstructionFlags::kSerializeGameRelease, engine.GetCommonStringBuffer());
+                nodeCount += tree.Nodes().size();
+            });
+        }
+
+        const auto path = std::filesystem::temp_directory_path() / "TypeTreeRipperBench.ttbin";
+
+        const auto seconds = MeasureBestSeconds(options, [&]
+        {
+            OutputBuffer buffer;
+            writer.Write(buffer);
+            OutputFile(path).Write(buffer);
+        });
+
+        std::filesystem::remove(path);
+
+        // Counted in nodes rather than bytes, as the size of the output changes with the file format
+        results.push_back({ "write/1000-types", nodeCount / seconds, "nodes/s" });
+    }
+
+    void BenchmarkRun(const BenchOptions &options, std::vector<BenchmarkResult> &results)
+    {
+        const auto outputDirectory = std::filesystem::temp_directory_path() / "TypeTreeRipperBench";
+        std::filesystem::create_directories(outputDirectory);
+
+        for (const auto &[typeCount, nodeCount] : { std::pair(300u, 40u), std::pair(1000u, 100u) })
+        {
+            Engine engine(MockRegistry::CreateSynthetic({ .TypeCount = typeCount, .NodesPerTree = nodeCount }), {
+                .WritableSectionSize = 10 * kMegabyte,
+                .TypeArrayOffset = 5 * kMegabyte,
+                .OutputDirectory = outputDirectory,
+            });
+
+            const auto seconds = MeasureBestSeconds(options, [&]
+            {
+                RunMockDumper(engine);
+            });
+
+            // An editor run dumps every type twice
+            results.push_back({ "run/" + std::to_string(typeCount) + "-types-" + std::to_string(nodeCount) + "-nodes", 2 * typeCount / seconds, "types/s" });
+        }
+
+        std::filesystem::remove_all(outputDirectory);
+    }
+
+    void WriteResults(std::ostream &output, const std::vector<BenchmarkResult> &results)
+    {
+        output << "{\n  \"benchmarks\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            char value[64];
+            std::snprintf(value, sizeof(value), "%.1f", results[i].Value);
+
+            output << "    { \"name\": \"" << results[i].Name << "\", \"value\": " << value << ", \"unit\": \"" << results[i].Unit << "\" }"
+                << (i + 1 != results.size() ? ",\n" : "\n");
+        }
+
+        output << "  ]\n}\n";
+    }
+
+    // Reads the name and value of every result from a file written by WriteResults
+    std::vector<BenchmarkResult> ReadResults(const std::filesystem::path &path)
+    {
+        std::ifstream input(path);
+        if (!input)
+            throw std::runtime_error("Failed to open " + path.string());
+
+        std::stringstream contents;
+        contents << input.rdbuf();
+        const auto text = contents.str();
+
+        static const std::regex kResultPattern(R"re(\{\s*"name":\s*"([^"]*)",\s*"value":\s*([0-9.eE+-]+),\s*"unit":\s*"([^"]*)"\s*\})re");
+
+        std::vector<BenchmarkResult> results;
+        for (auto it = std::sregex_iterator(text.begin(), text.end(), kResultPattern); it != std::sregex_iterator(); ++it)
+            results.push_back({ (*it)[1].str(), std::stod((*it)[2].str()), (*it)[3].str() });
+
+        return results;
+    }
+
+    // Prints every result next to its baseline and returns the number of regressions beyond the threshold
+    size_t CompareResults(const BenchOptions &options, const std::vector<BenchmarkResult> &results, const std::vector<BenchmarkResult> &baseline)
+    {
+        size_t regressions = 0;
+
+        std::printf("%-40s %20s %20s %9s\n", "benchmark", "result", "baseline", "change");
+
+        for (const auto &result : results)
+        {
+            const auto expected = std::ranges::find(baseline, result.Name, &BenchmarkResult::Name);
+            if (expected == baseline.end())
+            {
+                std::printf("%-40s %12.1f %-7s %20s\n", result.Name.c_str(), result.Value, result.Unit.c_str(), "-");
+                continue;
+            }
+
+            const auto change = result.Value / expected->Value - 1;
+            const auto regressed = change < -options.Threshold;
+            regressions += regressed ? 1 : 0;
+
+            std::printf("%-40s %12.1f %-7s %12.1f %-7s %+8.1f%%%s\n", result.Name.c_str(), result.Value, result.Unit.c_str(),
+                expected->Value, expected->Unit.c_str(), change * 100, regressed ? "  REGRESSION" : "");
+        }
+
+        return regressions;
+    }
+
+    BenchOptions ParseOptions(const std::span<char const *const> arguments)
+    {
+        BenchOptions options;
+
+        const auto parseDouble = [](const std::string_view name, const std::string_view value)
+        {
+            double result;
+            if (std::from_chars(value.data(), value.data() + value.size(), result).ec != std::errc{})
+                throw std::runtime_error("Invalid value for " + std::string(name) + ": " + std::string(value));
+
+            return result;
+        };
+
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            const auto name = std::string_view(arguments[i]);
+
+            if (name == "--write-baseline")
+            {
+                options.WriteBaseline = true;
+                continue;
+            }
+
+            if (name == "--allow-unoptimized")
+            {
+                options.AllowUnoptimized = true;
+                continue;
+            }
+
+            if (i + 1 == arguments.size())
+                throw std::runtime_error("Missing value for " + std::string(name));
+
+            const auto value = std::string_view(arguments[++i]);
+
+            if (name == "--output")
+                options.OutputPath = value;
+            else if (name == "--baseline")
+                options.BaselinePath = value;
+            else if (name == "--threshold")
+                options.Threshold = parseDouble(name, value);
+            else if (name == "--max-image-size")
+                options.MaxImageSize = static_cast<size_t>(parseDouble(name, value) * kMegabyte);
+            else if (name == "--min-time")
+                options.MinimumTime = parseDouble(name, value);
+            else
+                throw std::runtime_error("Unknown option " + std::string(name));
+        }
+
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        const auto options = ParseOptions(std::span<char const *const>(argv + 1, argc - 1));
+
+        if (!kOptimizedBuild)
+        {
+            if (!options.AllowUnoptimized || options.WriteBaseline)
+                throw std::runtime_error("TypeTreeRipperBench was built without optimization, configure the build with -DCMAKE_BUILD_TYPE=Release");
+
+            std::fputs("warning: TypeTreeRipperBench was built without optimization, the results are not comparable to the baseline\n", stderr);
+        }
+
+        std::vector<BenchmarkResult> results;
+        BenchmarkScans(options, results);
+        BenchmarkConvert(options, results);
+        BenchmarkWrite(options, results);
+        BenchmarkRun(options, results);
+
+        if (!options.OutputPath.empty())
+        {
+            std::ofstream output(options.OutputPath);
+            WriteResults(output, results);
+        }
+
+        if (options.WriteBaseline)
+        {
+            std::ofstream output(options.BaselinePath);
+            WriteResults(output, results);
+            std::printf("Wrote baseline to %s\n", options.BaselinePath.string().c_str());
+            return 0;
+        }
+
+        // Unoptimized results are only printed, as they would fail against any baseline
+        const auto regressions = CompareResults(options, results, ReadResults(options.BaselinePath));
+        if (regressions != 0 && kOptimizedBuild)
+        {
+            std::printf("%zu benchmarks regressed by more than %.0f%%\n", regressions, options.Threshold * 100);
+            return 1;
+        }
+
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        std::fputs("Usage: TypeTreeRipperBench [--output <results.json>] [--baseline <baseline.json>] [--threshold <fraction>]\n"
+            "                           [--max-image-size <megabytes>] [--min-time <seconds>] [--write-baseline]\n"
+            "                           [--allow-unoptimized]\n", stderr);
+        return 1;
+    }
+}
@@ -0,0 +1,68 @@
+namespace TypeTreeRipper.BinaryFormat;
+
+/// <summary>
+/// The class hierarchy of the types in the file, in preorder so that every type is followed by all of its descendants.
+/// Derivation checks and descendant lookups are range checks on the table indices.
+/// </summary>
+public class DumpedTypeHierarchy
+{
+	public const uint NoBase = uint.MaxValue;
+
+	public readonly record struct Entry(int PersistentTypeId, uint BaseIndex, uint DescendantCount, uint Depth);
+
+	public IReadOnlyList<Entry> Types { get; }
+
+	private readonly Dictionary<int, int> _indices = new();
+
+	public DumpedTypeHierarchy(BinaryReader reader)
+	{
+		var count = reader.ReadUInt32();
+		var types = new List<Entry>(checked((int)count));
+		for (int i = 0; i < count; i++)
+		{
+			types.Add(new Entry(reader.ReadInt32(), reader.ReadUInt32(), reader.ReadUInt32(), reader.ReadUInt32()));
+		}
+
+		Types = types;
+
+		// Every type has to be followed by exactly its descendants for the range checks to hold
+		var bases = new Stack<int>();
+		for (int i = 0; i < types.Count; i++)
+		{
+			while (bases.Count > 0 && i - bases.Peek() > types[bases.Peek()].DescendantCount)
+				bases.Pop();
+
+			var baseIndex = bases.Count > 0 ? (uint)bases.Peek() : NoBase;
+			var end = bases.Count > 0 ? bases.Peek() + types[bases.Peek()].DescendantCount + 1 : (uint)types.Count;
+			var type = types[i];
+
+			if (type.BaseIndex != baseIndex || type.DescendantCount >= end - i || type.Depth != bases.Count)
+			{
+				throw new InvalidDataException($"Invalid type hierarchy entry: {i}");
+			}
+
+			bases.Push(i);
+			_indices.TryAdd(type.PersistentTypeId, i);
+		}
+	}
+
+	/// <summary>
+	/// The table index of a type, or <see langword="null"/> if the type is not in the file.
+	/// </summary>
+	public int? GetIndex(int persistentTypeId) => _indices.TryGetValue(persistentTypeId, out var index) ? index : null;
+
+	/// <summary>
+	/// Whether the type at <paramref name="index"/> derives from the one at <paramref name="baseIndex"/>, counting a type as derived from itself.
+	/// </summary>
+	public bool IsDerivedFrom(int index, int baseIndex) => index >= baseIndex && index - baseIndex <= Types[baseIndex].DescendantCount;
+
+	/// <summary>
+	/// The table indices of all types deriving from the type at <paramref name="index"/>.
+	/// </summary>
+	public Range GetDescendants(int index) => new(index + 1, index + 1 + (int)Types[index].DescendantCount);
+
+	/// <summary>
+	/// The table index of the base of the type at <paramref name="index"/>, or <see langword="null"/> for roots.
+	/// </summary>
+	public int? GetBaseIndex(int index) => Types[index].BaseIndex != NoBase ? (int)Types[index].BaseIndex : null;
+}
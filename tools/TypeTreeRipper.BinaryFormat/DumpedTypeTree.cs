@@ -4,30 +4,118 @@ public class DumpedTypeTree
 {
 	public DumpedTypeTreeRTTI RTTI { get; }
 	public TransferInstructionFlags TransferFlags { get; }
-	public List<DumpedTypeTreeNode> Nodes { get; }
+	private List<DumpedTypeTreeNode>? _nodes;
+	private DumpedTypeTree? _referencedTree;
+
+	/// <summary>
+	/// The nodes of the tree, which are expanded from <see cref="CompactNodes"/> on first use.
+	/// </summary>
+	public List<DumpedTypeTreeNode> Nodes => _nodes ??= _referencedTree?.Nodes ?? CompactNodes?.GetExpandedNodes() ?? [];
+
+	/// <summary>
+	/// The nodes with the shared subtrees left as references, or <see langword="null"/> if the file has no shared subtrees
+	/// or the nodes are stored with the referenced tree.
+	/// </summary>
+	public DumpedTypeTreeSubtree? CompactNodes { get; }
+
+	/// <summary>
+	/// The index of an earlier tree with identical nodes, or <see langword="null"/> if the nodes were stored with this tree.
+	/// </summary>
+	public int? ReferencedTree { get; }
+
+	/// <summary>
+	/// Unity's legacy 16-byte type hash of the nodes, or <see langword="null"/> if the file does not say.
+	/// </summary>
+	public byte[]? OldTypeHash { get; }
+
+	/// <summary>
+	/// A stable 64-bit hash of every field of the nodes, or <see langword="null"/> if the file does not say.
+	/// </summary>
+	public ulong? TypeHash { get; }
 
 	public bool IsReleaseTree => TransferFlags.HasFlag(TransferInstructionFlags.SerializeGameRelease);
 
-	public DumpedTypeTree(BinaryReader reader)
+	public DumpedTypeTree(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		IReadOnlyList<DumpedTypeTreeSubtree>? subtrees = null)
+		: this(reader, headerFlags, stringTable, new DumpedTypeTreeRTTI(reader), (TransferInstructionFlags)reader.ReadUInt64(), subtrees)
+	{
+	}
+
+	/// <summary>
+	/// Reads a tree of a tree set, whose RTTI comes from the file's RTTI table and whose transfer flags are those of the set.
+	/// </summary>
+	public DumpedTypeTree(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		IReadOnlyList<DumpedTypeTreeRTTI> rttiTable, TransferInstructionFlags transferFlags, IReadOnlyList<DumpedTypeTreeSubtree>? subtrees = null)
+		: this(reader, headerFlags, stringTable, ReadRTTIIndex(reader, rttiTable), transferFlags, subtrees)
 	{
-		RTTI = new DumpedTypeTreeRTTI(reader);
-		TransferFlags = (TransferInstructionFlags)reader.ReadUInt64();
+	}
+
+	private DumpedTypeTree(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		DumpedTypeTreeRTTI rtti, TransferInstructionFlags transferFlags, IReadOnlyList<DumpedTypeTreeSubtree>? subtrees)
+	{
+		RTTI = rtti;
+		TransferFlags = transferFlags;
+
+		if (headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.TypeHashes))
+		{
+			OldTypeHash = reader.ReadBytes(16);
+			if (OldTypeHash.Length != 16)
+			{
+				throw new EndOfStreamException();
+			}
+
+			TypeHash = reader.ReadUInt64();
+		}
+
+		if (headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.TreeReferences))
+		{
+			var referencedTree = reader.ReadUInt32();
+			if (referencedTree != uint.MaxValue)
+			{
+				ReferencedTree = checked((int)referencedTree);
+				return;
+			}
+		}
+
+		if (headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.SubtreeReferences))
+		{
+			CompactNodes = new DumpedTypeTreeSubtree(reader, headerFlags, stringTable, subtrees ?? []);
+			return;
+		}
 
 		var count = reader.ReadUInt32();
-		Nodes = new List<DumpedTypeTreeNode>(checked((int)count));
+		_nodes = new List<DumpedTypeTreeNode>(checked((int)count));
 		for (int i = 0; i < count; i++)
 		{
-			Nodes.Add(new DumpedTypeTreeNode(reader));
+			_nodes.Add(new DumpedTypeTreeNode(reader, headerFlags, stringTable));
 		}
 	}
 
+	private static DumpedTypeTreeRTTI ReadRTTIIndex(BinaryReader reader, IReadOnlyList<DumpedTypeTreeRTTI> rttiTable)
+	{
+		var index = reader.ReadUInt32();
+		if (index >= rttiTable.Count)
+		{
+			throw new InvalidDataException($"Invalid RTTI index: {index}");
+		}
+
+		return rttiTable[(int)index];
+	}
+
+	internal void ResolveReference(DumpedTypeTree referencedTree)
+	{
+		_referencedTree = referencedTree;
+		_nodes = null;
+	}
+
 	public int GetValueHash()
 	{
 		var hashCode = new HashCode();
 
 		hashCode.Add(RTTI.GetValueHash());
 		hashCode.Add(TransferFlags);
-		
+
+		// Only the node fields are hashed, so that the hash does not depend on the optional columns of the file
 		foreach (var node in Nodes)
 		{
 			hashCode.Add(node.GetValueHash());
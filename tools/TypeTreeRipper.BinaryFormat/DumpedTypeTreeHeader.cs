@@ -1,13 +1,33 @@
 namespace TypeTreeRipper.BinaryFormat;
 
-public class DumpedTypeTreeHeader(BinaryReader reader)
+public class DumpedTypeTreeHeader
 {
-	public ulong Magic { get; } = reader.ReadUInt64();
-	public uint Version { get; } = reader.ReadUInt32();
+	public ulong Magic { get; }
+	public uint Version { get; }
 
-	public ushort MajorRevision { get; } = reader.ReadUInt16();
-	public byte MinorRevision { get; } = reader.ReadByte();
-	public byte PatchRevision { get; } = reader.ReadByte();
+	public ushort MajorRevision { get; }
+	public byte MinorRevision { get; }
+	public byte PatchRevision { get; }
 
-	public string Variant { get; } = reader.ReadLengthPrefixedString();
+	public string Variant { get; }
+
+	public DumpedTypeTreeHeaderFlags Flags { get; }
+
+	public DumpedTypeTreeHeader(BinaryReader reader)
+	{
+		Magic = reader.ReadUInt64();
+		Version = reader.ReadUInt32();
+
+		MajorRevision = reader.ReadUInt16();
+		MinorRevision = reader.ReadByte();
+		PatchRevision = reader.ReadByte();
+
+		Variant = reader.ReadLengthPrefixedString();
+
+		// Header flags were added in version 2
+		if (Version >= 2)
+		{
+			Flags = (DumpedTypeTreeHeaderFlags)reader.ReadUInt32();
+		}
+	}
 }
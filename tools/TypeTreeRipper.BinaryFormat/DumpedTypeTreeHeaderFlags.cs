@@ -0,0 +1,17 @@
+namespace TypeTreeRipper.BinaryFormat;
+
+[Flags]
+public enum DumpedTypeTreeHeaderFlags : uint
+{
+	None = 0,
+	TreeReferences = 1 << 0,
+	StringTable = 1 << 1,
+	CommonStrings = 1 << 2,
+	ByteOffsets = 1 << 3,
+	Navigation = 1 << 4,
+	SubtreeHashes = 1 << 5,
+	TypeHashes = 1 << 6,
+	SubtreeReferences = 1 << 7,
+	TreeSets = 1 << 8,
+	Checksums = 1 << 9
+}
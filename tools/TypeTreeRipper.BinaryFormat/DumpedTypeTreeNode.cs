@@ -1,19 +1,159 @@
 namespace TypeTreeRipper.BinaryFormat;
 
-public class DumpedTypeTreeNode(BinaryReader reader)
+public class DumpedTypeTreeNode
 {
-	public string Type { get; } = reader.ReadLengthPrefixedString();
-	public string Name { get; } = reader.ReadLengthPrefixedString();
+	public string Type { get; }
+	public string Name { get; }
 
-	public DumpedTypeTreeNodeFlags Flags { get; } = (DumpedTypeTreeNodeFlags)reader.ReadUInt32();
-	public int ByteSize { get; } = reader.ReadInt32();
-	public int Index { get; } = reader.ReadInt32();
+	public DumpedTypeTreeNodeFlags Flags { get; }
+	public int ByteSize { get; }
+	public int Index { get; }
 
-	public short Version { get; } = reader.ReadInt16();
-	public byte Level { get; } = reader.ReadByte();
+	public short Version { get; }
+	public byte Level { get; }
 
-	public DumpedTypeTreeNodeMetaFlags MetaFlags { get; } = (DumpedTypeTreeNodeMetaFlags)reader.ReadUInt32();
-	public ulong RefTypeHash { get; } = reader.ReadUInt64();
+	public DumpedTypeTreeNodeMetaFlags MetaFlags { get; }
+	public ulong RefTypeHash { get; }
+
+	/// <summary>
+	/// The offsets of <see cref="Type"/> and <see cref="Name"/> in the engine's common string buffer,
+	/// or <see langword="null"/> if the engine stored them in the tree's own string buffer or the file does not say.
+	/// </summary>
+	public uint? TypeCommonOffset { get; }
+	public uint? NameCommonOffset { get; }
+
+	/// <summary>
+	/// The offset of the node's data from the start of the object's data, or <see langword="null"/> if it depends on
+	/// the data or the file does not say.
+	/// </summary>
+	public uint? ByteOffset { get; }
+
+	/// <summary>
+	/// Whether <see cref="ByteOffset"/> is known without reading the data, as the node is only preceded by fixed size data.
+	/// </summary>
+	public bool HasStaticByteOffset => ByteOffset.HasValue;
+
+	/// <summary>
+	/// The indices of the node's parent and next sibling, or <see langword="null"/> if it has none or the file
+	/// does not say. Both are only read from files with <see cref="DumpedTypeTreeHeaderFlags.Navigation"/>.
+	/// </summary>
+	public int? ParentIndex { get; }
+	public int? NextSiblingIndex { get; }
+
+	/// <summary>
+	/// The number of nodes in the node's subtree including the node itself, or <see langword="null"/> if the file does not say.
+	/// </summary>
+	public int? SubtreeNodeCount { get; }
+
+	/// <summary>
+	/// A structural hash of the node's subtree, equal for subtrees with equal nodes wherever they appear,
+	/// or <see langword="null"/> if the file does not say.
+	/// </summary>
+	public ulong? SubtreeHash { get; }
+
+	public DumpedTypeTreeNode(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable)
+	{
+		Type = ReadString(reader, stringTable);
+		Name = ReadString(reader, stringTable);
+
+		Flags = (DumpedTypeTreeNodeFlags)reader.ReadUInt32();
+		ByteSize = reader.ReadInt32();
+		Index = reader.ReadInt32();
+
+		Version = reader.ReadInt16();
+		Level = reader.ReadByte();
+
+		MetaFlags = (DumpedTypeTreeNodeMetaFlags)reader.ReadUInt32();
+		RefTypeHash = reader.ReadUInt64();
+
+		TypeCommonOffset = ReadCommonOffset(reader, headerFlags);
+		NameCommonOffset = ReadCommonOffset(reader, headerFlags);
+
+		ByteOffset = ReadByteOffset(reader, headerFlags);
+
+		ParentIndex = ReadNodeIndex(reader, headerFlags);
+		NextSiblingIndex = ReadNodeIndex(reader, headerFlags);
+		SubtreeNodeCount = headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.Navigation) ? checked((int)reader.ReadUInt32()) : null;
+
+		SubtreeHash = headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.SubtreeHashes) ? reader.ReadUInt64() : null;
+	}
+
+	/// <summary>
+	/// Places a node of a shared subtree where the reference uses it, the inverse of storing its positional fields
+	/// relative to the subtree's root. The root takes its parent and next sibling from the reference.
+	/// </summary>
+	internal DumpedTypeTreeNode(DumpedTypeTreeNode node, DumpedTypeTreeSubtreeReference reference, bool isRoot)
+	{
+		Type = node.Type;
+		Name = node.Name;
+
+		Flags = node.Flags;
+		ByteSize = node.ByteSize;
+		Index = unchecked(node.Index + reference.Index);
+
+		Version = node.Version;
+		Level = unchecked((byte)(node.Level + reference.Level));
+
+		MetaFlags = node.MetaFlags;
+		RefTypeHash = node.RefTypeHash;
+
+		TypeCommonOffset = node.TypeCommonOffset;
+		NameCommonOffset = node.NameCommonOffset;
+
+		ByteOffset = node.ByteOffset is { } byteOffset && reference.ByteOffset is { } referenceByteOffset
+			? unchecked(byteOffset + referenceByteOffset)
+			: node.ByteOffset;
+
+		ParentIndex = isRoot ? reference.ParentIndex : node.ParentIndex + reference.Position;
+		NextSiblingIndex = isRoot ? reference.NextSiblingIndex : node.NextSiblingIndex + reference.Position;
+		SubtreeNodeCount = node.SubtreeNodeCount;
+
+		SubtreeHash = node.SubtreeHash;
+	}
+
+	/// <summary>
+	/// Reads a string ID when the file has a string table, and an inline string otherwise.
+	/// </summary>
+	private static string ReadString(BinaryReader reader, IReadOnlyList<string>? stringTable)
+	{
+		if (stringTable is null)
+			return reader.ReadLengthPrefixedString();
+
+		var id = reader.ReadUInt32();
+		if (id >= stringTable.Count)
+		{
+			throw new InvalidDataException($"Invalid string ID: {id}");
+		}
+
+		return stringTable[(int)id];
+	}
+
+	private static uint? ReadCommonOffset(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags)
+	{
+		if (!headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.CommonStrings))
+			return null;
+
+		var offset = reader.ReadUInt32();
+		return offset != uint.MaxValue ? offset : null;
+	}
+
+	private static uint? ReadByteOffset(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags)
+	{
+		if (!headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.ByteOffsets))
+			return null;
+
+		var offset = reader.ReadUInt32();
+		return offset != uint.MaxValue ? offset : null;
+	}
+
+	private static int? ReadNodeIndex(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags)
+	{
+		if (!headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.Navigation))
+			return null;
+
+		var index = reader.ReadUInt32();
+		return index != uint.MaxValue ? checked((int)index) : null;
+	}
 
 	public int GetValueHash()
 	{
@@ -0,0 +1,47 @@
+namespace TypeTreeRipper.BinaryFormat;
+
+/// <summary>
+/// The tree of a MonoBehaviour or ScriptableObject scripting class, dumped with <c>TYPETREERIPPER_SCRIPTS</c>.
+/// </summary>
+public class DumpedTypeTreeScript
+{
+	public string AssemblyName { get; }
+	public string Namespace { get; }
+	public string ClassName { get; }
+
+	/// <summary>
+	/// The root node's <c>m_RefTypeHash</c> as set by the engine, or 0 on revisions without it.
+	/// </summary>
+	public ulong RefTypeHash { get; }
+
+	/// <summary>
+	/// The native MonoBehaviour or ScriptableObject RTTI and the combined native and managed nodes.
+	/// </summary>
+	public DumpedTypeTree Tree { get; }
+
+	public DumpedTypeTreeScript(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		IReadOnlyList<DumpedTypeTreeSubtree>? subtrees = null)
+	{
+		AssemblyName = reader.ReadLengthPrefixedString();
+		Namespace = reader.ReadLengthPrefixedString();
+		ClassName = reader.ReadLengthPrefixedString();
+		RefTypeHash = reader.ReadUInt64();
+
+		// Script trees never refer to other trees
+		Tree = new DumpedTypeTree(reader, headerFlags & ~DumpedTypeTreeHeaderFlags.TreeReferences, stringTable, subtrees);
+	}
+
+	/// <summary>
+	/// Reads a script of a tree set, whose RTTI comes from the file's RTTI table and whose transfer flags are those of the set.
+	/// </summary>
+	public DumpedTypeTreeScript(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		IReadOnlyList<DumpedTypeTreeRTTI> rttiTable, TransferInstructionFlags transferFlags, IReadOnlyList<DumpedTypeTreeSubtree>? subtrees = null)
+	{
+		AssemblyName = reader.ReadLengthPrefixedString();
+		Namespace = reader.ReadLengthPrefixedString();
+		ClassName = reader.ReadLengthPrefixedString();
+		RefTypeHash = reader.ReadUInt64();
+
+		Tree = new DumpedTypeTree(reader, headerFlags & ~DumpedTypeTreeHeaderFlags.TreeReferences, stringTable, rttiTable, transferFlags, subtrees);
+	}
+}
@@ -0,0 +1,144 @@
+namespace TypeTreeRipper.BinaryFormat;
+
+/// <summary>
+/// A shared subtree used at one position of a node array, see <see cref="DumpedTypeTreeHeaderFlags.SubtreeReferences"/>.
+/// The root's positional fields depend on where the subtree is used and are stored here.
+/// </summary>
+public class DumpedTypeTreeSubtreeReference
+{
+	/// <summary>
+	/// The index of the subtree in <see cref="TypeTreeBinary.Subtrees"/>.
+	/// </summary>
+	public int Subtree { get; }
+
+	/// <summary>
+	/// The index of the subtree's root in the expanded node array.
+	/// </summary>
+	public int Position { get; }
+
+	public byte Level { get; }
+	public int Index { get; }
+	public uint? ByteOffset { get; }
+	public int? ParentIndex { get; }
+	public int? NextSiblingIndex { get; }
+
+	internal DumpedTypeTreeSubtreeReference(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, int position)
+	{
+		Subtree = checked((int)reader.ReadUInt32());
+		Position = position;
+		Level = reader.ReadByte();
+		Index = reader.ReadInt32();
+
+		if (headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.ByteOffsets) && reader.ReadUInt32() is var byteOffset and not uint.MaxValue)
+		{
+			ByteOffset = byteOffset;
+		}
+
+		if (headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.Navigation))
+		{
+			ParentIndex = ReadNodeIndex(reader);
+			NextSiblingIndex = ReadNodeIndex(reader);
+		}
+	}
+
+	private static int? ReadNodeIndex(BinaryReader reader)
+	{
+		var index = reader.ReadUInt32();
+		return index != uint.MaxValue ? checked((int)index) : null;
+	}
+}
+
+/// <summary>
+/// A node array with some of its subtrees replaced by references to the shared subtrees of the file, which are
+/// stored the same way with their root at level 0 and index 0. The nodes are expanded on first use.
+/// </summary>
+public class DumpedTypeTreeSubtree
+{
+	private readonly IReadOnlyList<DumpedTypeTreeSubtree> _subtrees;
+	private List<DumpedTypeTreeNode>? _expandedNodes;
+
+	/// <summary>
+	/// The number of nodes once the references are expanded.
+	/// </summary>
+	public int NodeCount { get; private set; }
+
+	/// <summary>
+	/// The nodes stored in place, in order.
+	/// </summary>
+	public List<DumpedTypeTreeNode> Nodes { get; } = [];
+
+	/// <summary>
+	/// The references to shared subtrees, in position order.
+	/// </summary>
+	public List<DumpedTypeTreeSubtreeReference> References { get; } = [];
+
+	/// <summary>
+	/// Reads a node array, which may only refer to the shared subtrees read before it.
+	/// </summary>
+	public DumpedTypeTreeSubtree(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable,
+		IReadOnlyList<DumpedTypeTreeSubtree> subtrees)
+	{
+		_subtrees = subtrees;
+
+		// The runs of nodes stored in place alternate with the references, whose positions follow from the sizes
+		// of the runs and of the referenced subtrees
+		var referenceCount = reader.ReadUInt32();
+		for (int i = 0; i < referenceCount; i++)
+		{
+			ReadNodes(reader, headerFlags, stringTable);
+
+			var reference = new DumpedTypeTreeSubtreeReference(reader, headerFlags, NodeCount);
+			if (reference.Subtree >= subtrees.Count || subtrees[reference.Subtree].NodeCount == 0)
+			{
+				throw new InvalidDataException($"Invalid subtree reference: {reference.Subtree}");
+			}
+
+			References.Add(reference);
+			NodeCount = checked(NodeCount + subtrees[reference.Subtree].NodeCount);
+		}
+
+		ReadNodes(reader, headerFlags, stringTable);
+	}
+
+	private void ReadNodes(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, IReadOnlyList<string>? stringTable)
+	{
+		var count = reader.ReadUInt32();
+		for (int i = 0; i < count; i++)
+		{
+			Nodes.Add(new DumpedTypeTreeNode(reader, headerFlags, stringTable));
+		}
+
+		NodeCount = checked(NodeCount + (int)count);
+	}
+
+	/// <summary>
+	/// The nodes with every reference replaced by the nodes of the shared subtree, placed at the reference's position.
+	/// Shared subtrees are expanded once and reused by every node array referring to them.
+	/// </summary>
+	public List<DumpedTypeTreeNode> GetExpandedNodes()
+	{
+		if (_expandedNodes is not null)
+			return _expandedNodes;
+
+		var nodes = new List<DumpedTypeTreeNode>(NodeCount);
+		var inlineIndex = 0;
+
+		foreach (var reference in References)
+		{
+			var inlineCount = reference.Position - nodes.Count;
+			nodes.AddRange(Nodes.GetRange(inlineIndex, inlineCount));
+			inlineIndex += inlineCount;
+
+			var subtreeNodes = _subtrees[reference.Subtree].GetExpandedNodes();
+			for (int i = 0; i < subtreeNodes.Count; i++)
+			{
+				nodes.Add(new DumpedTypeTreeNode(subtreeNodes[i], reference, i == 0));
+			}
+		}
+
+		nodes.AddRange(Nodes.GetRange(inlineIndex, Nodes.Count - inlineIndex));
+
+		_expandedNodes = nodes;
+		return nodes;
+	}
+}
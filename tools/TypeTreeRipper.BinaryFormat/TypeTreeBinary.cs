@@ -1,13 +1,40 @@
+using System.Buffers.Binary;
+
 namespace TypeTreeRipper.BinaryFormat;
 
 public class TypeTreeBinary
 {
 	public const ulong ExpectedMagic = 0x4545525445505954; // 'TYPETREE', little-endian
-	public const uint ExpectedVersion = 1;
+	public const uint MinimumVersion = 1;
+	public const uint MaximumVersion = 2;
+
+	private const uint SectionScripts = 0x50524353; // 'SCRP', little-endian
+	private const uint SectionHierarchy = 0x52454948; // 'HIER', little-endian
 
 	public DumpedTypeTreeHeader Header { get; }
+
+	/// <summary>
+	/// The engine's common string buffer that <see cref="DumpedTypeTreeNode.TypeCommonOffset"/> and
+	/// <see cref="DumpedTypeTreeNode.NameCommonOffset"/> refer to, if the file contains it.
+	/// </summary>
+	public byte[]? CommonStringBuffer { get; }
+
+	/// <summary>
+	/// The subtrees shared by the trees and scripts, if the file contains them. Each may only refer to the ones before it.
+	/// </summary>
+	public List<DumpedTypeTreeSubtree> Subtrees { get; } = [];
 	public List<DumpedTypeTree> TypeTrees { get; }
 
+	/// <summary>
+	/// The class hierarchy of the types in the file, if the file contains it.
+	/// </summary>
+	public DumpedTypeHierarchy? Hierarchy { get; }
+
+	/// <summary>
+	/// The trees of the MonoBehaviour and ScriptableObject scripting classes, if the file contains them.
+	/// </summary>
+	public List<DumpedTypeTreeScript> Scripts { get; } = [];
+
 	public TypeTreeBinary(BinaryReader reader)
 	{
 		Header = new DumpedTypeTreeHeader(reader);
@@ -17,17 +44,148 @@ public class TypeTreeBinary
 			throw new InvalidDataException($"Invalid magic number: {Header.Magic:X16}");
 		}
 
-		if (Header.Version != ExpectedVersion)
+		if (Header.Version is < MinimumVersion or > MaximumVersion)
 		{
 			throw new InvalidDataException($"Unsupported version: {Header.Version}");
 		}
 
-		var count = reader.ReadUInt32();
-		TypeTrees = new List<DumpedTypeTree>(checked((int)count));
-		for (int i = 0; i < count; i++)
+		List<string>? stringTable = null;
+		if (Header.Flags.HasFlag(DumpedTypeTreeHeaderFlags.StringTable))
+		{
+			var stringCount = reader.ReadUInt32();
+			stringTable = new List<string>(checked((int)stringCount));
+			for (int i = 0; i < stringCount; i++)
+			{
+				stringTable.Add(reader.ReadLengthPrefixedString());
+			}
+		}
+
+		if (Header.Flags.HasFlag(DumpedTypeTreeHeaderFlags.CommonStrings))
+		{
+			var size = reader.ReadUInt32();
+			CommonStringBuffer = reader.ReadBytes(checked((int)size));
+			if (CommonStringBuffer.Length != size)
+			{
+				throw new EndOfStreamException();
+			}
+		}
+
+		if (Header.Flags.HasFlag(DumpedTypeTreeHeaderFlags.SubtreeReferences))
+		{
+			var subtreeCount = reader.ReadUInt32();
+			for (int i = 0; i < subtreeCount; i++)
+			{
+				Subtrees.Add(new DumpedTypeTreeSubtree(reader, Header.Flags, stringTable, Subtrees));
+			}
+		}
+
+		// The RTTI is stored once, and every set of trees and scripts shares the transfer flags stored before it
+		List<DumpedTypeTreeRTTI> rttiTable = [];
+		if (Header.Flags.HasFlag(DumpedTypeTreeHeaderFlags.TreeSets))
+		{
+			var rttiCount = reader.ReadUInt32();
+			rttiTable.Capacity = checked((int)rttiCount);
+			for (int i = 0; i < rttiCount; i++)
+			{
+				rttiTable.Add(new DumpedTypeTreeRTTI(reader));
+			}
+		}
+
+		TypeTrees = ReadTreeSets(reader, Header.Flags, transferFlags => transferFlags is { } setTransferFlags
+			? new DumpedTypeTree(reader, Header.Flags, stringTable, rttiTable, setTransferFlags, Subtrees)
+			: new DumpedTypeTree(reader, Header.Flags, stringTable, Subtrees));
+
+		foreach (var typeTree in TypeTrees)
+		{
+			if (typeTree.ReferencedTree is not { } referencedTree)
+				continue;
+
+			if (referencedTree >= TypeTrees.Count || TypeTrees[referencedTree].ReferencedTree is not null)
+			{
+				throw new InvalidDataException($"Invalid type tree reference: {referencedTree}");
+			}
+
+			typeTree.ResolveReference(TypeTrees[referencedTree]);
+		}
+
+		// Optional sections follow until the end of the file, unknown ones are skipped
+		while (reader.ReadBytes(sizeof(uint)) is { Length: > 0 } tag)
 		{
-			TypeTrees.Add(new DumpedTypeTree(reader));
+			if (tag.Length != sizeof(uint))
+			{
+				throw new EndOfStreamException();
+			}
+
+			var size = reader.ReadUInt32();
+			var payload = reader.ReadBytes(checked((int)size));
+			if (payload.Length != size)
+			{
+				throw new EndOfStreamException();
+			}
+
+			using var sectionReader = new BinaryReader(new MemoryStream(payload));
+			switch (BinaryPrimitives.ReadUInt32LittleEndian(tag))
+			{
+				case SectionScripts:
+					Scripts = ReadTreeSets(sectionReader, Header.Flags, transferFlags => transferFlags is { } setTransferFlags
+						? new DumpedTypeTreeScript(sectionReader, Header.Flags, stringTable, rttiTable, setTransferFlags, Subtrees)
+						: new DumpedTypeTreeScript(sectionReader, Header.Flags, stringTable, Subtrees));
+					break;
+				case SectionHierarchy:
+					Hierarchy = new DumpedTypeHierarchy(sectionReader);
+					break;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Reads the trees or scripts of every set, passing the set's transfer flags, or all of them as one set without
+	/// transfer flags if the file has no tree sets.
+	/// </summary>
+	private static List<T> ReadTreeSets<T>(BinaryReader reader, DumpedTypeTreeHeaderFlags headerFlags, Func<TransferInstructionFlags?, T> read)
+	{
+		if (!headerFlags.HasFlag(DumpedTypeTreeHeaderFlags.TreeSets))
+		{
+			var count = reader.ReadUInt32();
+			var values = new List<T>(checked((int)count));
+			for (int i = 0; i < count; i++)
+			{
+				values.Add(read(null));
+			}
+
+			return values;
 		}
+
+		var setValues = new List<T>();
+		var setCount = reader.ReadUInt32();
+		for (int i = 0; i < setCount; i++)
+		{
+			var transferFlags = (TransferInstructionFlags)reader.ReadUInt64();
+			var count = reader.ReadUInt32();
+			for (int j = 0; j < count; j++)
+			{
+				setValues.Add(read(transferFlags));
+			}
+		}
+
+		return setValues;
+	}
+
+	/// <summary>
+	/// The trees dumped with the given transfer flags, such as <see cref="TransferInstructionFlags.SerializeGameRelease"/>
+	/// for the release trees of an editor dump.
+	/// </summary>
+	public IEnumerable<DumpedTypeTree> GetTypeTrees(TransferInstructionFlags transferFlags)
+	{
+		return TypeTrees.Where(typeTree => typeTree.TransferFlags == transferFlags);
+	}
+
+	/// <summary>
+	/// The scripts dumped with the given transfer flags, see <see cref="GetTypeTrees"/>.
+	/// </summary>
+	public IEnumerable<DumpedTypeTreeScript> GetScripts(TransferInstructionFlags transferFlags)
+	{
+		return Scripts.Where(script => script.Tree.TransferFlags == transferFlags);
 	}
 
 	public static TypeTreeBinary FromFile(string filePath)
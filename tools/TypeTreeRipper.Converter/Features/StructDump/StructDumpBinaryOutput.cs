@@ -55,8 +55,15 @@ public static class StructDumpBinaryOutput
             // The ancient tools do a check for negative persistent type IDs here, but this check never succeeds
             // as they were only ever part of MonoBehavior type ids to signal special handling
             // our type IDs are always positive
-            nonAbstractBaseType.CalculateOldTypeHash(oldTypeHashBuffer);
-            writer.Write(oldTypeHashBuffer);
+            if (nonAbstractBaseType.OldTypeHash is { } oldTypeHash)
+            {
+                writer.Write(oldTypeHash);
+            }
+            else
+            {
+                nonAbstractBaseType.CalculateOldTypeHash(oldTypeHashBuffer);
+                writer.Write(oldTypeHashBuffer);
+            }
 
             writer.Write(nonAbstractBaseType.Nodes.Count);
 
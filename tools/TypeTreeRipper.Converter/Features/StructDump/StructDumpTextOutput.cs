@@ -15,34 +15,47 @@ public static class StructDumpTextOutput
     {
         var typesByTypeId = binary.TypeTrees.ToDictionary(x => x.RTTI.PersistentTypeId);
 
-        foreach (var type in binary.TypeTrees.OrderBy(x => x.RTTI.PersistentTypeId))
+        // With the hierarchy section, base chains are followed through table indices instead of type ID lookups
+        var hierarchy = binary.Hierarchy;
+        var typesByIndex = hierarchy?.Types.Select(x => typesByTypeId[x.PersistentTypeId]).ToArray();
+
+        IEnumerable<DumpedTypeTree> GetBaseChain(DumpedTypeTree type)
         {
-            writer.Write($"\n// classID{{{type.RTTI.PersistentTypeId}}}: ");
+            if (hierarchy?.GetIndex(type.RTTI.PersistentTypeId) is { } index)
+            {
+                for (int? current = index; current is { } i; current = hierarchy.GetBaseIndex(i))
+                    yield return typesByIndex![i];
+
+                yield break;
+            }
 
-            var inheritanceCurrentType = type;
             while (true)
             {
-                writer.Write(inheritanceCurrentType.RTTI.ClassName);
-                if (inheritanceCurrentType.RTTI.BasePersistentTypeId == -1)
+                yield return type;
+                if (type.RTTI.BasePersistentTypeId == -1)
                     break;
 
-                writer.Write(" <- ");
-                inheritanceCurrentType = typesByTypeId[inheritanceCurrentType.RTTI.BasePersistentTypeId];
+                type = typesByTypeId[type.RTTI.BasePersistentTypeId];
             }
+        }
 
-            writer.WriteLine();
+        foreach (var type in binary.TypeTrees.OrderBy(x => x.RTTI.PersistentTypeId))
+        {
+            writer.Write($"\n// classID{{{type.RTTI.PersistentTypeId}}}: ");
+            writer.WriteLine(string.Join(" <- ", GetBaseChain(type).Select(x => x.RTTI.ClassName)));
 
-            var abstractCurrentType = type;
-            while (abstractCurrentType.RTTI.Flags.HasFlag(DumpedTypeTreeRTTIFlags.IsAbstract))
+            // Abstract types have no nodes, so the nodes of their closest non-abstract base are written
+            var nodesType = type;
+            foreach (var baseType in GetBaseChain(type))
             {
-                writer.WriteLine($"// {abstractCurrentType.RTTI.ClassName} is abstract");
-                if (abstractCurrentType.RTTI.BasePersistentTypeId == -1)
+                nodesType = baseType;
+                if (!baseType.RTTI.Flags.HasFlag(DumpedTypeTreeRTTIFlags.IsAbstract))
                     break;
 
-                abstractCurrentType = typesByTypeId[abstractCurrentType.RTTI.BasePersistentTypeId];
+                writer.WriteLine($"// {baseType.RTTI.ClassName} is abstract");
             }
 
-            foreach (var node in abstractCurrentType.Nodes)
+            foreach (var node in nodesType.Nodes)
                 Output(node, writer);
         }
     }
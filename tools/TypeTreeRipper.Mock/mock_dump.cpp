@@ -0,0 +1,130 @@
+#include <charconv>
+#include <cstdio>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "common.hpp"
+#include "mock_platform.hpp"
+
+//
+// Runs the dumper end to end against a synthetic engine of any supported revision and variant,
+// writing the same files a dump of a real engine would.
+//
+
+namespace
+{
+    struct MockDumpOptions
+    {
+        Revision EngineRevision;
+        Variant EngineVariant;
+        MockRegistryOptions Registry;
+        MockImageOptions Image;
+    };
+
+    uint64_t ParseNumber(const std::string_view name, const std::string_view value)
+    {
+        uint64_t result;
+        if (std::from_chars(value.data(), value.data() + value.size(), result).ec != std::errc{})
+            throw std::runtime_error("Invalid value for " + std::string(name) + ": " + std::string(value));
+
+        return result;
+    }
+
+    MockDumpOptions ParseOptions(const std::span<char const *const> arguments)
+    {
+        if (arguments.size() < 2)
+            throw std::runtime_error("Expected a revision and a variant");
+
+        const auto revision = VersionStringToRevision(std::string(arguments[0]));
+        if (!revision.has_value() || revision.value() < Revision::V5_2_0)
+            throw std::runtime_error(std::string("Unsupported revision ") + arguments[0]);
+
+        const auto variant = VariantStringToVariant(std::string_view(arguments[1]));
+        if (!variant.has_value())
+            throw std::runtime_error(std::string("Unknown variant ") + arguments[1]);
+
+        MockDumpOptions options{ .EngineRevision = revision.value(), .EngineVariant = variant.value(), .Registry = {}, .Image = {} };
+
+        for (size_t i = 2; i < arguments.size(); i++)
+        {
+            const auto name = std::string_view(arguments[i]);
+
+            if (name == "--verbose")
+            {
+                options.Image.Verbose = true;
+                continue;
+            }
+
+            if (i + 1 == arguments.size())
+                throw std::runtime_error("Missing value for " + std::string(name));
+
+            const auto value = std::string_view(arguments[++i]);
+
+            if (name == "--types")
+                options.Registry.TypeCount = static_cast<uint32_t>(ParseNumber(name, value));
+            else if (name == "--shapes")
+                options.Registry.ShapeCount = static_cast<uint32_t>(ParseNumber(name, value));
+            else if (name == "--nodes")
+                options.Registry.NodesPerTree = static_cast<uint32_t>(ParseNumber(name, value));
+            else if (name == "--scripts")
+                options.Registry.ScriptCount = static_cast<uint32_t>(ParseNumber(name, value));
+            else if (name == "--seed")
+                options.Registry.Seed = ParseNumber(name, value);
+            else if (name == "--image-size")
+                options.Image.WritableSectionSize = ParseNumber(name, value);
+            else if (name == "--array-offset")
+                options.Image.TypeArrayOffset = ParseNumber(name, value);
+            else if (name == "--output")
+                options.Image.OutputDirectory = value;
+            else
+                throw std::runtime_error("Unknown option " + std::string(name));
+        }
+
+        return options;
+    }
+
+    template<Revision R, Variant V>
+    void RunMockDump(const MockDumpOptions &options)
+    {
+        if constexpr (R >= Revision::V5_2_0)
+        {
+            MockEngine<R, V> engine(MockRegistry::CreateSynthetic(options.Registry), options.Image);
+            RunMockDumper(engine);
+        }
+    }
+
+    template<size_t... I>
+    void RunMockDump(const MockDumpOptions &options, std::index_sequence<I...>)
+    {
+        using RunFunction = void (*)(const MockDumpOptions &);
+
+        constexpr RunFunction kRunFunctions[][sizeof...(I)] = {
+            { &RunMockDump<static_cast<Revision>(I), Variant::Editor>... },
+            { &RunMockDump<static_cast<Revision>(I), Variant::Runtime>... },
+            { &RunMockDump<static_cast<Revision>(I), Variant::RuntimeDev>... },
+        };
+
+        kRunFunctions[std::to_underlying(options.EngineVariant)][std::to_underlying(options.EngineRevision)](options);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        const auto options = ParseOptions(std::span<char const *const>(argv + 1, argc - 1));
+        RunMockDump(options, std::make_index_sequence<std::to_underlying(Revision::Count)>{});
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        std::fputs("Usage: TypeTreeRipper.MockDump <revision> <variant> [--types <n>] [--shapes <n>] [--nodes <n>] [--scripts <n>]\n"
+            "                                 [--seed <n>] [--image-size <bytes>] [--array-offset <bytes>] [--output <directory>] [--verbose]\n", stderr);
+        return 1;
+    }
+}
@@ -0,0 +1,559 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "executable.hpp"
+#include "Object.hpp"
+#include "RTTI.hpp"
+#include "GenerateTypeTreeTransfer.hpp"
+#include "scripting.hpp"
+#include "vtable.hpp"
+
+#include "mock_registry.hpp"
+
+//
+// In-process stand-in for a Unity module, allowing the dumper to run without the engine.
+// A synthetic image is laid out like a loaded module: a read-only section with the common string buffer,
+// class names and vtables, a writable section with the RTTI records and the RuntimeTypeArray, and an
+// executable section spanning the mock factories. Mock objects dispatch VirtualRedirectTransfer through
+// one vtable per shape, into a function that fills the TypeTree with the shape's nodes. Scripts are
+// attached to MonoBehaviour objects through SetCachedScriptingObject and append their shape's fields.
+//
+
+struct MockImageOptions
+{
+    // Minimum section sizes, sections are grown to fit their contents
+    size_t ReadOnlySectionSize = 0;
+    size_t WritableSectionSize = 0;
+
+    // Offsets of the common string buffer and the RuntimeTypeArray in their sections
+    size_t CommonStringBufferOffset = 0;
+    size_t TypeArrayOffset = 0;
+
+    std::filesystem::path OutputDirectory = ".";
+    bool Verbose = false;
+};
+
+class MockModuleImage;
+
+struct MockObject
+{
+    void const *const *VTable;
+    MockModuleImage *Image;
+    uint32_t TypeIndex;
+    void *ScriptingObject = nullptr;
+};
+
+// Stand-in for a MonoObject, with the header a managed object starts with
+struct MockScriptingObject
+{
+    void *Header[2];
+    uint32_t ScriptIndex;
+};
+
+namespace mock_details
+{
+    // Unity's common string buffer, as found in engine versions up to 2023
+    inline constexpr char kCommonStrings[] =
+        "AABB\0AnimationClip\0AnimationCurve\0AnimationState\0Array\0Base\0BitField\0bitset\0bool\0char\0ColorRGBA\0"
+        "Component\0data\0deque\0double\0dynamic_array\0FastPropertyName\0first\0float\0Font\0GameObject\0Generic Mono\0"
+        "GradientNEW\0GUID\0GUIStyle\0int\0list\0long long\0map\0Matrix4x4f\0MdFour\0MonoBehaviour\0MonoScript\0m_ByteSize\0"
+        "m_Curve\0m_EditorClassIdentifier\0m_EditorHideFlags\0m_Enabled\0m_ExtensionPtr\0m_GameObject\0m_Index\0m_IsArray\0"
+        "m_IsStatic\0m_MetaFlag\0m_Name\0m_ObjectHideFlags\0m_PrefabInternal\0m_PrefabParentObject\0m_Script\0"
+        "m_StaticEditorFlags\0m_Type\0m_Version\0Object\0pair\0PPtr<Component>\0PPtr<GameObject>\0PPtr<Material>\0"
+        "PPtr<MonoBehaviour>\0PPtr<MonoScript>\0PPtr<Object>\0PPtr<Prefab>\0PPtr<Sprite>\0PPtr<TextAsset>\0PPtr<Texture>\0"
+        "PPtr<Texture2D>\0PPtr<Transform>\0Prefab\0Quaternionf\0Rectf\0RectInt\0RectOffset\0second\0set\0short\0size\0"
+        "SInt16\0SInt32\0SInt64\0SInt8\0staticvector\0string\0TextAsset\0TextMesh\0Texture\0Texture2D\0Transform\0"
+        "TypelessData\0UInt16\0UInt32\0UInt64\0UInt8\0unsigned int\0unsigned long long\0unsigned short\0vector\0"
+        "Vector2f\0Vector3f\0Vector4f\0m_ScriptingClassIdentifier\0Gradient\0Type*\0int2_storage\0int3_storage\0"
+        "BoundsInt\0m_CorrespondingSourceObject\0m_PrefabInstance\0m_PrefabAsset\0FileSize\0Hash128\0";
+
+    inline MockModuleImage *CurrentImage = nullptr;
+
+    inline void UnexpectedVirtualCall()
+    {
+        std::fputs("Unexpected virtual call on a mock object\n", stderr);
+        std::abort();
+    }
+
+    // Both MonoObject * and ScriptingObjectPtr are passed like a pointer
+    inline void SetCachedScriptingObject(MockObject *object, void *scriptingObject)
+    {
+        object->ScriptingObject = scriptingObject;
+    }
+
+    // Factories are called with a MemLabelId and an ObjectCreationMode, which are ignored.
+    // Both supported calling conventions leave argument cleanup to the caller.
+    template<size_t I>
+    void *CreateObject();
+
+    template<size_t I>
+    void Transfer(MockObject *object, void *transfer);
+
+    template<size_t... I>
+    consteval auto MakeFactoryTable(std::index_sequence<I...>)
+    {
+        return std::array<void *(*)(), sizeof...(I)>{ &CreateObject<I>... };
+    }
+
+    template<size_t... I>
+    consteval auto MakeTransferTable(std::index_sequence<I...>)
+    {
+        return std::array<void (*)(MockObject *, void *), sizeof...(I)>{ &Transfer<I>... };
+    }
+
+    inline constexpr auto kFactoryTable = MakeFactoryTable(std::make_index_sequence<MockRegistry::kMaxTypes>{});
+    inline constexpr auto kTransferTable = MakeTransferTable(std::make_index_sequence<MockRegistry::kMaxShapes>{});
+}
+
+// Revision independent part of the mock engine, owning the image and the objects created from it.
+class MockModuleImage
+{
+public:
+    MockModuleImage(const MockModuleImage &) = delete;
+    MockModuleImage &operator=(const MockModuleImage &) = delete;
+
+    virtual ~MockModuleImage()
+    {
+        if (mock_details::CurrentImage == this)
+            mock_details::CurrentImage = nullptr;
+    }
+
+    // The image used by MockPlatformImpl and the mock factories
+    static MockModuleImage &GetCurrent()
+    {
+        if (mock_details::CurrentImage == nullptr)
+        {
+            std::fputs("No mock engine is active\n", stderr);
+            std::abort();
+        }
+
+        return *mock_details::CurrentImage;
+    }
+
+    void MakeCurrent()
+    {
+        mock_details::CurrentImage = this;
+    }
+
+    std::span<ExecutableSection> GetSections()
+    {
+        return Sections;
+    }
+
+    const MockRegistry &GetRegistry() const
+    {
+        return Registry;
+    }
+
+    const MockImageOptions &GetOptions() const
+    {
+        return Options;
+    }
+
+    char const *GetCommonStringBuffer() const
+    {
+        return ReadOnlyData.data() + Options.CommonStringBufferOffset;
+    }
+
+    void const *GetRuntimeTypeArray() const
+    {
+        return WritableData.data() + Options.TypeArrayOffset;
+    }
+
+    // The scripting classes, with an instance of each, as a platform would enumerate them
+    std::vector<ScriptingClass> GetScriptingClasses()
+    {
+        std::vector<ScriptingClass> result;
+
+        for (auto &instance : ScriptingObjects)
+        {
+            const auto &script = Registry.Scripts[instance.ScriptIndex];
+            result.push_back({
+                .AssemblyName = script.AssemblyName,
+                .Namespace = script.Namespace,
+                .ClassName = script.ClassName,
+                .Instance = &instance,
+                .InstanceData = &instance.ScriptIndex,
+                .InstanceDataSize = sizeof(instance.ScriptIndex),
+            });
+        }
+
+        return result;
+    }
+
+    void *CreateObject(const uint32_t typeIndex)
+    {
+        const auto &type = Registry.Types[typeIndex];
+        return &Objects.emplace_back(MockObject{
+            .VTable = reinterpret_cast<void const *const *>(ReadOnlyData.data() + VTablesOffset) + type.Shape * VTableSize,
+            .Image = this,
+            .TypeIndex = typeIndex,
+        });
+    }
+
+    virtual void FillTree(const MockObject &object, void *transfer) = 0;
+protected:
+    MockModuleImage(MockRegistry registry, MockImageOptions options)
+        : Registry(std::move(registry)), Options(std::move(options))
+    {
+        Registry.Validate();
+
+        for (uint32_t i = 0; i < Registry.Scripts.size(); i++)
+            ScriptingObjects.push_back({ .Header = {}, .ScriptIndex = i });
+    }
+
+    // Lays out the read-only section and returns the offset of each class name.
+    std::vector<size_t> BuildReadOnlySection(const size_t transferSlot, const size_t scriptingObjectSlot)
+    {
+        std::vector<char> data(Options.CommonStringBufferOffset);
+        data.insert(data.end(), std::begin(mock_details::kCommonStrings), std::end(mock_details::kCommonStrings));
+
+        for (size_t offset = 0; offset < sizeof(mock_details::kCommonStrings) - 1; offset += std::strlen(mock_details::kCommonStrings + offset) + 1)
+            CommonStringOffsets.try_emplace(mock_details::kCommonStrings + offset, static_cast<uint32_t>(offset));
+
+        std::vector<size_t> classNameOffsets;
+        for (const auto &type : Registry.Types)
+        {
+            classNameOffsets.push_back(data.size());
+            data.insert(data.end(), type.ClassName.c_str(), type.ClassName.c_str() + type.ClassName.size() + 1);
+        }
+
+        data.resize((data.size() + alignof(void *) - 1) & ~(alignof(void *) - 1));
+        VTablesOffset = data.size();
+        VTableSize = std::max(transferSlot, scriptingObjectSlot) + 1;
+
+        for (size_t shape = 0; shape < Registry.Shapes.size(); shape++)
+        {
+            std::vector<void const *> vtable(VTableSize, reinterpret_cast<void const *>(&mock_details::UnexpectedVirtualCall));
+            vtable[transferSlot] = reinterpret_cast<void const *>(mock_details::kTransferTable[shape]);
+            vtable[scriptingObjectSlot] = reinterpret_cast<void const *>(&mock_details::SetCachedScriptingObject);
+
+            const auto bytes = reinterpret_cast<char const *>(vtable.data());
+            data.insert(data.end(), bytes, bytes + vtable.size() * sizeof(void const *));
+        }
+
+        data.resize(std::max(data.size(), Options.ReadOnlySectionSize));
+        ReadOnlyData = std::move(data);
+        return classNameOffsets;
+    }
+
+    void BuildSections()
+    {
+        // The factories only need to be inside a readable section, their code is never inspected
+        const auto [first, last] = std::ranges::minmax(mock_details::kFactoryTable | std::views::transform([](const auto factory)
+        {
+            return reinterpret_cast<char *>(factory);
+        }));
+
+        Sections = {
+            { std::span(ReadOnlyData), ExecutableSection::kSectionProtectionRead },
+            { std::span(WritableData), ExecutableSection::kSectionProtectionRead | ExecutableSection::kSectionProtectionWrite },
+            { std::span(first, last + 1), ExecutableSection::kSectionProtectionRead | ExecutableSection::kSectionProtectionExecute },
+        };
+    }
+
+    // Returns the offset of a string in the common string buffer, if it is one of the common strings
+    std::optional<uint32_t> GetCommonStringOffset(const std::string &value) const
+    {
+        if (const auto it = CommonStringOffsets.find(value); it != CommonStringOffsets.end())
+            return it->second;
+
+        return std::nullopt;
+    }
+
+    MockRegistry Registry;
+    MockImageOptions Options;
+
+    std::vector<char> ReadOnlyData;
+    std::vector<char> WritableData;
+    std::vector<ExecutableSection> Sections;
+
+    std::unordered_map<std::string, uint32_t> CommonStringOffsets;
+    size_t VTablesOffset = 0;
+    size_t VTableSize = 0;
+
+    // Objects are never destroyed by the dumper, but must outlive the run
+    std::deque<MockObject> Objects;
+    std::deque<MockScriptingObject> ScriptingObjects;
+};
+
+template<size_t I>
+void *mock_details::CreateObject()
+{
+    return MockModuleImage::GetCurrent().CreateObject(static_cast<uint32_t>(I));
+}
+
+template<size_t I>
+void mock_details::Transfer(MockObject *object, void *transfer)
+{
+    object->Image->FillTree(*object, transfer);
+}
+
+template<Revision R, Variant V>
+    requires (R >= Revision::V5_2_0)
+class MockEngine final : public MockModuleImage
+{
+    using Object = ::Object<R, V>;
+    using RTTI = ::RTTI<R, V>;
+    using RuntimeTypeArray = ::RuntimeTypeArray<R, V>;
+    using TypeTreeNode = ::TypeTreeNode<R, V>;
+    using GenerateTypeTreeTransfer = ::GenerateTypeTreeTransfer<R, V>;
+public:
+    MockEngine(MockRegistry registry, MockImageOptions options = {})
+        : MockModuleImage(std::move(registry), std::move(options))
+    {
+        // The same slot the dumper calls through, for this revision's Object layout
+        const auto transferSlot = GetVirtualFunctionSlot<Object>([](Object *probe)
+        {
+            alignas(GenerateTypeTreeTransfer) char transfer[sizeof(GenerateTypeTreeTransfer)];
+            probe->VirtualRedirectTransfer(*reinterpret_cast<GenerateTypeTreeTransfer *>(transfer));
+        });
+
+        const auto scriptingObjectSlot = GetVirtualFunctionSlot<Object>([](Object *probe)
+        {
+            if constexpr (requires { probe->SetCachedScriptingObject(static_cast<MonoObject *>(nullptr)); })
+            {
+                probe->SetCachedScriptingObject(static_cast<MonoObject *>(nullptr));
+            }
+            else
+            {
+                probe->SetCachedScriptingObject(ScriptingObjectPtr(nullptr));
+            }
+        });
+
+        const auto classNameOffsets = BuildReadOnlySection(transferSlot, scriptingObjectSlot);
+        BuildWritableSection(classNameOffsets);
+        BuildSections();
+        MakeCurrent();
+    }
+
+    void FillTree(const MockObject &object, void *transferPtr) override
+    {
+        auto &transfer = *static_cast<GenerateTypeTreeTransfer *>(transferPtr);
+        auto &tree = transfer.GetTypeTree();
+
+        const auto &type = Registry.Types[object.TypeIndex];
+
+        // An attached script's fields follow the native fields, below the same root
+        std::vector<MockTreeNode const *> shapeNodes;
+        for (const auto &node : Registry.Shapes[type.Shape].Nodes)
+            shapeNodes.push_back(&node);
+
+        if (object.ScriptingObject != nullptr)
+        {
+            const auto &script = Registry.Scripts[static_cast<MockScriptingObject *>(object.ScriptingObject)->ScriptIndex];
+            for (const auto &node : Registry.Shapes[script.Shape].Nodes | std::views::drop(1))
+                shapeNodes.push_back(&node);
+        }
+
+        ScratchStrings.clear();
+        ScratchStringOffsets.clear();
+
+        const auto getStringOffset = [&](const std::string &value) -> uint32_t
+        {
+            if (const auto common = GetCommonStringOffset(value); common.has_value())
+                return common.value() | 0x80000000;
+
+            const auto [it, inserted] = ScratchStringOffsets.try_emplace(value, static_cast<uint32_t>(ScratchStrings.size()));
+            if (inserted)
+                ScratchStrings.insert(ScratchStrings.end(), value.c_str(), value.c_str() + value.size() + 1);
+
+            return it->second;
+        };
+
+        ScratchNodes.assign(shapeNodes.size(), TypeTreeNode{});
+        for (size_t i = 0; i < shapeNodes.size(); i++)
+        {
+            const auto &source = *shapeNodes[i];
+            auto &node = ScratchNodes[i];
+
+            node.m_Version = source.Version;
+            node.m_Level = source.Level;
+            node.m_TypeStrOffset = getStringOffset(i == 0 ? type.ClassName : source.Type);
+            node.m_NameStrOffset = getStringOffset(source.Name);
+            node.m_ByteSize = source.ByteSize;
+            node.m_Index = static_cast<int32_t>(i);
+            node.m_MetaFlag = source.MetaFlags;
+
+            if constexpr (requires { node.m_IsArray; })
+            {
+                node.m_IsArray = source.IsArray;
+            }
+            else
+            {
+                node.m_TypeFlags = source.IsArray ? TypeTreeNode::kFlagIsArray : 0;
+            }
+        }
+
+        tree.Nodes().assign_external(ScratchNodes.data(), ScratchNodes.size(), ScratchNodes.size());
+        tree.StringsBuffer().assign_external(ScratchStrings.data(), ScratchStrings.size(), ScratchStrings.size());
+
+        ScratchByteOffsets.assign(shapeNodes.size(), kNoByteOffset);
+        if (!shapeNodes.empty())
+            LayoutByteOffsets(shapeNodes, 0, 0);
+
+        tree.ByteOffsets().assign_external(ScratchByteOffsets.data(), ScratchByteOffsets.size(), ScratchByteOffsets.size());
+
+        if constexpr (requires { tree.GetData()->Levels(); })
+        {
+            ScratchLevels.resize(ScratchNodes.size());
+            ScratchNextIndex.resize(ScratchNodes.size());
+
+            for (size_t i = 0; i < ScratchNodes.size(); i++)
+            {
+                // Index of the first node after the subtree, or -1 at the end of the tree
+                auto next = i + 1;
+                while (next < ScratchNodes.size() && ScratchNodes[next].m_Level > ScratchNodes[i].m_Level)
+                    next++;
+
+                ScratchLevels[i] = ScratchNodes[i].m_Level;
+                ScratchNextIndex[i] = next < ScratchNodes.size() ? static_cast<int32_t>(next) : -1;
+            }
+
+            tree.GetData()->Levels().assign_external(ScratchLevels.data(), ScratchLevels.size(), ScratchLevels.size());
+            tree.GetData()->NextIndex().assign_external(ScratchNextIndex.data(), ScratchNextIndex.size(), ScratchNextIndex.size());
+        }
+    }
+private:
+    static constexpr uint32_t kNoByteOffset = 0xFFFFFFFF;
+
+    // Records the offsets of the subtree at index while they are known, returning the index after the
+    // subtree and the offset after its data
+    std::pair<size_t, std::optional<uint32_t>> LayoutByteOffsets(const std::vector<const MockTreeNode *> &nodes, const size_t index, std::optional<uint32_t> offset)
+    {
+        const auto &node = *nodes[index];
+        ScratchByteOffsets[index] = offset.value_or(kNoByteOffset);
+
+        auto next = index + 1;
+        if (next < nodes.size() && nodes[next]->Level > node.Level)
+        {
+            // The elements of arrays are not laid out statically
+            auto childOffset = node.IsArray ? std::nullopt : offset;
+            while (next < nodes.size() && nodes[next]->Level > node.Level)
+                std::tie(next, childOffset) = LayoutByteOffsets(nodes, next, childOffset);
+
+            offset = node.IsArray ? std::nullopt : childOffset;
+        }
+        else if (node.IsArray || node.ByteSize < 0)
+        {
+            offset.reset();
+        }
+        else if (offset.has_value())
+        {
+            offset = offset.value() + static_cast<uint32_t>(node.ByteSize);
+        }
+
+        if (offset.has_value() && (node.MetaFlags & TransferMetaFlags<R, V>::kAlignBytesFlag) != 0)
+            offset = (offset.value() + 3) & ~3u;
+
+        return { next, offset };
+    }
+
+    void BuildWritableSection(const std::vector<size_t> &classNameOffsets)
+    {
+        const auto typeCount = Registry.Types.size();
+
+        // RTTI records follow the array
+        const auto typeArrayOffset = (Options.TypeArrayOffset + alignof(RuntimeTypeArray) - 1) & ~(alignof(RuntimeTypeArray) - 1);
+        const auto rttiOffset = (typeArrayOffset + sizeof(RuntimeTypeArray) + alignof(RTTI) - 1) & ~(alignof(RTTI) - 1);
+
+        // The dumper does not scan the last sizeof(RuntimeTypeArray) bytes of a section
+        const auto size = std::max(rttiOffset + typeCount * sizeof(RTTI) + sizeof(RuntimeTypeArray), Options.WritableSectionSize);
+
+        Options.TypeArrayOffset = typeArrayOffset;
+        WritableData.assign(size, 0);
+
+        const auto array = new(WritableData.data() + typeArrayOffset) RuntimeTypeArray{};
+        const auto records = reinterpret_cast<RTTI *>(WritableData.data() + rttiOffset);
+        const auto emptyString = GetCommonStringBuffer() + sizeof(mock_details::kCommonStrings) - 1;
+        const auto derivedFromInfos = GetDerivedFromInfos();
+
+        array->Count = static_cast<int32_t>(typeCount);
+
+        for (size_t i = 0; i < typeCount; i++)
+        {
+            const auto &type = Registry.Types[i];
+            const auto rtti = new(records + i) RTTI{};
+
+            rtti->base = type.BaseIndex >= 0 ? records + type.BaseIndex : nullptr;
+            rtti->persistentTypeID = type.PersistentTypeID;
+            rtti->className = ReadOnlyData.data() + classNameOffsets[i];
+            rtti->size = type.Size;
+            rtti->isAbstract = type.IsAbstract;
+            rtti->isSealed = type.IsSealed;
+
+            // The factories ignore their arguments, the cast through void (*)() marks the signature mismatch as intended
+            if (!type.IsAbstract)
+                rtti->factory = reinterpret_cast<decltype(rtti->factory)>(reinterpret_cast<void (*)()>(mock_details::kFactoryTable[i]));
+
+            if constexpr (requires { rtti->classNamespace; })
+                rtti->classNamespace = emptyString;
+
+            if constexpr (requires { rtti->module; })
+                rtti->module = "Mock";
+
+            if constexpr (requires { rtti->derivedFromInfo; })
+                rtti->derivedFromInfo = derivedFromInfos[i];
+
+            array->Types[i] = rtti;
+        }
+    }
+
+    // Unity numbers types in hierarchy order, so that all descendants of a type follow it contiguously
+    std::vector<DerivedFromInfo> GetDerivedFromInfos() const
+    {
+        std::vector<std::vector<size_t>> children(Registry.Types.size());
+        for (size_t i = 1; i < Registry.Types.size(); i++)
+            children[Registry.Types[i].BaseIndex].push_back(i);
+
+        std::vector<DerivedFromInfo> result(Registry.Types.size());
+        uint32_t nextTypeIndex = 0;
+
+        // Preorder traversal, where a type's descendant count is known once all of its children were visited
+        std::vector<std::pair<size_t, size_t>> stack{ { 0, 0 } };
+        result[0].typeIndex = nextTypeIndex++;
+
+        while (!stack.empty())
+        {
+            auto &[type, nextChild] = stack.back();
+
+            if (nextChild == children[type].size())
+            {
+                result[type].descendantCount = nextTypeIndex - result[type].typeIndex - 1;
+                stack.pop_back();
+                continue;
+            }
+
+            const auto child = children[type][nextChild++];
+            result[child].typeIndex = nextTypeIndex++;
+            stack.emplace_back(child, 0);
+        }
+
+        return result;
+    }
+
+    // Backing storage for the arrays of the tree being generated, which the dumper converts before the next transfer
+    std::vector<TypeTreeNode> ScratchNodes;
+    std::vector<char> ScratchStrings;
+    std::vector<uint8_t> ScratchLevels;
+    std::vector<int32_t> ScratchNextIndex;
+    std::vector<uint32_t> ScratchByteOffsets;
+    std::unordered_map<std::string, uint32_t> ScratchStringOffsets;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+#include "common.hpp"
+#include "executable.hpp"
+#include "platform_impl.hpp"
+#include "dumper.hpp"
+
+#if defined(__linux__)
+#include "resident_set_size.hpp"
+#endif
+
+#include "mock_engine.hpp"
+
+// Platform implementation backed by the current MockModuleImage.
+template<Revision R, Variant V>
+class MockPlatformImpl
+{
+public:
+    std::span<ExecutableSection> GetExecutableSections()
+    {
+        return MockModuleImage::GetCurrent().GetSections();
+    }
+
+    static OutputFile CreateOutputFile(char const *filename)
+    {
+        return OutputFile(MockModuleImage::GetCurrent().GetOptions().OutputDirectory / filename);
+    }
+
+    static std::vector<ScriptingClass> GetScriptingClasses()
+    {
+        return MockModuleImage::GetCurrent().GetScriptingClasses();
+    }
+
+    static void DebugLog(char const *message)
+    {
+        if (MockModuleImage::GetCurrent().GetOptions().Verbose)
+            std::puts(message);
+    }
+
+#if defined(__linux__)
+    static uint64_t GetResidentSetSize()
+    {
+        return ReadResidentSetSize();
+    }
+#endif
+};
+
+// Runs a full dump against a mock engine, which becomes the current image.
+template<Revision R, Variant V>
+void RunMockDumper(MockEngine<R, V> &engine)
+{
+    static_assert(IsPlatformImpl<R, V, MockPlatformImpl<R, V>>, "Mock platform implementation is ill-formed");
+
+    engine.MakeCurrent();
+
+    // A fresh dumper per run, as the writer accumulates the trees of every pass
+    Dumper<R, V, MockPlatformImpl<R, V>> dumper;
+    dumper.Run();
+}
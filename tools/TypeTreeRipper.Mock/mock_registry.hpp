@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//
+// Engine-independent description of the types a mock engine registers.
+// Every type with a factory generates the tree of its shape, with the root node renamed to the class name,
+// and types sharing a shape share a transfer implementation like engine types sharing a base implementation.
+//
+
+struct MockTreeNode
+{
+    std::string Type;
+    std::string Name;
+    uint8_t Level = 0;
+    int16_t Version = 1;
+    int32_t ByteSize = -1;
+    bool IsArray = false;
+    uint32_t MetaFlags = 0;
+};
+
+struct MockTreeShape
+{
+    // The first node is the root, its type is replaced with the class name when generated
+    std::vector<MockTreeNode> Nodes;
+};
+
+struct MockType
+{
+    std::string ClassName;
+    int32_t PersistentTypeID;
+    // Index into MockRegistry::Types, or -1 for the root type
+    int32_t BaseIndex = -1;
+    int32_t Size = 0;
+    bool IsAbstract = false;
+    bool IsSealed = false;
+    // Index into MockRegistry::Shapes, only used by types that are not abstract
+    uint32_t Shape = 0;
+};
+
+// A managed MonoBehaviour or ScriptableObject class, whose fields are appended to the MonoBehaviour tree
+struct MockScript
+{
+    std::string AssemblyName;
+    std::string Namespace;
+    std::string ClassName;
+    // Index into MockRegistry::Shapes, the root node is not used
+    uint32_t Shape = 0;
+};
+
+struct MockRegistryOptions
+{
+    uint32_t TypeCount = 300;
+    uint32_t ShapeCount = 64;
+    uint32_t NodesPerTree = 40;
+    uint32_t ScriptCount = 0;
+    uint64_t Seed = 1;
+};
+
+struct MockRegistry
+{
+    // Capacity of the engine's RuntimeTypeArray
+    static constexpr uint32_t kMaxTypes = 1024;
+
+    // Number of distinct transfer implementations a mock engine provides
+    static constexpr uint32_t kMaxShapes = 256;
+
+    std::vector<MockTreeShape> Shapes;
+    std::vector<MockType> Types;
+    std::vector<MockScript> Scripts;
+
+    void Validate() const
+    {
+        if (Types.size() < 2 || Types.size() > kMaxTypes)
+            throw std::runtime_error("A mock registry must contain between 2 and " + std::to_string(kMaxTypes) + " types");
+
+        if (Shapes.size() > kMaxShapes)
+            throw std::runtime_error("A mock registry can not contain more than " + std::to_string(kMaxShapes) + " shapes");
+
+        // The dumper recognizes the RuntimeTypeArray by its first two entries
+        if (Types[0].ClassName != "Object" || Types[0].PersistentTypeID != 0 || Types[0].BaseIndex != -1 || Types[1].BaseIndex != 0)
+            throw std::runtime_error("A mock registry must start with Object and a type deriving from it");
+
+        for (size_t i = 0; i < Types.size(); i++)
+        {
+            const auto &type = Types[i];
+
+            if (type.BaseIndex >= static_cast<int32_t>(i) || (i != 0 && type.BaseIndex < 0))
+                throw std::runtime_error(type.ClassName + " must derive from an earlier type");
+
+            if (!type.IsAbstract && (type.Shape >= Shapes.size() || Shapes[type.Shape].Nodes.empty()))
+                throw std::runtime_error(type.ClassName + " has an invalid shape");
+        }
+
+        for (const auto &script : Scripts)
+        {
+            if (script.Shape >= Shapes.size() || Shapes[script.Shape].Nodes.empty())
+                throw std::runtime_error(script.ClassName + " has an invalid shape");
+        }
+
+        if (!Scripts.empty() && std::ranges::none_of(Types, [](const MockType &type) { return type.ClassName == "MonoBehaviour" && !type.IsAbstract; }))
+            throw std::runtime_error("A mock registry with scripts must contain a MonoBehaviour type");
+    }
+
+    // Generates a deterministic registry resembling an engine type registry.
+    static MockRegistry CreateSynthetic(const MockRegistryOptions &options)
+    {
+        Random random{ options.Seed };
+        MockRegistry registry;
+
+        const auto shapeCount = std::clamp<uint32_t>(options.ShapeCount, 1, kMaxShapes);
+        for (uint32_t i = 0; i < shapeCount; i++)
+            registry.Shapes.push_back(CreateSyntheticShape(random, std::max<uint32_t>(options.NodesPerTree, 1)));
+
+        registry.Types.push_back({ .ClassName = "Object", .PersistentTypeID = 0, .IsAbstract = true });
+        registry.Types.push_back({ .ClassName = "EditorExtension", .PersistentTypeID = 18, .BaseIndex = 0, .IsAbstract = true });
+
+        // Scripts need a MonoBehaviour type, which is added last
+        const auto typeCount = std::clamp<uint32_t>(options.TypeCount, 2, options.ScriptCount != 0 ? kMaxTypes - 1 : kMaxTypes);
+        for (uint32_t i = 2; i < typeCount; i++)
+        {
+            // Derive from an earlier abstract type, so that hierarchies several levels deep are produced
+            int32_t base;
+            do
+            {
+                base = static_cast<int32_t>(random.Next(i));
+            } while (!registry.Types[base].IsAbstract);
+
+            const auto shape = static_cast<uint32_t>(random.Next(shapeCount));
+            const auto isAbstract = random.Next(8) == 0;
+
+            registry.Types.push_back({
+                .ClassName = "MockType" + std::to_string(i),
+                .PersistentTypeID = static_cast<int32_t>(1000 + i),
+                .BaseIndex = base,
+                // Most types sharing a shape also share a size, like engine types that only override unrelated functions
+                .Size = static_cast<int32_t>(16 + shape * 8 + (random.Next(4) == 0 ? 8 : 0)),
+                .IsAbstract = isAbstract,
+                .IsSealed = !isAbstract && random.Next(2) == 0,
+                .Shape = shape,
+            });
+        }
+
+        if (options.ScriptCount != 0)
+        {
+            registry.Types.push_back({
+                .ClassName = "MonoBehaviour",
+                .PersistentTypeID = 114,
+                .BaseIndex = 1,
+                .Size = 64,
+                .Shape = static_cast<uint32_t>(random.Next(shapeCount)),
+            });
+        }
+
+        for (uint32_t i = 0; i < options.ScriptCount; i++)
+        {
+            registry.Scripts.push_back({
+                .AssemblyName = i % 2 == 0 ? "Assembly-CSharp" : "Mock.Runtime",
+                .Namespace = i % 3 == 0 ? "" : "Mock.Scripts",
+                .ClassName = "MockScript" + std::to_string(i),
+                .Shape = static_cast<uint32_t>(random.Next(shapeCount)),
+            });
+        }
+
+        return registry;
+    }
+private:
+    // splitmix64, used instead of <random> so that registries are identical across standard libraries
+    struct Random
+    {
+        uint64_t State;
+
+        uint64_t Next()
+        {
+            uint64_t z = (State += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t Next(const uint64_t bound)
+        {
+            return Next() % bound;
+        }
+    };
+
+    static void AddArray(std::vector<MockTreeNode> &nodes, const uint8_t level, const char *elementType, const int32_t elementSize)
+    {
+        nodes.push_back({ .Type = "Array", .Name = "Array", .Level = level, .IsArray = true });
+        nodes.push_back({ .Type = "int", .Name = "size", .Level = static_cast<uint8_t>(level + 1), .ByteSize = 4 });
+        nodes.push_back({ .Type = elementType, .Name = "data", .Level = static_cast<uint8_t>(level + 1), .ByteSize = elementSize });
+    }
+
+    static MockTreeShape CreateSyntheticShape(Random &random, const uint32_t nodeCount)
+    {
+        // The alignment flag, the only meta flag with an effect on the serialized layout
+        constexpr uint32_t kAlignBytesFlag = 1 << 14;
+
+        MockTreeShape shape;
+        shape.Nodes.push_back({ .Type = "", .Name = "Base", .Level = 0 });
+
+        uint32_t fieldIndex = 0;
+
+        // The deepest level the next field may be placed at, i.e. one below the innermost open struct
+        uint8_t maxLevel = 1;
+
+        while (shape.Nodes.size() < nodeCount)
+        {
+            const auto level = static_cast<uint8_t>(1 + random.Next(maxLevel));
+            const auto name = "m_Field" + std::to_string(fieldIndex++);
+            maxLevel = level;
+
+            switch (random.Next(8))
+            {
+            case 0:
+                shape.Nodes.push_back({ .Type = "int", .Name = name, .Level = level, .ByteSize = 4 });
+                break;
+            case 1:
+                shape.Nodes.push_back({ .Type = "float", .Name = name, .Level = level, .ByteSize = 4 });
+                break;
+            case 2:
+                shape.Nodes.push_back({ .Type = "UInt8", .Name = name, .Level = level, .ByteSize = 1, .MetaFlags = kAlignBytesFlag });
+                break;
+            case 3:
+                shape.Nodes.push_back({ .Type = "string", .Name = name, .Level = level, .MetaFlags = kAlignBytesFlag });
+                AddArray(shape.Nodes, level + 1, "char", 1);
+                break;
+            case 4:
+                shape.Nodes.push_back({ .Type = "PPtr<Object>", .Name = name, .Level = level, .ByteSize = 12 });
+                shape.Nodes.push_back({ .Type = "int", .Name = "m_FileID", .Level = static_cast<uint8_t>(level + 1), .ByteSize = 4 });
+                shape.Nodes.push_back({ .Type = "SInt64", .Name = "m_PathID", .Level = static_cast<uint8_t>(level + 1), .ByteSize = 8 });
+                break;
+            case 5:
+                shape.Nodes.push_back({ .Type = "vector", .Name = name, .Level = level, .MetaFlags = kAlignBytesFlag });
+                AddArray(shape.Nodes, level + 1, "float", 4);
+                break;
+            case 6:
+                shape.Nodes.push_back({ .Type = "Vector3f", .Name = name, .Level = level, .ByteSize = 12 });
+                for (const auto component : { "x", "y", "z" })
+                    shape.Nodes.push_back({ .Type = "float", .Name = component, .Level = static_cast<uint8_t>(level + 1), .ByteSize = 4 });
+                break;
+            default:
+                // Structs with type names that are not in the common string buffer, nested up to a few levels deep
+                shape.Nodes.push_back({ .Type = "MockStruct" + std::to_string(random.Next(16)), .Name = name, .Level = level });
+                maxLevel = std::min<uint8_t>(level + 1, 4);
+                break;
+            }
+        }
+
+        return shape;
+    }
+};
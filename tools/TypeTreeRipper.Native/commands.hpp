@@ -0,0 +1,11 @@
+#pragma once
+#include <span>
+
+// Each command receives the arguments following the command name and returns the process exit code.
+using NativeCommand = int (*)(std::span<char const *const> arguments);
+
+int RunMergeCommand(std::span<char const *const> arguments);
+int RunConvertCommand(std::span<char const *const> arguments);
+int RunDeltaCommand(std::span<char const *const> arguments);
+int RunApplyCommand(std::span<char const *const> arguments);
+int RunVerifyCommand(std::span<char const *const> arguments);
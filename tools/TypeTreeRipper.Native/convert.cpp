@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binary_output.hpp"
+#include "commands.hpp"
+#include "common.hpp"
+#include "options.hpp"
+#include "output_file.hpp"
+#include "raw_capture_format.hpp"
+
+//
+// Converts a .ttraw capture written with TYPETREERIPPER_RAW_CAPTURE into the .ttbin the dumper would have
+// written in the engine process, by running the same DumpedTypeTreeWriter<R, V> over the captured node arrays.
+// Options affecting the output (TYPETREERIPPER_DEDUPLICATE, TYPETREERIPPER_STRING_TABLE,
+// TYPETREERIPPER_COMMON_STRINGS, TYPETREERIPPER_BYTE_OFFSETS, TYPETREERIPPER_NAVIGATION,
+// TYPETREERIPPER_SUBTREE_HASHES, TYPETREERIPPER_TYPE_HASHES, TYPETREERIPPER_SUBTREE_REFERENCES,
+// TYPETREERIPPER_HIERARCHY, TYPETREERIPPER_COLUMNAR, TYPETREERIPPER_BLOCK_COMPRESSION,
+// TYPETREERIPPER_SERIALIZED_BLOBS) are read from the environment here, like the dumper does.
+//
+
+namespace
+{
+    RawCapture ReadCapture(char const *path)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        if (!input)
+            throw std::runtime_error(std::string("Failed to open ") + path);
+
+        RawCapture capture;
+        internal::Read(input, capture);
+        return capture;
+    }
+
+    bool IsTerminated(const std::vector<char> &buffer)
+    {
+        return !buffer.empty() && buffer.back() == '\0';
+    }
+
+    // Copies the captured node array into properly aligned nodes, checking that all string offsets
+    // point into their buffers before the writer dereferences them
+    template<typename TypeTreeNode>
+    std::vector<TypeTreeNode> GetCapturedNodes(const RawCapturedTree &tree, const std::vector<char> &commonStringBuffer)
+    {
+        if (tree.Nodes.size() % sizeof(TypeTreeNode) != 0)
+            throw std::runtime_error(tree.RTTI.ClassName + " has a partial node array");
+
+        std::vector<TypeTreeNode> nodes(tree.Nodes.size() / sizeof(TypeTreeNode));
+        std::memcpy(nodes.data(), tree.Nodes.data(), tree.Nodes.size());
+
+        const auto isValidOffset = [&](const uint32_t offset)
+        {
+            const auto &buffer = (offset & 0x80000000) != 0 ? commonStringBuffer : tree.StringBuffer;
+            return IsTerminated(buffer) && (offset & ~0x80000000) < buffer.size();
+        };
+
+        for (const auto &node : nodes)
+        {
+            if (!isValidOffset(node.m_TypeStrOffset) || !isValidOffset(node.m_NameStrOffset))
+                throw std::runtime_error(tree.RTTI.ClassName + " has a string offset outside of its string buffers");
+        }
+
+        return nodes;
+    }
+
+    // Copies one of the per-node arrays of a captured tree into properly aligned values
+    template<typename T>
+    std::vector<T> GetCapturedArray(const RawCapturedTree &tree, const std::vector<char> &array, char const *name)
+    {
+        if (array.size() % sizeof(T) != 0)
+            throw std::runtime_error(tree.RTTI.ClassName + " has a partial " + name + " array");
+
+        std::vector<T> values(array.size() / sizeof(T));
+        std::memcpy(values.data(), array.data(), array.size());
+        return values;
+    }
+
+    template<Revision R, Variant V>
+    void ConvertCapture(const RawCapture &capture, const DumperOptions &options, OutputBuffer &output)
+    {
+        if constexpr (R >= Revision::V5_2_0)
+        {
+            using TypeTreeNode = ::TypeTreeNode<R, V>;
+            using TransferInstructionFlags = ::TransferInstructionFlags<R, V>;
+
+            if (capture.Header.NodeSize != sizeof(TypeTreeNode))
+            {
+                throw std::runtime_error("The capture has " + std::to_string(capture.Header.NodeSize) + " byte nodes, expected "
+                    + std::to_string(sizeof(TypeTreeNode)) + " for its revision and variant");
+            }
+
+            DumpedTypeTreeWriter<R, V> writer;
+            writer.SetDeduplicateTrees(options.DeduplicateTrees);
+            writer.SetUseStringTable(options.UseStringTable);
+            writer.SetUseCommonStrings(options.UseCommonStrings);
+            writer.SetUseByteOffsets(options.UseByteOffsets);
+            writer.SetUseNavigation(options.UseNavigation);
+            writer.SetUseSubtreeHashes(options.UseSubtreeHashes);
+            writer.SetUseTypeHashes(options.UseTypeHashes);
+            writer.SetEmitHierarchy(options.Hierarchy);
+            writer.SetUseSubtreeReferences(options.UseSubtreeReferences);
+            writer.SetUseTreeSets(options.UseTreeSets);
+            writer.SetUseChecksums(options.UseChecksums);
+            writer.SetUseColumnarFormat(options.Columnar);
+            writer.SetCompressionBlockSize(options.CompressionBlockSize);
+            writer.SetEmitSerializedBlobs(options.SerializedBlobs);
+            writer.SetCommonStringBuffer({ capture.CommonStringBuffer.data(), capture.CommonStringBuffer.size() });
+
+            if (capture.Shard.has_value())
+                writer.SetShard(capture.Shard.value());
+
+            const auto commonStringBuffer = capture.CommonStringBuffer.data();
+
+            for (const auto &tree : capture.Trees)
+            {
+                const auto flags = static_cast<TransferInstructionFlags>(tree.TransferFlags);
+
+                if (tree.SourceTree != RawCapturedTree::kNoSourceTree)
+                {
+                    if (tree.SourceTree >= writer.GetTypeTreeCount())
+                        throw std::runtime_error(tree.RTTI.ClassName + " reuses the tree of a later type");
+
+                    writer.AddReused(tree.RTTI, flags, tree.SourceTree);
+                    continue;
+                }
+
+                const auto nodes = GetCapturedNodes<TypeTreeNode>(tree, capture.CommonStringBuffer);
+                writer.AddCaptured(tree.RTTI, flags, nodes, tree.StringBuffer.data(), commonStringBuffer,
+                    GetCapturedArray<uint32_t>(tree, tree.ByteOffsets, "byte offset"), GetCapturedArray<int32_t>(tree, tree.NextIndex, "next index"));
+            }
+
+            for (const auto &script : capture.Scripts)
+            {
+                const auto nodes = GetCapturedNodes<TypeTreeNode>(script.Tree, capture.CommonStringBuffer);
+
+                writer.AddCapturedScript(script.Tree.RTTI, static_cast<TransferInstructionFlags>(script.Tree.TransferFlags), nodes,
+                    script.Tree.StringBuffer.data(), commonStringBuffer, GetCapturedArray<uint32_t>(script.Tree, script.Tree.ByteOffsets, "byte offset"),
+                    GetCapturedArray<int32_t>(script.Tree, script.Tree.NextIndex, "next index"), ScriptingClass{
+                        .AssemblyName = script.AssemblyName,
+                        .Namespace = script.Namespace,
+                        .ClassName = script.ClassName,
+                    });
+            }
+
+            writer.Write(output);
+        }
+        else
+        {
+            throw std::runtime_error("Captures are only supported from 5.2 onwards");
+        }
+    }
+
+    template<size_t... I>
+    void ConvertCapture(const Revision revision, const Variant variant, const RawCapture &capture, const DumperOptions &options, OutputBuffer &output, std::index_sequence<I...>)
+    {
+        using ConvertFunction = void (*)(const RawCapture &, const DumperOptions &, OutputBuffer &);
+
+        constexpr ConvertFunction kConvertFunctions[][sizeof...(I)] = {
+            { &ConvertCapture<static_cast<Revision>(I), Variant::Editor>... },
+            { &ConvertCapture<static_cast<Revision>(I), Variant::Runtime>... },
+            { &ConvertCapture<static_cast<Revision>(I), Variant::RuntimeDev>... },
+        };
+
+        kConvertFunctions[std::to_underlying(variant)][std::to_underlying(revision)](capture, options, output);
+    }
+}
+
+int RunConvertCommand(const std::span<char const *const> arguments)
+{
+    if (arguments.size() != 2)
+    {
+        std::fputs("Usage: TypeTreeRipper.Native convert <output-path> <capture-path>\n", stderr);
+        return 1;
+    }
+
+    const auto capture = ReadCapture(arguments[1]);
+    const auto &header = capture.Header;
+
+    // Captures store the version of the exact revision they were made with
+    const auto revision = VersionToRevision(header.MajorRevision, header.MinorRevision, header.PatchRevision);
+    if (!revision.has_value() || RevisionToVersion(revision.value()) != RevisionVersion(header.MajorRevision, header.MinorRevision, header.PatchRevision))
+        throw std::runtime_error(std::string(arguments[1]) + " was captured from an unknown revision");
+
+    const auto variant = VariantStringToVariant(std::string_view(header.Variant));
+    if (!variant.has_value())
+        throw std::runtime_error(std::string(arguments[1]) + " was captured from an unknown variant " + header.Variant);
+
+    if (!IsTerminated(capture.CommonStringBuffer))
+        throw std::runtime_error(std::string(arguments[1]) + " has an unterminated common string buffer");
+
+    OutputFile output(arguments[0]);
+    if (!output)
+        throw std::runtime_error(std::string("Failed to create ") + arguments[0]);
+
+    OutputBuffer buffer;
+    ConvertCapture(revision.value(), variant.value(), capture, DumperOptions::FromEnvironment(), buffer,
+        std::make_index_sequence<std::to_underlying(Revision::Count)>{});
+
+    if (!output.Write(buffer))
+        throw std::runtime_error(std::string("Failed to write ") + arguments[0]);
+
+    std::printf("Converted %zu type trees and %zu scripts from %s into %s\n", capture.Trees.size(), capture.Scripts.size(), arguments[1], arguments[0]);
+    return 0;
+}
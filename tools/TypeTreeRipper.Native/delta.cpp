@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "commands.hpp"
+#include "delta_format.hpp"
+#include "output_file.hpp"
+
+//
+// Stores a dump as the changes from an earlier one, e.g. of the previous revision, and reconstructs it again.
+// Applying a chain of deltas to the dump the first one was made against gives the exact file the last one was made from.
+//
+
+namespace
+{
+    DumpedTypeTreeBinary ReadBinary(char const *path)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        if (!input)
+            throw std::runtime_error(std::string("Failed to open ") + path);
+
+        DumpedTypeTreeBinary binary;
+        internal::Read(input, binary);
+        return binary;
+    }
+
+    DumpedTypeTreeDelta ReadDelta(char const *path)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        if (!input)
+            throw std::runtime_error(std::string("Failed to open ") + path);
+
+        DumpedTypeTreeDelta delta;
+        internal::Read(input, delta);
+        return delta;
+    }
+
+    void WriteFile(char const *path, const OutputBuffer &buffer)
+    {
+        OutputFile output(path);
+        if (!output)
+            throw std::runtime_error(std::string("Failed to create ") + path);
+
+        if (!output.Write(buffer))
+            throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+
+    void PrintChanges(char const *kind, const DumpedTypeTreeDeltaChanges &changes)
+    {
+        std::printf("  %s: %zu unchanged, %zu changed, %zu added, %zu removed\n", kind, changes.Unchanged, changes.Changed, changes.Added,
+            changes.Removed.size());
+    }
+}
+
+int RunDeltaCommand(const std::span<char const *const> arguments)
+{
+    if (arguments.size() != 3)
+    {
+        std::fputs("Usage: TypeTreeRipper.Native delta <output-path> <base-path> <target-path>\n", stderr);
+        return 1;
+    }
+
+    const auto base = ReadBinary(arguments[1]);
+    const auto target = ReadBinary(arguments[2]);
+    const auto delta = BuildDelta(base, target);
+
+    // Applying the delta checks that it reproduces the target before anything relies on it
+    static_cast<void>(ApplyDelta(base, delta));
+
+    OutputBuffer buffer;
+    internal::Write(buffer, delta);
+    WriteFile(arguments[0], buffer);
+
+    std::printf("Wrote the changes from %s to %s (%zu bytes) into %s\n", arguments[1], arguments[2], buffer.GetSize(), arguments[0]);
+    PrintChanges("type trees", GetTypeTreeChanges(delta));
+    PrintChanges("scripts", GetScriptChanges(delta));
+    return 0;
+}
+
+int RunApplyCommand(const std::span<char const *const> arguments)
+{
+    if (arguments.size() < 3)
+    {
+        std::fputs("Usage: TypeTreeRipper.Native apply <output-path> <base-path> <delta-path>...\n", stderr);
+        return 1;
+    }
+
+    auto binary = ReadBinary(arguments[1]);
+    for (const auto path : arguments.subspan(2))
+    {
+        binary = ApplyDelta(binary, ReadDelta(path));
+    }
+
+    // References were resolved when the trees were read, and are found again the way the dumper found them
+    if (binary.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagTreeReferences)
+        DeduplicateTypeTrees(binary.TypeTrees);
+
+    OutputBuffer buffer;
+    internal::Write(buffer, binary);
+    WriteFile(arguments[0], buffer);
+
+    std::printf("Applied %zu deltas (%zu type trees) into %s\n", arguments.size() - 2, binary.TypeTrees.size(), arguments[0]);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <array>
+#include <cstdio>
+#include <exception>
+#include <span>
+#include <string_view>
+#include <tuple>
+
+#include "commands.hpp"
+
+int main(int argc, char **argv)
+{
+    constexpr std::array kCommands = {
+        std::make_tuple("merge", "<output-path> <shard-path>...", "Merges partial .ttbin shards into a single .ttbin.", &RunMergeCommand),
+        std::make_tuple("convert", "<output-path> <capture-path>", "Converts a .ttraw raw capture into a .ttbin.", &RunConvertCommand),
+        std::make_tuple("delta", "<output-path> <base-path> <target-path>", "Writes the changes from a base .ttbin to a target .ttbin as a .ttdelta.", &RunDeltaCommand),
+        std::make_tuple("apply", "<output-path> <base-path> <delta-path>...", "Applies a chain of .ttdelta files to their base .ttbin.", &RunApplyCommand),
+        std::make_tuple("verify", "<path>...", "Checks whole .ttbin files against their checksums.", &RunVerifyCommand),
+    };
+
+    const auto printUsage = [&kCommands]
+    {
+        std::fputs("Usage: TypeTreeRipper.Native <command> [arguments]\n\nCommands:\n", stderr);
+        for (const auto &[name, arguments, description, _] : kCommands)
+        {
+            std::fprintf(stderr, "  %s %s\n      %s\n", name, arguments, description);
+        }
+    };
+
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto commandName = std::string_view(argv[1]);
+    const auto arguments = std::span<char const *const>(argv + 2, argc - 2);
+
+    for (const auto &[name, _, description, command] : kCommands)
+    {
+        if (commandName != name)
+            continue;
+
+        try
+        {
+            return command(arguments);
+        }
+        catch (const std::exception &e)
+        {
+            std::fprintf(stderr, "error: %s\n", e.what());
+            return 1;
+        }
+    }
+
+    printUsage();
+    return 1;
+}
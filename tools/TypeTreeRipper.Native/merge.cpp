@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "commands.hpp"
+#include "output_file.hpp"
+#include "serialized_blob.hpp"
+
+//
+// Combines partial .ttbin files produced with TYPETREERIPPER_SHARD into the file an unsharded
+// dump would have produced. A shard contains one pass of trees per set of transfer flags dumped
+// (i.e. release, then editor), each holding the trees of its RuntimeTypeArray range in order.
+//
+// Tree references and shared subtrees are found again over the merged trees. The writer only fills in the node
+// fields it stores, so they are found over the same values and the merged file is byte for byte the unsharded one.
+//
+
+namespace
+{
+    struct ShardFile
+    {
+        std::string Path;
+        DumpedTypeTreeBinary Binary;
+
+        uint32_t GetRangeSize() const
+        {
+            return Binary.Shard->TypeIndexEnd - Binary.Shard->TypeIndexBegin;
+        }
+
+        uint32_t GetPassCount() const
+        {
+            return GetRangeSize() != 0 ? static_cast<uint32_t>(Binary.TypeTrees.size()) / GetRangeSize() : 0;
+        }
+    };
+
+    ShardFile ReadShard(char const *path)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        if (!input)
+            throw std::runtime_error(std::string("Failed to open ") + path);
+
+        ShardFile shard{ .Path = path, .Binary = {} };
+        internal::Read(input, shard.Binary);
+
+        if (!shard.Binary.Shard.has_value())
+            throw std::runtime_error(shard.Path + " is not a shard");
+
+        const auto &range = shard.Binary.Shard.value();
+        if (range.TypeIndexBegin > range.TypeIndexEnd || range.TypeIndexEnd > range.TypeCount)
+            throw std::runtime_error(shard.Path + " has an invalid type index range");
+
+        if (shard.GetRangeSize() != 0 && shard.Binary.TypeTrees.size() % shard.GetRangeSize() != 0)
+            throw std::runtime_error(shard.Path + " does not contain a whole number of passes over its type index range");
+
+        return shard;
+    }
+
+    // Moves nodes into the merged binary, re-interning their strings into its string table
+    void MoveNodes(std::vector<DumpedTypeTreeNode> &nodes, const DumpedTypeTreeStringTable &strings, DumpedTypeTreeStringTable &mergedStrings)
+    {
+        for (auto &node : nodes)
+        {
+            node.TypeStringID = mergedStrings.Intern(strings.Get(node.TypeStringID));
+            node.NameStringID = mergedStrings.Intern(strings.Get(node.NameStringID));
+        }
+    }
+
+    void ValidateHeaders(const ShardFile &reference, const ShardFile &shard)
+    {
+        const auto &expected = reference.Binary.Header;
+        const auto &actual = shard.Binary.Header;
+
+        if (actual.MajorRevision != expected.MajorRevision
+            || actual.MinorRevision != expected.MinorRevision
+            || actual.PatchRevision != expected.PatchRevision)
+        {
+            throw std::runtime_error(shard.Path + " was dumped from a different revision than " + reference.Path);
+        }
+
+        if (actual.Variant != expected.Variant)
+            throw std::runtime_error(shard.Path + " was dumped from a different variant than " + reference.Path);
+
+        if ((actual.Version == DumpedTypeTreeHeader::kVersion3) != (expected.Version == DumpedTypeTreeHeader::kVersion3))
+            throw std::runtime_error(shard.Path + " was written in a different layout than " + reference.Path);
+
+        if (shard.Binary.Shard->TypeCount != reference.Binary.Shard->TypeCount)
+            throw std::runtime_error(shard.Path + " was dumped from a different RuntimeTypeArray than " + reference.Path);
+
+        // Common string offsets are only meaningful against the buffer they were taken from
+        if ((actual.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings) != (expected.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings)
+            || shard.Binary.CommonStringBuffer != reference.Binary.CommonStringBuffer)
+        {
+            throw std::runtime_error(shard.Path + " has a different common string buffer than " + reference.Path);
+        }
+
+        constexpr auto kColumnFlags = DumpedTypeTreeHeader::kHeaderFlagByteOffsets | DumpedTypeTreeHeader::kHeaderFlagNavigation
+            | DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes | DumpedTypeTreeHeader::kHeaderFlagTypeHashes;
+        if ((actual.Flags & kColumnFlags) != (expected.Flags & kColumnFlags))
+            throw std::runtime_error(shard.Path + " was dumped with different node and tree column options than " + reference.Path);
+    }
+
+    // Ensures the shards cover [0, TypeCount) exactly once, reporting every overlap or gap.
+    void ValidateRanges(const std::vector<ShardFile> &shards)
+    {
+        std::string errors;
+        uint32_t expectedBegin = 0;
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            const auto &range = shards[i].Binary.Shard.value();
+
+            if (range.TypeIndexBegin < expectedBegin)
+            {
+                errors += "\n  " + shards[i].Path + " overlaps " + shards[i - 1].Path;
+            }
+            else if (range.TypeIndexBegin > expectedBegin)
+            {
+                errors += "\n  types " + std::to_string(expectedBegin) + " to " + std::to_string(range.TypeIndexBegin) + " are missing";
+            }
+
+            expectedBegin = std::max(expectedBegin, range.TypeIndexEnd);
+        }
+
+        if (const auto typeCount = shards.front().Binary.Shard->TypeCount; expectedBegin < typeCount)
+        {
+            errors += "\n  types " + std::to_string(expectedBegin) + " to " + std::to_string(typeCount) + " are missing";
+        }
+
+        if (!errors.empty())
+            throw std::runtime_error("Shards do not cover the type array exactly once:" + errors);
+    }
+
+    uint32_t GetPassCount(const std::vector<ShardFile> &shards)
+    {
+        std::optional<uint32_t> passCount;
+
+        for (const auto &shard : shards)
+        {
+            // Empty ranges carry no trees and therefore no information about the passes
+            if (shard.GetRangeSize() == 0)
+                continue;
+
+            if (passCount.has_value() && passCount.value() != shard.GetPassCount())
+                throw std::runtime_error(shard.Path + " contains a different number of passes than the other shards");
+
+            passCount = shard.GetPassCount();
+        }
+
+        return passCount.value_or(0);
+    }
+}
+
+int RunMergeCommand(const std::span<char const *const> arguments)
+{
+    if (arguments.size() < 2)
+    {
+        std::fputs("Usage: TypeTreeRipper.Native merge <output-path> <shard-path>...\n", stderr);
+        return 1;
+    }
+
+    std::vector<ShardFile> shards;
+    for (const auto path : arguments.subspan(1))
+    {
+        shards.push_back(ReadShard(path));
+        ValidateHeaders(shards.front(), shards.back());
+    }
+
+    std::ranges::sort(shards, {}, [](const ShardFile &shard)
+    {
+        return std::make_pair(shard.Binary.Shard->TypeIndexBegin, shard.Binary.Shard->TypeIndexEnd);
+    });
+
+    ValidateRanges(shards);
+
+    DumpedTypeTreeBinary merged{};
+    merged.Header = shards.front().Binary.Header;
+    merged.CommonStringBuffer = shards.front().Binary.CommonStringBuffer;
+
+    // Compressed shards are merged into a file compressed in blocks of the same size
+    merged.CompressionBlockSize = shards.front().Binary.CompressionBlockSize;
+
+    DumpedTypeTreeDeduplicator deduplicator;
+
+    // Both passes of a type are dumped with the same shard, so the shards hold tree references exactly when they were
+    // dumped with TYPETREERIPPER_DEDUPLICATE and have trees to deduplicate
+    const auto deduplicate = std::ranges::any_of(shards, [](const ShardFile &shard)
+    {
+        return (shard.Binary.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagTreeReferences) != 0;
+    });
+
+    // Emit pass by pass, and within a pass in RuntimeTypeArray order
+    const auto passCount = GetPassCount(shards);
+    for (uint32_t pass = 0; pass < passCount; pass++)
+    {
+        std::optional<uint64_t> passFlags;
+
+        for (auto &shard : shards)
+        {
+            const auto rangeSize = shard.GetRangeSize();
+            const auto begin = shard.Binary.TypeTrees.begin() + static_cast<ptrdiff_t>(pass) * rangeSize;
+
+            for (auto tree = begin; tree != begin + rangeSize; ++tree)
+            {
+                if (passFlags.has_value() && passFlags.value() != tree->TransferFlags)
+                    throw std::runtime_error(shard.Path + " contains a pass with mismatched transfer flags");
+
+                passFlags = tree->TransferFlags;
+                MoveNodes(tree->Nodes, shard.Binary.Strings, merged.Strings);
+                merged.TypeTrees.push_back(std::move(*tree));
+
+                if (deduplicate)
+                    deduplicator.AddLast(merged.TypeTrees);
+            }
+        }
+
+        // Scripting classes are only dumped with the first shard, after the types of each pass
+        for (auto &shard : shards)
+        {
+            for (auto &script : shard.Binary.Scripts)
+            {
+                if (script.Tree.TransferFlags != passFlags)
+                    continue;
+
+                MoveNodes(script.Tree.Nodes, shard.Binary.Strings, merged.Strings);
+                merged.Scripts.push_back(std::move(script));
+            }
+        }
+    }
+
+    // References were resolved when reading the shards, and are rebuilt against the merged tree order. Shared subtrees
+    // are found again over the trees of all shards.
+    merged.Header.Flags = deduplicator.GetHeaderFlags()
+        | (merged.Header.Flags & (DumpedTypeTreeHeader::kHeaderFlagStringTable | DumpedTypeTreeHeader::kHeaderFlagCommonStrings
+            | DumpedTypeTreeHeader::kHeaderFlagByteOffsets | DumpedTypeTreeHeader::kHeaderFlagNavigation
+            | DumpedTypeTreeHeader::kHeaderFlagSubtreeHashes | DumpedTypeTreeHeader::kHeaderFlagTypeHashes
+            | DumpedTypeTreeHeader::kHeaderFlagSubtreeReferences | DumpedTypeTreeHeader::kHeaderFlagTreeSets
+            | DumpedTypeTreeHeader::kHeaderFlagChecksums));
+
+    // Columnar shards are merged into a columnar file
+    if (merged.Header.Version != DumpedTypeTreeHeader::kVersion3)
+        merged.Header.Version = merged.Header.Flags != 0 ? DumpedTypeTreeHeader::kVersion2 : DumpedTypeTreeHeader::kVersion1;
+
+    // Shards only hold the hierarchy of their own types, so it is rebuilt over all of them
+    if (shards.front().Binary.Hierarchy.has_value())
+        merged.Hierarchy = BuildTypeHierarchy(merged.TypeTrees);
+
+    // Blob indices change with the merged tree order, so the blobs are rebuilt in the layouts the shards had
+    const auto useCommonStrings = (merged.Header.Flags & DumpedTypeTreeHeader::kHeaderFlagCommonStrings) != 0;
+    for (const auto &serializedBlobs : shards.front().Binary.SerializedBlobs)
+    {
+        merged.SerializedBlobs.push_back(BuildSerializedBlobs(serializedBlobs.FormatVersion, merged.TypeTrees, merged.Scripts,
+            merged.Strings, useCommonStrings));
+    }
+
+    OutputFile output(arguments[0]);
+    if (!output)
+        throw std::runtime_error(std::string("Failed to create ") + arguments[0]);
+
+    OutputBuffer buffer;
+    internal::Write(buffer, merged);
+
+    if (!output.Write(buffer))
+        throw std::runtime_error(std::string("Failed to write ") + arguments[0]);
+
+    std::printf("Merged %zu shards (%zu type trees) into %s\n", shards.size(), merged.TypeTrees.size(), arguments[0]);
+    return 0;
+}
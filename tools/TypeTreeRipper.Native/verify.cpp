@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "commands.hpp"
+
+//
+// Checks whole .ttbin files against the checksums written with TYPETREERIPPER_CHECKSUMS, e.g. after copying them,
+// without parsing them. Readers check the parts of a file they read on their own.
+//
+
+namespace
+{
+    // Read into 8-byte aligned memory, as version 3 files are viewed in place
+    std::vector<uint64_t> ReadFile(char const *path, size_t &size)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!input)
+            throw std::runtime_error(std::string("Failed to open ") + path);
+
+        size = static_cast<size_t>(input.tellg());
+        input.seekg(0);
+
+        std::vector<uint64_t> data((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        if (!input.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size)))
+            throw std::runtime_error(std::string("Failed to read ") + path);
+
+        return data;
+    }
+}
+
+int RunVerifyCommand(const std::span<char const *const> arguments)
+{
+    if (arguments.empty())
+    {
+        std::fputs("Usage: TypeTreeRipper.Native verify <path>...\n", stderr);
+        return 1;
+    }
+
+    auto failed = false;
+    for (const auto path : arguments)
+    {
+        try
+        {
+            size_t size;
+            const auto data = ReadFile(path, size);
+
+            const auto start = std::chrono::steady_clock::now();
+            VerifyChecksums({ reinterpret_cast<const char *>(data.data()), size });
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::printf("%s: OK, %zu bytes in %.1f ms (%.0f MB/s)\n", path, size, elapsed.count() * 1000,
+                static_cast<double>(size) / 1000000 / (std::max)(elapsed.count(), 1e-9));
+        }
+        catch (const std::exception &e)
+        {
+            std::printf("%s: %s\n", path, e.what());
+            failed = true;
+        }
+    }
+
+    return failed ? 1 : 0;
+}